@@ -16,6 +16,7 @@
 
 #include "IAMMediaStream.h"
 
+#undef LogDebug
 #define LogDebug Log
 
 HRESULT m_IAMMediaStream::QueryInterface(REFIID riid, LPVOID FAR * ppvObj)
@@ -23,6 +23,7 @@
 #include "DDrawCompat\DDrawCompatExternal.h"
 #include "DxWnd\DxWndExternal.h"
 #include "Utils\Utils.h"
+#include "Utils\WrapperAllocator.h"
 #include "Logging\Logging.h"
 // Wrappers last
 #include "IClassFactory\IClassFactory.h"
@@ -126,7 +127,12 @@ bool APIENTRY DllMain(HMODULE hModule, DWORD fdwReason, LPVOID lpReserved)
 
 		// Init logs
 		Logging::EnableLogging = !Config.DisableLogging;
+		Logging::EnableDebugLogging = !Config.DisableDebugLogging;
 		Logging::InitLog();
+		if (Config.AsyncLogging)
+		{
+			Logging::StartAsyncLog();
+		}
 		Logging::Log() << "Starting DxWrapper v" << APP_VERSION;
 		{
 			char path[MAX_PATH];
@@ -624,8 +630,12 @@ bool APIENTRY DllMain(HMODULE hModule, DWORD fdwReason, LPVOID lpReserved)
 			ReleaseMutex(n_hMutex);
 		}
 
+		// Log wrapper allocations
+		Utils::WrapperAllocator::LogStats();
+
 		// Final log
 		Logging::Log() << "DxWrapper terminated!";
+		Logging::StopAsyncLog();
 		break;
 	}
 	return true;
@@ -33,9 +33,225 @@
 #include <mmdeviceapi.h>
 #include "IClassFactory\IClassFactory.h"
 #include "Logging.h"
+#include <vector>
 
 std::ofstream LOG;
 
+bool Logging::EnableDebugLogging = true;
+
+namespace Logging
+{
+	// Stream buffer that hands log text to a background thread so the calling thread does not wait on the log file
+	class AsyncLogBuffer : public std::streambuf
+	{
+	private:
+		static constexpr size_t PutBufferSize = 4096;
+		static constexpr size_t WakeQueueSize = 64 * 1024;				// Wake the writer early once this much is queued
+		static constexpr size_t MaxQueueSize = 8 * 1024 * 1024;			// Drop log text once this much is queued
+		static constexpr DWORD WriteInterval = 100;
+
+		std::streambuf* FileBuffer = nullptr;
+		char PutBuffer[PutBufferSize];
+
+		CRITICAL_SECTION csQueue = {};
+		CRITICAL_SECTION csWrite = {};
+		HANDLE hWriteEvent = nullptr;
+		HANDLE hWriteThread = nullptr;
+		std::vector<char> Queue;
+		std::vector<char> WriteQueue;
+		DWORD DroppedCount = 0;
+		bool Exiting = false;
+
+		void QueuePutBuffer()
+		{
+			size_t Size = pptr() - pbase();
+			if (!Size)
+			{
+				return;
+			}
+
+			EnterCriticalSection(&csQueue);
+
+			if (Queue.size() + Size > MaxQueueSize)
+			{
+				DroppedCount++;
+			}
+			else
+			{
+				Queue.insert(Queue.end(), pbase(), pptr());
+			}
+
+			bool WakeWriter = (Queue.size() > WakeQueueSize);
+
+			LeaveCriticalSection(&csQueue);
+
+			setp(PutBuffer, PutBuffer + PutBufferSize);
+
+			if (WakeWriter)
+			{
+				SetEvent(hWriteEvent);
+			}
+		}
+
+		// Must be called while holding csWrite
+		void WriteQueued()
+		{
+			TakeQueued(WriteQueue);
+		}
+
+		// Moves the queued text to Buffer and writes it
+		void TakeQueued(std::vector<char>& Buffer)
+		{
+			DWORD Dropped = 0;
+
+			EnterCriticalSection(&csQueue);
+			Buffer.swap(Queue);
+			std::swap(Dropped, DroppedCount);
+			LeaveCriticalSection(&csQueue);
+
+			WriteToFile(Buffer, Dropped);
+		}
+
+		void WriteToFile(std::vector<char>& Buffer, DWORD Dropped)
+		{
+			if (Dropped)
+			{
+				char Message[80];
+				int Size = sprintf_s(Message, "Log queue full, dropped %u log writes\n", Dropped);
+				FileBuffer->sputn(Message, Size);
+			}
+			if (!Buffer.empty())
+			{
+				FileBuffer->sputn(Buffer.data(), Buffer.size());
+				FileBuffer->pubsync();
+				Buffer.clear();
+			}
+		}
+
+		static DWORD WINAPI WriterThread(LPVOID pvParam)
+		{
+			AsyncLogBuffer& Buffer = *(AsyncLogBuffer*)pvParam;
+
+			while (true)
+			{
+				WaitForSingleObject(Buffer.hWriteEvent, WriteInterval);
+
+				EnterCriticalSection(&Buffer.csWrite);
+
+				if (Buffer.Exiting)
+				{
+					LeaveCriticalSection(&Buffer.csWrite);
+					break;
+				}
+
+				Buffer.WriteQueued();
+
+				LeaveCriticalSection(&Buffer.csWrite);
+			}
+
+			return S_OK;
+		}
+
+	protected:
+		int overflow(int c) override
+		{
+			QueuePutBuffer();
+
+			if (!traits_type::eq_int_type(c, traits_type::eof()))
+			{
+				*pptr() = (char)c;
+				pbump(1);
+			}
+
+			return traits_type::not_eof(c);
+		}
+
+		int sync() override
+		{
+			QueuePutBuffer();
+
+			return 0;
+		}
+
+	public:
+		bool Start(std::streambuf* pFileBuffer)
+		{
+			FileBuffer = pFileBuffer;
+
+			InitializeCriticalSection(&csQueue);
+			InitializeCriticalSection(&csWrite);
+			hWriteEvent = CreateEvent(nullptr, FALSE, FALSE, nullptr);
+
+			hWriteThread = (hWriteEvent) ? CreateThread(nullptr, 0, WriterThread, this, 0, nullptr) : nullptr;
+			if (!hWriteThread)
+			{
+				return false;
+			}
+
+			setp(PutBuffer, PutBuffer + PutBufferSize);
+
+			return true;
+		}
+
+		void Stop()
+		{
+			QueuePutBuffer();
+
+			// Don't wait on the thread itself since this is called while holding the loader lock, the rest is written from this thread
+			// When the process is exiting the writer thread has already been terminated, possibly while holding a lock
+			if (WaitForSingleObject(hWriteThread, 0) == WAIT_OBJECT_0)
+			{
+				// No other thread is left, write both queues without locking
+				DWORD Dropped = 0;
+				std::swap(Dropped, DroppedCount);
+				WriteQueue.insert(WriteQueue.end(), Queue.begin(), Queue.end());
+				Queue.clear();
+
+				WriteToFile(WriteQueue, Dropped);
+
+				Exiting = true;
+			}
+			else
+			{
+				// The writer can be blocked in the file layer, so don't block on csWrite under the loader lock
+				bool IsLocked = false;
+				for (int x = 0; x < 50 && !IsLocked; x++)
+				{
+					IsLocked = (TryEnterCriticalSection(&csWrite) != FALSE);
+					if (!IsLocked)
+					{
+						Sleep(10);
+					}
+				}
+
+				if (IsLocked)
+				{
+					WriteQueued();
+
+					Exiting = true;
+
+					LeaveCriticalSection(&csWrite);
+				}
+				else
+				{
+					// Writer still holds csWrite, write the rest without it from a separate buffer so the log text is not lost
+					Exiting = true;
+
+					std::vector<char> StopQueue;
+					TakeQueued(StopQueue);
+				}
+
+				SetEvent(hWriteEvent);
+			}
+
+			CloseHandle(hWriteThread);
+			hWriteThread = nullptr;
+		}
+	};
+
+	AsyncLogBuffer* AsyncBuffer = nullptr;
+}
+
 // Get wrapper file name
 void Logging::InitLog()
 {
@@ -76,6 +292,47 @@ void Logging::InitLog()
 	Open(wrappername);
 }
 
+// Write the log file from a background thread
+void Logging::StartAsyncLog()
+{
+	if (AsyncBuffer || !LOG.is_open())
+	{
+		return;
+	}
+
+	AsyncBuffer = new AsyncLogBuffer;
+
+	if (!AsyncBuffer->Start(LOG.rdbuf()))
+	{
+		Log() << __FUNCTION__ << " Error: failed to start async logging!";
+
+		// Buffer is leaked on purpose, the writer thread may still reference it
+		AsyncBuffer = nullptr;
+
+		return;
+	}
+
+	LOG.std::ostream::rdbuf(AsyncBuffer);
+}
+
+// Write any queued log text and go back to writing the log file directly
+void Logging::StopAsyncLog()
+{
+	if (!AsyncBuffer)
+	{
+		return;
+	}
+
+	LOG.flush();
+
+	AsyncBuffer->Stop();
+
+	// Buffer is not deleted since the writer thread may not have exited yet
+	LOG.std::ostream::rdbuf(LOG.rdbuf());
+
+	AsyncBuffer = nullptr;
+}
+
 std::ostream& operator<<(std::ostream& os, const D3DFORMAT& format)
 {
 	switch ((DWORD)format)
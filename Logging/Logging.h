@@ -6,9 +6,20 @@
 
 namespace Logging
 {
+	extern bool EnableDebugLogging;
+
 	void InitLog();
+	void StartAsyncLog();
+	void StopAsyncLog();
+	inline void BeginLogDebug() {}
 }
 
+// Disabled debug logs cost a single branch, the log line and its arguments are skipped
+// Must be used at the start of a statement: Logging::LogDebug() << ...;
+#ifndef LogDebug
+#define LogDebug() BeginLogDebug(); if (!Logging::EnableDebugLogging) {} else Logging::LogDebug()
+#endif
+
 #pragma warning (disable: 26812)
 typedef enum _DDFOURCC {} DDFOURCC;
 typedef enum _DDERR {} DDERR;
@@ -0,0 +1,181 @@
+#pragma once
+
+// Case insensitive perfect hash of a fixed list of names, the table is built at compile time
+// Uses hash and displace: the name hash selects a bucket and the bucket's displacement selects a free slot
+namespace PerfectHash
+{
+	constexpr char ToLower(char c)
+	{
+		return (c >= 'A' && c <= 'Z') ? (char)(c - 'A' + 'a') : c;
+	}
+
+	// Case insensitive FNV-1a
+	constexpr DWORD Hash(const char* str)
+	{
+		DWORD h = 2166136261u;
+		for (; *str; str++)
+		{
+			h ^= (BYTE)ToLower(*str);
+			h *= 16777619u;
+		}
+		return h;
+	}
+
+	// Scrambles the name hash with a bucket displacement, so the slot search does not need to rehash the names
+	constexpr DWORD Mix(DWORD h, DWORD Displacement)
+	{
+		h ^= Displacement * 0x9E3779B9u;
+		h ^= h >> 16;
+		h *= 0x85EBCA6Bu;
+		h ^= h >> 13;
+		h *= 0xC2B2AE35u;
+		h ^= h >> 16;
+		return h;
+	}
+
+	constexpr bool IsEqual(const char* a, const char* b)
+	{
+		for (; *a && ToLower(*a) == ToLower(*b); a++, b++) {}
+		return ToLower(*a) == ToLower(*b);
+	}
+
+	constexpr size_t NextPowerOfTwo(size_t Value)
+	{
+		size_t Size = 1;
+		while (Size < Value)
+		{
+			Size <<= 1;
+		}
+		return Size;
+	}
+
+	template <size_t Count>
+	class Table
+	{
+	private:
+		static constexpr size_t Buckets = NextPowerOfTwo((Count + 3) / 4);		// About four names per bucket
+		static constexpr size_t Slots = NextPowerOfTwo(Count * 2);				// Keep the load below one half
+		static constexpr WORD EmptySlot = 0xFFFF;
+		static constexpr DWORD MaxDisplacement = 0x10000;
+
+		static_assert(Count < EmptySlot, "Too many names for the perfect hash table");
+
+		WORD Displacement[Buckets] = {};
+		WORD Index[Slots] = {};
+		bool Valid = false;
+
+	public:
+		// Names that are repeated only keep their first entry, same as comparing the names in order
+		constexpr Table(const char* const (&Names)[Count])
+		{
+			DWORD NameHash[Count] = {};
+			bool IsDuplicate[Count] = {};
+			size_t BucketStart[Buckets + 1] = {};
+			size_t BucketFill[Buckets] = {};
+			size_t BucketSize[Buckets] = {};
+			size_t BucketNames[Count] = {};
+			size_t MaxBucketSize = 0;
+
+			for (size_t x = 0; x < Slots; x++)
+			{
+				Index[x] = EmptySlot;
+			}
+
+			// Group the names by bucket, each bucket keeps the names in list order
+			for (size_t x = 0; x < Count; x++)
+			{
+				NameHash[x] = Hash(Names[x]);
+				BucketStart[(NameHash[x] & (Buckets - 1)) + 1]++;
+			}
+			for (size_t b = 0; b < Buckets; b++)
+			{
+				BucketStart[b + 1] += BucketStart[b];
+			}
+			for (size_t x = 0; x < Count; x++)
+			{
+				const size_t b = NameHash[x] & (Buckets - 1);
+				BucketNames[BucketStart[b] + BucketFill[b]++] = x;
+			}
+
+			// Repeated names always share a bucket
+			for (size_t b = 0; b < Buckets; b++)
+			{
+				for (size_t n = BucketStart[b]; n < BucketStart[b + 1]; n++)
+				{
+					const size_t x = BucketNames[n];
+					for (size_t m = BucketStart[b]; m < n && !IsDuplicate[x]; m++)
+					{
+						IsDuplicate[x] = (NameHash[x] == NameHash[BucketNames[m]] && IsEqual(Names[x], Names[BucketNames[m]]));
+					}
+					if (!IsDuplicate[x])
+					{
+						BucketSize[b]++;
+					}
+				}
+				if (BucketSize[b] > MaxBucketSize)
+				{
+					MaxBucketSize = BucketSize[b];
+				}
+			}
+
+			// Place the largest buckets first while most slots are still free
+			for (size_t Size = MaxBucketSize; Size > 0; Size--)
+			{
+				for (size_t b = 0; b < Buckets; b++)
+				{
+					if (BucketSize[b] != Size)
+					{
+						continue;
+					}
+
+					bool IsPlaced = false;
+					for (DWORD d = 0; d < MaxDisplacement && !IsPlaced; d++)
+					{
+						// Try to claim a free slot for every name in the bucket, undo the claims if any slot is taken
+						IsPlaced = true;
+						for (size_t n = BucketStart[b]; n < BucketStart[b + 1]; n++)
+						{
+							if (IsDuplicate[BucketNames[n]])
+							{
+								continue;
+							}
+							const size_t Slot = Mix(NameHash[BucketNames[n]], d) & (Slots - 1);
+							if (Index[Slot] != EmptySlot)
+							{
+								IsPlaced = false;
+								for (size_t m = BucketStart[b]; m < n; m++)
+								{
+									if (!IsDuplicate[BucketNames[m]])
+									{
+										Index[Mix(NameHash[BucketNames[m]], d) & (Slots - 1)] = EmptySlot;
+									}
+								}
+								break;
+							}
+							Index[Slot] = (WORD)BucketNames[n];
+						}
+						if (IsPlaced)
+						{
+							Displacement[b] = (WORD)d;
+						}
+					}
+					if (!IsPlaced)
+					{
+						return;
+					}
+				}
+			}
+			Valid = true;
+		}
+
+		constexpr bool IsValid() const { return Valid; }
+
+		// Returns the index of the name in Names, or Count if the name is not in the list
+		size_t Find(const char* Name, const char* const (&Names)[Count]) const
+		{
+			const DWORD h = Hash(Name);
+			const WORD x = Index[Mix(h, Displacement[h & (Buckets - 1)]) & (Slots - 1)];
+			return (x != EmptySlot && IsEqual(Name, Names[x])) ? x : Count;
+		}
+	};
+}
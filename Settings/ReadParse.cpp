@@ -24,7 +24,7 @@
 
 namespace Settings
 {
-	void EraseCppComments(char* str);
+	char* EraseCppComments(char* str);
 	bool IsValidSettings(char* name, char* value);
 }
 
@@ -81,19 +81,20 @@ bool Settings::IsValidSettings(char* name, char* value)
 	return true;
 }
 
-// Commented text is replaced with a space character
-void Settings::EraseCppComments(char* str)
+// Commented text on the line is replaced with a space character, returns the end of the line
+// A block comment that spans several lines joins the text before and after it into one line
+char* Settings::EraseCppComments(char* str)
 {
-	while ((str = strchr(str, '/')) != 0)
+	while (*str && *str != '\n')
 	{
-		if (str[1] == '/')
+		if (str[0] == '/' && str[1] == '/')
 		{
 			for (; ((*str != '\0') && (*str != '\n')); str++)
 			{
 				*str = '\x20';
 			}
 		}
-		else if (str[1] == '*')
+		else if (str[0] == '/' && str[1] == '*')
 		{
 			for (; ((*str != '\0') && ((str[0] != '*') || (str[1] != '/'))); str++)
 			{
@@ -102,24 +103,22 @@ void Settings::EraseCppComments(char* str)
 			if (*str)
 			{
 				*str++ = '\x20';
-				*str = '\x20';
+				*str++ = '\x20';
 			}
 		}
-		if (*str)
-		{
-			str++;
-		}
 		else
 		{
-			break;
+			str++;
 		}
 	}
+	return str;
 }
 
 // [sections] are ignored
 // escape characters NOT support 
 // double quotes NOT suppoted
 // Name/value delimiter is an equal sign or colon 
+// The buffer is modified in place, nothing is allocated
 // whitespace is removed from before and after both the name and value
 // characters considered to be whitespace:
 //  0x20 - space
@@ -127,10 +126,14 @@ void Settings::EraseCppComments(char* str)
 //	0x0D - carriage return
 void Settings::Parse(char* str, NV NameValueCallback)
 {
-	char *next_token = nullptr;
-	EraseCppComments(str);
-	for (str = strtok_s(str, "\n", &next_token); str; str = strtok_s(0, "\n", &next_token))
+	// Comments are erased while the lines are split so the file is only walked once
+	for (char* next_line = str; *str; str = next_line)
 	{
+		next_line = EraseCppComments(str);
+		if (*next_line)
+		{
+			*next_line++ = '\0';
+		}
 		if (*str == ';' || *str == '#')
 		{
 			continue; // skip INI style comments ( must be at start of line )
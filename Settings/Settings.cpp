@@ -17,6 +17,7 @@
 #include <regex>
 #include <algorithm>
 #include "Settings.h"
+#include "PerfectHash.h"
 #include "Dllmain\Dllmain.h"
 #include "Wrappers\wrapper.h"
 #include "Logging\Logging.h"
@@ -62,26 +63,32 @@ namespace Settings
 	visit(Force16bitColor) \
 	visit(Force32bitColor)
 
+#define SETTING_NAME(functionName) \
+	#functionName,
+
+#define LOCAL_ID(functionName) \
+	LOCAL_##functionName,
+
+#define CONFIG_ID(functionName) \
+	CONFIG_##functionName,
+
+#define APPCOMPATDATA_ID(functionName) \
+	APPCOMPATDATA_##functionName,
+
 #define SET_LOCAL_VALUE(functionName) \
-	if (!_stricmp(name, #functionName)) \
-	{ \
+	case LOCAL_##functionName: \
 		SetValue(name, value, &functionName); \
-		return; \
-	}
+		return;
 
 #define SET_VALUE(functionName) \
-	if (!_stricmp(name, #functionName)) \
-	{ \
+	case CONFIG_##functionName: \
 		SetValue(name, value, &Config.functionName); \
-		return; \
-	}
+		return;
 
 #define SET_APPCOMPATDATA_VALUE(functionName) \
-	if (!_stricmp(name, #functionName)) \
-	{ \
+	case APPCOMPATDATA_##functionName: \
 		SetValue(name, value, &Config.DXPrimaryEmulation[AppCompatDataType.functionName]); \
-		return; \
-	}
+		return;
 
 #define CLEAR_VALUE(functionName) \
 	ClearValue(&Config.functionName);
@@ -89,6 +96,40 @@ namespace Settings
 #define CLEAR_APPCOMPATDATA_VALUE(functionName) \
 	ClearValue(&Config.DXPrimaryEmulation[AppCompatDataType.functionName]);
 
+namespace Settings
+{
+	// Names of all settings, in the order they were compared before the hash table was used
+	constexpr const char* SettingNames[] = {
+		VISIT_LOCAL_SETTINGS(SETTING_NAME)
+		VISIT_CONFIG_SETTINGS(SETTING_NAME)
+		VISIT_APPCOMPATDATA_SETTINGS(SETTING_NAME)
+		"VerificationAddress",
+		"VerificationBytes",
+		"AddressPointer",
+		"BytesToWrite",
+	};
+
+	// Indexes into SettingNames
+	enum SETTINGID
+	{
+		VISIT_LOCAL_SETTINGS(LOCAL_ID)
+		VISIT_CONFIG_SETTINGS(CONFIG_ID)
+		VISIT_APPCOMPATDATA_SETTINGS(APPCOMPATDATA_ID)
+		MEMORY_VerificationAddress,
+		MEMORY_VerificationBytes,
+		MEMORY_AddressPointer,
+		MEMORY_BytesToWrite,
+		SETTINGID_COUNT
+	};
+
+	static_assert(SETTINGID_COUNT == ARRAYSIZE(SettingNames), "Setting names and ids are out of sync");
+
+	// LockColorkey is both a config and an AppCompatData setting, the config setting is found first
+	constexpr PerfectHash::Table<ARRAYSIZE(SettingNames)> SettingTable(SettingNames);
+
+	static_assert(SettingTable.IsValid(), "No perfect hash found for the setting names");
+}
+
 // Checks if a string value exists in a string array
 bool Settings::IfStringExistsInList(const char* szValue, std::vector<std::string> szList, bool CaseSensitive)
 {
@@ -273,42 +314,33 @@ void Settings::SetValue(char* name, char* value, bool* setting)
 // Set config from string (file)
 void __stdcall Settings::ParseCallback(char* name, char* value)
 {
+	const size_t SettingId = SettingTable.Find(name, SettingNames);
+
 	// Check for the existance of certian values
-	if (!_stricmp(name, "DisableMaxWindowedMode"))
+	if (SettingId == APPCOMPATDATA_DisableMaxWindowedMode)
 	{
 		Config.DisableMaxWindowedModeNotSet = false;
 	}
 
+	switch (SettingId)
+	{
 	// Set Value of local settings
 	VISIT_LOCAL_SETTINGS(SET_LOCAL_VALUE);
 
 	// Set Value of normal config settings
 	VISIT_CONFIG_SETTINGS(SET_VALUE);
 
-	// Set Value of AppCompatData LockColorkey setting
-	if (!_stricmp(name, "LockColorkey"))
-	{
-		SetValue(name, value, &Config.LockColorkey);
-		Config.DXPrimaryEmulation[AppCompatDataType.LockColorkey] = true;
-		return;
-	}
-
 	// Set Value of AppCompatData config settings
 	VISIT_APPCOMPATDATA_SETTINGS(SET_APPCOMPATDATA_VALUE);
 
 	// Set Value of Memory Hack config settings
-	if (!_stricmp(name, "VerificationAddress"))
-	{
+	case MEMORY_VerificationAddress:
 		SetValue(name, value, &Config.VerifyMemoryInfo.AddressPointer);
 		return;
-	}
-	if (!_stricmp(name, "VerificationBytes"))
-	{
+	case MEMORY_VerificationBytes:
 		SetValue(name, value, &Config.VerifyMemoryInfo);
 		return;
-	}
-	if (!_stricmp(name, "AddressPointer"))
-	{
+	case MEMORY_AddressPointer:
 		if (Config.MemoryInfo.size() < AddressPointerCount + 1)
 		{
 			MEMORYINFO newMemoryInfo;
@@ -316,9 +348,7 @@ void __stdcall Settings::ParseCallback(char* name, char* value)
 		}
 		SetValue(name, value, &Config.MemoryInfo[AddressPointerCount++].AddressPointer);
 		return;
-	}
-	if (!_stricmp(name, "BytesToWrite"))
-	{
+	case MEMORY_BytesToWrite:
 		if (Config.MemoryInfo.size() < BytesToWriteCount + 1)
 		{
 			MEMORYINFO newMemoryInfo;
@@ -29,6 +29,8 @@
 	visit(DdrawClippedHeight) \
 	visit(DdrawRemoveScanlines) \
 	visit(DdrawRemoveInterlacing) \
+	visit(DdrawCoalescePresents) \
+	visit(DdrawBatchPrimitives) \
 	visit(DdrawFixByteAlignment) \
 	visit(DdrawEmulateSurface) \
 	visit(DdrawReadFromGDI) \
@@ -56,6 +58,8 @@
 	visit(DisableGameUX) \
 	visit(DisableHighDPIScaling) \
 	visit(DisableLogging) \
+	visit(DisableDebugLogging) \
+	visit(AsyncLogging) \
 	visit(DirectShowEmulation) \
 	visit(DSoundCtrl) \
 	visit(DxWnd) \
@@ -74,6 +78,9 @@
 	visit(ForceMixedVertexProcessing) \
 	visit(ForceSystemMemVertexCache) \
 	visit(FilterNonActiveInput) \
+	visit(FilterRedundantStates) \
+	visit(AsyncFrontBufferCapture) \
+	visit(StreamHotVertexBuffers) \
 	visit(FixSpeakerConfigType) \
 	visit(ForceExclusiveMode) \
 	visit(ForceHardwareMixing) \
@@ -97,10 +104,12 @@
 	visit(LoadCustomDllPath) \
 	visit(LoadFromScriptsOnly) \
 	visit(LoadPlugins) \
+	visit(LoadPluginsDeferred) \
 	visit(LockColorkey) \
 	visit(LoopSleepTime) \
 	visit(Num2DBuffers) \
 	visit(Num3DBuffers) \
+	visit(PluginLoadOrder) \
 	visit(PrimaryBufferBits) \
 	visit(PrimaryBufferChannels) \
 	visit(PrimaryBufferSamples) \
@@ -208,6 +217,8 @@ struct CONFIG
 	DWORD DdrawResolutionHack = 0;				// Removes the artificial resolution limit from Direct3D7 and below https://github.com/UCyborg/LegacyD3DResolutionHack
 	bool DdrawRemoveScanlines = 0;				// Experimental feature to removing interlaced black lines in a single frame
 	bool DdrawRemoveInterlacing = 0;			// Experimental feature to removing interlacing between frames
+	bool DdrawCoalescePresents = false;			// Merges primary surface writes and presents at most once per refresh interval
+	bool DdrawBatchPrimitives = false;			// Merges consecutive DrawPrimitive calls with the same states into one draw
 	bool DdrawEmulateSurface = false;			// Emulates the ddraw surface using device context for Dd7to9
 	bool DdrawReadFromGDI = false;				// Read from GDI bfore passing surface to program
 	bool DdrawWriteToGDI = false;				// Blt surface directly to GDI rather than Direct3D9
@@ -236,6 +247,8 @@ struct CONFIG
 	bool DisableGameUX = false;					// Disables the Microsoft Game Explorer which can sometimes cause high CPU in rundll32.exe and hang the game process
 	bool DisableHighDPIScaling = false;			// Disables display scaling on high DPI settings
 	bool DisableLogging = false;				// Disables the logging file
+	bool DisableDebugLogging = false;			// Disables debug logs at runtime, each skipped debug log only costs a branch
+	bool AsyncLogging = false;					// Writes the logging file from a background thread
 	bool DSoundCtrl = false;					// Enables DirectSoundControl https://github.com/nRaecheR/DirectSoundControl
 	bool DxWnd = false;							// Enables DxWnd https://sourceforge.net/projects/dxwnd/
 	DWORD CacheClipPlane = 0;					// Caches the ClipPlane for Direct3D9 to fix an issue in d3d9 on Windows 8 and newer
@@ -251,6 +264,9 @@ struct CONFIG
 	bool ForceExclusiveFullscreen = false;		// Forces exclusive fullscreen mode in d3d9
 	bool ForceMixedVertexProcessing = false;	// Forces Mixed mode for vertex processing in d3d9
 	bool ForceSystemMemVertexCache = false;		// Forces System Memory caching for vertexes in d3d9
+	bool FilterRedundantStates = false;			// Drops d3d9 state calls that do not change the device state
+	bool AsyncFrontBufferCapture = false;		// Returns the previous frame from emulated GetFrontBufferData while the next one is captured on another thread
+	bool StreamHotVertexBuffers = false;		// Moves managed vertex buffers that are written every frame to dynamic buffers in d3d9
 	bool FullScreen = false;					// Sets the main window to fullscreen
 	bool FullscreenWindowMode = false;			// Enables fullscreen windowed mode, requires EnableWindowMode
 	bool ForceTermination = false;				// Terminates application when main window closes
@@ -261,6 +277,7 @@ struct CONFIG
 	bool isAppCompatDataSet = false;			// Flag that holds tells whether any of the AppCompatData flags are set
 	bool LoadPlugins = false;					// Loads ASI plugins
 	bool LoadFromScriptsOnly = false;			// Loads ASI plugins from 'scripts' and 'plugins' folder only
+	bool LoadPluginsDeferred = false;			// Loads ASI plugins on a thread that runs after DllMain returns
 	bool ProcessExcluded = false;				// Set if this process is excluded from dxwrapper functions
 	bool ResetScreenRes = false;				// Reset the screen resolution on close
 	bool SendAltEnter = false;					// Sends an Alt+Enter message to the wind to tell it to go into fullscreen, requires FullScreen
@@ -287,6 +304,7 @@ struct CONFIG
 	std::vector<std::string> SetNamedLayer;		// List of named layers to select for fullscreen
 	std::vector<std::string> IgnoreWindowName;	// List of window classes to ignore
 	std::vector<std::string> LoadCustomDllPath;	// List of custom dlls to load
+	std::vector<std::string> PluginLoadOrder;	// List of ASI plugins to load first, in order
 	std::vector<std::string> ExcludeProcess;	// List of excluded applications
 	std::vector<std::string> IncludeProcess;	// List of included applications
 
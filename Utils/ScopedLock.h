@@ -0,0 +1,62 @@
+#pragma once
+
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+
+namespace Utils
+{
+	// Holds a slim reader/writer lock in shared mode until the end of the scope
+	class ScopedSharedLock
+	{
+	private:
+		SRWLOCK& Lock;
+
+	public:
+		explicit ScopedSharedLock(SRWLOCK& SRWLock) : Lock(SRWLock) { AcquireSRWLockShared(&Lock); }
+		~ScopedSharedLock() { ReleaseSRWLockShared(&Lock); }
+		ScopedSharedLock(const ScopedSharedLock&) = delete;
+		ScopedSharedLock& operator=(const ScopedSharedLock&) = delete;
+	};
+
+	// Holds a slim reader/writer lock in exclusive mode until the end of the scope
+	class ScopedExclusiveLock
+	{
+	private:
+		SRWLOCK& Lock;
+
+	public:
+		explicit ScopedExclusiveLock(SRWLOCK& SRWLock) : Lock(SRWLock) { AcquireSRWLockExclusive(&Lock); }
+		~ScopedExclusiveLock() { ReleaseSRWLockExclusive(&Lock); }
+		ScopedExclusiveLock(const ScopedExclusiveLock&) = delete;
+		ScopedExclusiveLock& operator=(const ScopedExclusiveLock&) = delete;
+	};
+
+	// Recursive lock, can be entered again by the thread that holds it
+	class CriticalSection
+	{
+	private:
+		CRITICAL_SECTION cs;
+
+	public:
+		CriticalSection() { InitializeCriticalSection(&cs); }
+		~CriticalSection() { DeleteCriticalSection(&cs); }
+		CriticalSection(const CriticalSection&) = delete;
+		CriticalSection& operator=(const CriticalSection&) = delete;
+
+		void Enter() { EnterCriticalSection(&cs); }
+		void Leave() { LeaveCriticalSection(&cs); }
+	};
+
+	// Holds a critical section until the end of the scope
+	class ScopedCriticalSection
+	{
+	private:
+		CriticalSection& Lock;
+
+	public:
+		explicit ScopedCriticalSection(CriticalSection& cs) : Lock(cs) { Lock.Enter(); }
+		~ScopedCriticalSection() { Lock.Leave(); }
+		ScopedCriticalSection(const ScopedCriticalSection&) = delete;
+		ScopedCriticalSection& operator=(const ScopedCriticalSection&) = delete;
+	};
+}
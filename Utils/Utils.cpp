@@ -28,6 +28,7 @@
 
 #define WIN32_LEAN_AND_MEAN
 #include <Windows.h>
+#include <algorithm>
 #include <atlbase.h>
 #include <comdef.h>
 #include <comutil.h>
@@ -93,10 +94,21 @@ namespace Utils
 	FARPROC p_CreateProcessW = nullptr;
 	std::vector<type_dll> custom_dll;		// Used for custom dll's and asi plugins
 
+	// Guards custom_dll, plugins can be loaded on a separate thread
+	struct DLLLIST_LOCK
+	{
+		CRITICAL_SECTION cs;
+		DLLLIST_LOCK() { InitializeCriticalSection(&cs); }
+		~DLLLIST_LOCK() { DeleteCriticalSection(&cs); }
+	} DllListLock;
+
 	// Function declarations
 	DWORD_PTR GetProcessMask();
 	void InitializeASI(HMODULE hModule);
-	void FindFiles(WIN32_FIND_DATA*);
+	void FindFiles(const char* dir, std::vector<std::string>& PluginList);
+	void SortPlugins(std::vector<std::string>& PluginList);
+	void LoadPluginList(const std::vector<std::string>& PluginList, bool SetDirectory);
+	DWORD WINAPI LoadPluginsThread(LPVOID pvParam);
 	void *memmem(const void *l, size_t l_len, const void *s, size_t s_len);
 }
 
@@ -333,7 +345,9 @@ void Utils::AddHandleToVector(HMODULE dll, const char *name)
 		newCustom_dll.dll = dll;
 		newCustom_dll.name.assign((strrchr(name, '\\')) ? strrchr(name, '\\') + 1 : name);
 		newCustom_dll.fullname.assign(name);
+		EnterCriticalSection(&DllListLock.cs);
 		custom_dll.push_back(newCustom_dll);
+		LeaveCriticalSection(&DllListLock.cs);
 	}
 }
 
@@ -346,13 +360,20 @@ HMODULE Utils::LoadLibrary(const char *dllname, bool EnableLogging)
 	char path[MAX_PATH] = { 0 };
 
 	// Check if dll is already loaded
+	EnterCriticalSection(&DllListLock.cs);
 	for (size_t x = 0; x < custom_dll.size(); x++)
 	{
 		if (_stricmp(custom_dll[x].name.c_str(), dllname) == 0 || _stricmp(custom_dll[x].fullname.c_str(), dllname) == 0)
 		{
-			return custom_dll[x].dll;
+			dll = custom_dll[x].dll;
+			break;
 		}
 	}
+	LeaveCriticalSection(&DllListLock.cs);
+	if (dll)
+	{
+		return dll;
+	}
 
 	// Logging
 	if (EnableLogging)
@@ -431,73 +452,152 @@ void Utils::InitializeASI(HMODULE hModule)
 	p_InitializeASI();
 }
 
-// Find asi plugins to load
-void Utils::FindFiles(WIN32_FIND_DATA* fd)
+// Find asi plugins in a folder, the plugins are added to the list in the order they are found
+void Utils::FindFiles(const char* dir, std::vector<std::string>& PluginList)
 {
-	char dir[MAX_PATH] = { 0 };
-	GetCurrentDirectory(MAX_PATH, dir);
+	char search[MAX_PATH] = { 0 };
+	sprintf_s(search, "%s\\*.asi", dir);
 
-	HANDLE asiFile = FindFirstFile("*.asi", fd);
+	WIN32_FIND_DATA fd;
+	HANDLE asiFile = FindFirstFile(search, &fd);
 	if (asiFile != INVALID_HANDLE_VALUE)
 	{
 		do {
-			if (!(fd->dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY))
+			if (!(fd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY))
 			{
-				auto pos = strlen(fd->cFileName);
+				auto pos = strlen(fd.cFileName);
 
-				if (fd->cFileName[pos - 4] == '.' &&
-					(fd->cFileName[pos - 3] == 'a' || fd->cFileName[pos - 3] == 'A') &&
-					(fd->cFileName[pos - 2] == 's' || fd->cFileName[pos - 2] == 'S') &&
-					(fd->cFileName[pos - 1] == 'i' || fd->cFileName[pos - 1] == 'I'))
+				// The search also matches short names, so extensions such as '.asix' need to be skipped
+				if (pos > 4 && fd.cFileName[pos - 4] == '.' &&
+					(fd.cFileName[pos - 3] == 'a' || fd.cFileName[pos - 3] == 'A') &&
+					(fd.cFileName[pos - 2] == 's' || fd.cFileName[pos - 2] == 'S') &&
+					(fd.cFileName[pos - 1] == 'i' || fd.cFileName[pos - 1] == 'I'))
 				{
 					char path[MAX_PATH] = { 0 };
-					sprintf_s(path, "%s\\%s", dir, fd->cFileName);
-
-					auto h = LoadLibrary(path);
-					SetCurrentDirectory(dir); //in case asi switched it
-
-					if (h)
-					{
-						AddHandleToVector(h, path);
-						InitializeASI(h);
-					}
-					else
-					{
-						Logging::LogFormat("Unable to load '%s'. Error: %d", fd->cFileName, GetLastError());
-					}
+					sprintf_s(path, "%s\\%s", dir, fd.cFileName);
+					PluginList.push_back(path);
 				}
 			}
-		} while (FindNextFile(asiFile, fd));
+		} while (FindNextFile(asiFile, &fd));
 		FindClose(asiFile);
 	}
 }
 
+// Move the plugins listed in PluginLoadOrder to the front, in the listed order
+// Plugins that other plugins depend on can be listed first to make sure they are loaded before them
+void Utils::SortPlugins(std::vector<std::string>& PluginList)
+{
+	auto Next = PluginList.begin();
+	for (const std::string& name : Config.PluginLoadOrder)
+	{
+		for (auto it = Next; it != PluginList.end(); it++)
+		{
+			const char* filename = strrchr(it->c_str(), '\\') ? strrchr(it->c_str(), '\\') + 1 : it->c_str();
+			if (_stricmp(filename, name.c_str()) == 0)
+			{
+				std::rotate(Next, it, it + 1);
+				Next++;
+				break;
+			}
+		}
+	}
+}
+
+// Load and initialize each plugin, the load time of each plugin is logged
+void Utils::LoadPluginList(const std::vector<std::string>& PluginList, bool SetDirectory)
+{
+	LARGE_INTEGER Frequency = {}, StartTime = {}, EndTime = {};
+	QueryPerformanceFrequency(&Frequency);
+
+	for (const std::string& path : PluginList)
+	{
+		QueryPerformanceCounter(&StartTime);
+
+		// Plugins expect the current directory to be the folder they were loaded from
+		if (SetDirectory)
+		{
+			std::string dir(path, 0, path.find_last_of('\\'));
+			SetCurrentDirectory(dir.c_str());
+		}
+
+		auto h = LoadLibrary(path.c_str());
+
+		if (h)
+		{
+			AddHandleToVector(h, path.c_str());
+			InitializeASI(h);
+
+			QueryPerformanceCounter(&EndTime);
+			Logging::Log() << "Loaded plugin '" << path << "' in " << (EndTime.QuadPart - StartTime.QuadPart) * 1000.0 / Frequency.QuadPart << " ms";
+		}
+		else
+		{
+			Logging::LogFormat("Unable to load '%s'. Error: %d", path.c_str(), GetLastError());
+		}
+	}
+}
+
+// Load asi plugins after DllMain has returned
+DWORD WINAPI Utils::LoadPluginsThread(LPVOID pvParam)
+{
+	std::vector<std::string>* PluginList = (std::vector<std::string>*)pvParam;
+
+	// The current directory is shared with the application threads so it is left alone
+	LoadPluginList(*PluginList, false);
+
+	Logging::Log() << "Deferred ASI Plugins loaded";
+
+	delete PluginList;
+
+	// Release the reference that kept dxwrapper loaded while the thread was running
+	FreeLibraryAndExitThread(hModule_dll, 0);
+}
+
 // Load asi plugins
 void Utils::LoadPlugins()
 {
 	Logging::Log() << "Loading ASI Plugins";
 
-	char oldDir[MAX_PATH] = { 0 }; // store the current directory
-	GetCurrentDirectory(MAX_PATH, oldDir);
-
 	char selfPath[MAX_PATH] = { 0 };
 	GetModuleFileName(hModule_dll, selfPath, MAX_PATH);
 	*strrchr(selfPath, '\\') = '\0';
-	SetCurrentDirectory(selfPath);
 
-	WIN32_FIND_DATA fd;
+	// Gather the plugins first so that they can be ordered across all folders
+	std::vector<std::string> PluginList;
 	if (!Config.LoadFromScriptsOnly)
-		FindFiles(&fd);
+	{
+		FindFiles(selfPath, PluginList);
+	}
+	FindFiles((std::string(selfPath) + "\\scripts").c_str(), PluginList);
+	FindFiles((std::string(selfPath) + "\\plugins").c_str(), PluginList);
 
-	SetCurrentDirectory(selfPath);
+	SortPlugins(PluginList);
 
-	if (SetCurrentDirectory("scripts\\"))
-		FindFiles(&fd);
+	// Start the plugin thread, it cannot run until DllMain returns because thread startup waits on the loader lock
+	if (Config.LoadPluginsDeferred)
+	{
+		HMODULE dxwrapperhandle = nullptr;
+		if (GetModuleHandleEx(GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS, (LPCSTR)&LoadPluginsThread, &dxwrapperhandle))
+		{
+			std::vector<std::string>* ThreadPluginList = new std::vector<std::string>(std::move(PluginList));
+			HANDLE hThread = CreateThread(nullptr, 0, LoadPluginsThread, ThreadPluginList, 0, nullptr);
+			if (hThread)
+			{
+				Logging::Log() << "Deferring the load of " << ThreadPluginList->size() << " ASI Plugins";
+				CloseHandle(hThread);
+				return;
+			}
+			PluginList = std::move(*ThreadPluginList);
+			delete ThreadPluginList;
+			FreeLibrary(dxwrapperhandle);
+		}
+		Logging::Log() << "Failed to start the deferred plugin thread, loading ASI Plugins now";
+	}
 
-	SetCurrentDirectory(selfPath);
+	char oldDir[MAX_PATH] = { 0 }; // store the current directory
+	GetCurrentDirectory(MAX_PATH, oldDir);
 
-	if (SetCurrentDirectory("plugins\\"))
-		FindFiles(&fd);
+	LoadPluginList(PluginList, true);
 
 	SetCurrentDirectory(oldDir); // Reset the current directory
 }
@@ -509,12 +609,14 @@ void Utils::UnloadAllDlls()
 	Logging::Log() << "Unloading libraries...";
 
 	// Unload custom libraries
+	EnterCriticalSection(&DllListLock.cs);
 	while (custom_dll.size() != 0)
 	{
 		// Unload dll
 		FreeLibrary(custom_dll.back().dll);
 		custom_dll.pop_back();
 	}
+	LeaveCriticalSection(&DllListLock.cs);
 }
 
 HMEMORYMODULE Utils::LoadMemoryToDLL(LPVOID pMemory, DWORD Size)
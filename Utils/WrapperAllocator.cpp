@@ -0,0 +1,153 @@
+/**
+* Copyright (C) 2023 Elisha Riedlinger
+*
+* This software is  provided 'as-is', without any express  or implied  warranty. In no event will the
+* authors be held liable for any damages arising from the use of this software.
+* Permission  is granted  to anyone  to use  this software  for  any  purpose,  including  commercial
+* applications, and to alter it and redistribute it freely, subject to the following restrictions:
+*
+*   1. The origin of this software must not be misrepresented; you must not claim that you  wrote the
+*      original  software. If you use this  software  in a product, an  acknowledgment in the product
+*      documentation would be appreciated but is not required.
+*   2. Altered source versions must  be plainly  marked as such, and  must not be  misrepresented  as
+*      being the original software.
+*   3. This notice may not be removed or altered from any source distribution.
+*/
+
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#include <new>
+#include "WrapperAllocator.h"
+#include "Logging\Logging.h"
+
+namespace Utils
+{
+	namespace WrapperAllocator
+	{
+		constexpr size_t Granularity = 16;			// Also keeps the blocks aligned for SLIST_ENTRY on x64
+		constexpr size_t MaxBlockSize = 1024;		// Larger objects, such as devices and surfaces, are few and use the heap
+		constexpr size_t SizeClasses = MaxBlockSize / Granularity;
+		constexpr size_t SlabSize = 64 * 1024;		// Allocation granularity of VirtualAlloc
+		constexpr size_t QuarantineSize = 64;		// Freed blocks per size class that wait before they are reused, must be a power of two
+
+		static_assert(Granularity % MEMORY_ALLOCATION_ALIGNMENT == 0, "Blocks must be aligned for the free lists");
+		static_assert((QuarantineSize & (QuarantineSize - 1)) == 0, "Quarantine size must be a power of two");
+
+		// Each size class has its own lock free list, threads only touch the list of the size they allocate
+		// The free list is last in first out, so a freed block goes through the quarantine ring first. Otherwise the next wrapper
+		// of the same size would get the address that was just released, and a stale pointer the app still holds would pass the
+		// address lookup checks, such as IsValidWrapperAddress and CheckSurfaceExists, as the new wrapper
+		struct SIZECLASS
+		{
+			SLIST_HEADER FreeList;
+			void* volatile Quarantine[QuarantineSize];
+			volatile LONG QuarantineIndex;
+			volatile LONG Allocations;
+			volatile LONG Recycled;
+			volatile LONG Slabs;
+		};
+
+		// Zero initialized list headers are empty lists, so no setup is needed before the first wrapper is created
+		SIZECLASS SizeClass[SizeClasses] = {};
+		volatile LONG LargeAllocations = 0;
+
+		void* AllocateSlab(size_t Index);
+	}
+}
+
+// Carves a new slab into blocks, the first block is returned and the rest are added to the free list
+// Slabs are not returned to the system, the blocks are reused until the process exits
+void* Utils::WrapperAllocator::AllocateSlab(size_t Index)
+{
+	const size_t BlockSize = (Index + 1) * Granularity;
+
+	BYTE* pSlab = (BYTE*)VirtualAlloc(nullptr, SlabSize, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+	if (!pSlab)
+	{
+		throw std::bad_alloc();
+	}
+	InterlockedIncrement(&SizeClass[Index].Slabs);
+
+	for (size_t Offset = BlockSize; Offset + BlockSize <= SlabSize; Offset += BlockSize)
+	{
+		InterlockedPushEntrySList(&SizeClass[Index].FreeList, (PSLIST_ENTRY)(pSlab + Offset));
+	}
+
+	return pSlab;
+}
+
+void* Utils::WrapperAllocator::Allocate(size_t Size)
+{
+	if (Size == 0 || Size > MaxBlockSize)
+	{
+		InterlockedIncrement(&LargeAllocations);
+		return ::operator new(Size);
+	}
+
+	const size_t Index = (Size - 1) / Granularity;
+
+	InterlockedIncrement(&SizeClass[Index].Allocations);
+
+	void* ptr = InterlockedPopEntrySList(&SizeClass[Index].FreeList);
+	if (ptr)
+	{
+		InterlockedIncrement(&SizeClass[Index].Recycled);
+	}
+	else
+	{
+		ptr = AllocateSlab(Index);
+	}
+
+#ifdef _DEBUG
+	memset(ptr, 0xCD, Size);
+#endif
+
+	return ptr;
+}
+
+// Size must be the size passed to Allocate, wrappers have virtual destructors so sized delete gets the real object size
+void Utils::WrapperAllocator::Free(void* ptr, size_t Size)
+{
+	if (!ptr)
+	{
+		return;
+	}
+
+	if (Size == 0 || Size > MaxBlockSize)
+	{
+		::operator delete(ptr);
+		return;
+	}
+
+	const size_t Index = (Size - 1) / Granularity;
+
+#ifdef _DEBUG
+	// Catch use after release, the first bytes are overwritten by the free list link once the block leaves the quarantine
+	memset(ptr, 0xDD, (Index + 1) * Granularity);
+#endif
+
+	// The block takes the place of the oldest quarantined block, which is then added to the free list
+	const ULONG Slot = (ULONG)InterlockedIncrement(&SizeClass[Index].QuarantineIndex) & (QuarantineSize - 1);
+	void* pOldest = InterlockedExchangePointer((PVOID volatile*)&SizeClass[Index].Quarantine[Slot], ptr);
+	if (pOldest)
+	{
+		InterlockedPushEntrySList(&SizeClass[Index].FreeList, (PSLIST_ENTRY)pOldest);
+	}
+}
+
+void Utils::WrapperAllocator::LogStats()
+{
+	LONG Allocations = 0, Recycled = 0, Slabs = 0;
+	for (const SIZECLASS& Class : SizeClass)
+	{
+		Allocations += Class.Allocations;
+		Recycled += Class.Recycled;
+		Slabs += Class.Slabs;
+	}
+
+	if (Allocations || LargeAllocations)
+	{
+		Logging::Log() << "Wrapper allocator: " << Allocations << " allocations, " << Recycled << " recycled, " <<
+			Slabs << " slabs (" << (Slabs * SlabSize / 1024) << " KB), " << LargeAllocations << " large allocations";
+	}
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+namespace Utils
+{
+	// Allocator for the COM wrapper objects, which are created and released many times per frame by some games
+	// Blocks are kept in free lists by size class and reused, so wrapper churn does not go through the heap
+	// Freed blocks are held back for a while before reuse, so a released wrapper's address is not handed out again right away
+	namespace WrapperAllocator
+	{
+		void* Allocate(size_t Size);
+		void Free(void* ptr, size_t Size);
+		void LogStats();
+	}
+}
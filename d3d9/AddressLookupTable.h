@@ -2,6 +2,8 @@
 
 #include <unordered_map>
 #include <algorithm>
+#include "Utils\ScopedLock.h"
+#include "Utils\WrapperAllocator.h"
 
 constexpr UINT MaxIndex = 16;
 
@@ -75,12 +77,18 @@ public:
 			return nullptr;
 		}
 
-		constexpr UINT CacheIndex = AddressCacheIndex<T>::CacheIndex;
-		auto it = g_map[CacheIndex].find(Proxy);
+		T *Wrapper = FindWrapper<T>(Proxy);
+		if (Wrapper)
+		{
+			return Wrapper;
+		}
 
-		if (it != std::end(g_map[CacheIndex]))
+		// Check again while holding the create lock, another thread may have wrapped the proxy in the meantime
+		Utils::ScopedCriticalSection Lock(CreateLock);
+		Wrapper = FindWrapper<T>(Proxy);
+		if (Wrapper)
 		{
-			return static_cast<T *>(it->second);
+			return Wrapper;
 		}
 
 		if (riid == IID_IUnknown)
@@ -99,7 +107,22 @@ public:
 		constexpr UINT CacheIndex = AddressCacheIndex<T>::CacheIndex;
 		if (Wrapper && Proxy)
 		{
+			Utils::ScopedExclusiveLock Lock(g_lock[CacheIndex]);
+
+			// Remove stale entries so both maps stay one-to-one
+			auto it = g_map[CacheIndex].find(Proxy);
+			if (it != std::end(g_map[CacheIndex]))
+			{
+				g_reverse[CacheIndex].erase(it->second);
+			}
+			auto rit = g_reverse[CacheIndex].find(Wrapper);
+			if (rit != std::end(g_reverse[CacheIndex]))
+			{
+				g_map[CacheIndex].erase(rit->second);
+			}
+
 			g_map[CacheIndex][Proxy] = Wrapper;
+			g_reverse[CacheIndex][Wrapper] = Proxy;
 		}
 	}
 
@@ -112,19 +135,38 @@ public:
 		}
 
 		constexpr UINT CacheIndex = AddressCacheIndex<T>::CacheIndex;
-		auto it = std::find_if(g_map[CacheIndex].begin(), g_map[CacheIndex].end(),
-			[=](auto Map) -> bool { return Map.second == Wrapper; });
+		Utils::ScopedExclusiveLock Lock(g_lock[CacheIndex]);
+		auto it = g_reverse[CacheIndex].find(Wrapper);
 
-		if (it != std::end(g_map[CacheIndex]))
+		if (it != std::end(g_reverse[CacheIndex]))
 		{
-			it = g_map[CacheIndex].erase(it);
+			g_map[CacheIndex].erase(it->second);
+			g_reverse[CacheIndex].erase(it);
 		}
 	}
 
 private:
+	template <typename T>
+	T *FindWrapper(void *Proxy)
+	{
+		constexpr UINT CacheIndex = AddressCacheIndex<T>::CacheIndex;
+		Utils::ScopedSharedLock Lock(g_lock[CacheIndex]);
+		auto it = g_map[CacheIndex].find(Proxy);
+
+		if (it != std::end(g_map[CacheIndex]))
+		{
+			return static_cast<T *>(it->second);
+		}
+
+		return nullptr;
+	}
+
 	bool ConstructorFlag = false;
 	D *const pDevice;
 	std::unordered_map<void*, class AddressLookupTableD3d9Object*> g_map[MaxIndex];
+	std::unordered_map<class AddressLookupTableD3d9Object*, void*> g_reverse[MaxIndex];
+	SRWLOCK g_lock[MaxIndex] = {};			// Guards g_map and g_reverse, each cache index has its own lock
+	Utils::CriticalSection CreateLock;		// Recursive because wrapper constructors can create other wrappers
 };
 
 class AddressLookupTableD3d9Object
@@ -132,6 +174,10 @@ class AddressLookupTableD3d9Object
 public:
 	virtual ~AddressLookupTableD3d9Object() {}
 
+	// Wrappers are created and released often, so they are allocated from recycled blocks
+	static void* operator new(size_t Size) { return Utils::WrapperAllocator::Allocate(Size); }
+	static void operator delete(void* ptr, size_t Size) { Utils::WrapperAllocator::Free(ptr, Size); }
+
 	void DeleteMe()
 	{
 		delete this;
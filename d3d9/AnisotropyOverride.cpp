@@ -0,0 +1,207 @@
+/**
+* Copyright (C) 2023 Elisha Riedlinger
+*
+* This software is  provided 'as-is', without any express  or implied  warranty. In no event will the
+* authors be held liable for any damages arising from the use of this software.
+* Permission  is granted  to anyone  to use  this software  for  any  purpose,  including  commercial
+* applications, and to alter it and redistribute it freely, subject to the following restrictions:
+*
+*   1. The origin of this software must not be misrepresented; you must not claim that you  wrote the
+*      original  software. If you use this  software  in a product, an  acknowledgment in the product
+*      documentation would be appreciated but is not required.
+*   2. Altered source versions must  be plainly  marked as such, and  must not be  misrepresented  as
+*      being the original software.
+*   3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "d3d9.h"
+
+void AnisotropyOverride::LogCounters()
+{
+	if (!DrawCount)
+	{
+		return;
+	}
+
+	Logging::Log() << "Anisotropic filters changed: " << FilterCount << " over " << DrawCount << " draws";
+}
+
+void AnisotropyOverride::Enable(LPDIRECT3DDEVICE9 pDevice, DWORD Anisotropy, const D3DCAPS9& Caps)
+{
+	MaxAnisotropy = Anisotropy;
+	TextureFilterCaps = Caps.TextureFilterCaps;
+	VolumeTextureFilterCaps = Caps.VolumeTextureFilterCaps;
+	CubeTextureFilterCaps = Caps.CubeTextureFilterCaps;
+
+	if (MaxAnisotropy)
+	{
+		// Filters that cannot be read from the device start at the Direct3D9 default
+		for (DWORD x = 0; x < MaxSamplers; x++)
+		{
+			for (int f = FILTER_MIN; f < FILTER_MAX; f++)
+			{
+				Samplers[x].AppFilter[f] = D3DTEXF_POINT;
+				Samplers[x].DeviceFilter[f] = UnknownFilter;
+				Samplers[x].IsKnown[f] = false;
+			}
+		}
+		DirtyMask = 0;
+
+		Reload(pDevice);
+	}
+}
+
+void AnisotropyOverride::Reload(LPDIRECT3DDEVICE9 pDevice)
+{
+	for (DWORD x = 0; x < MaxSamplers; x++)
+	{
+		// Pure devices cannot be queried, in that case the filters are left alone until the application sets them
+		for (int f = FILTER_MIN; f < FILTER_MAX; f++)
+		{
+			DWORD Value = 0;
+			if (SUCCEEDED(pDevice->GetSamplerState(x, (f == FILTER_MIN) ? D3DSAMP_MINFILTER : D3DSAMP_MAGFILTER, &Value)))
+			{
+				// Only filters that the state block changed are taken as the application's, the others still hold the application's filter from BeginCapture
+				if (Value != Samplers[x].DeviceFilter[f])
+				{
+					Samplers[x].AppFilter[f] = Value;
+					Samplers[x].DeviceFilter[f] = Value;
+				}
+				Samplers[x].IsKnown[f] = true;
+				DirtyMask |= 1 << x;
+			}
+			else
+			{
+				Samplers[x].DeviceFilter[f] = UnknownFilter;
+				Samplers[x].IsKnown[f] = false;
+			}
+		}
+
+		IDirect3DBaseTexture9* pTexture = nullptr;
+		if (SUCCEEDED(pDevice->GetTexture(x, &pTexture)))
+		{
+			Samplers[x].FilterCaps = GetTextureFilterCaps(x, pTexture);
+			if (pTexture)
+			{
+				pTexture->Release();
+			}
+		}
+
+		// Max anisotropy does not depend on the filter, the application's value is always replaced
+		pDevice->SetSamplerState(x, D3DSAMP_MAXANISOTROPY, MaxAnisotropy);
+	}
+}
+
+void AnisotropyOverride::BeginCapture(LPDIRECT3DDEVICE9 pDevice)
+{
+	for (DWORD x = 0; x < MaxSamplers; x++)
+	{
+		for (int f = FILTER_MIN; f < FILTER_MAX; f++)
+		{
+			if (Samplers[x].IsKnown[f] && Samplers[x].AppFilter[f] != Samplers[x].DeviceFilter[f] &&
+				SUCCEEDED(pDevice->SetSamplerState(x, (f == FILTER_MIN) ? D3DSAMP_MINFILTER : D3DSAMP_MAGFILTER, Samplers[x].AppFilter[f])))
+			{
+				Samplers[x].DeviceFilter[f] = Samplers[x].AppFilter[f];
+			}
+		}
+	}
+}
+
+DWORD AnisotropyOverride::GetTextureFilterCaps(DWORD Stage, IDirect3DBaseTexture9* pTexture)
+{
+	const DWORD AllCaps = D3DPTFILTERCAPS_MINFANISOTROPIC | D3DPTFILTERCAPS_MAGFANISOTROPIC;
+
+	// Anisotropic filtering is only limited for multi-stage textures
+	if (!pTexture || Stage == 0)
+	{
+		return AllCaps;
+	}
+
+	switch (pTexture->GetType())
+	{
+	case D3DRTYPE_TEXTURE:
+		return TextureFilterCaps & AllCaps;
+	case D3DRTYPE_VOLUMETEXTURE:
+		return VolumeTextureFilterCaps & AllCaps;
+	case D3DRTYPE_CUBETEXTURE:
+		return CubeTextureFilterCaps & AllCaps;
+	default:
+		return AllCaps;
+	}
+}
+
+DWORD AnisotropyOverride::GetEffectiveFilter(const SAMPLER& Sampler, int Filter)
+{
+	const DWORD Value = Sampler.AppFilter[Filter];
+
+	if (Value == D3DTEXF_LINEAR || Value == D3DTEXF_ANISOTROPIC)
+	{
+		const DWORD Cap = (Filter == FILTER_MIN) ? D3DPTFILTERCAPS_MINFANISOTROPIC : D3DPTFILTERCAPS_MAGFANISOTROPIC;
+		return (Sampler.FilterCaps & Cap) ? D3DTEXF_ANISOTROPIC : D3DTEXF_LINEAR;
+	}
+
+	return Value;
+}
+
+DWORD AnisotropyOverride::GetSamplerState(DWORD Sampler, D3DSAMPLERSTATETYPE Type)
+{
+	return Samplers[Sampler].AppFilter[GetFilterIndex(Type)];
+}
+
+void AnisotropyOverride::SetSamplerState(DWORD Sampler, D3DSAMPLERSTATETYPE Type, DWORD Value)
+{
+	Samplers[Sampler].AppFilter[GetFilterIndex(Type)] = Value;
+	Samplers[Sampler].IsKnown[GetFilterIndex(Type)] = true;
+	DirtyMask |= 1 << Sampler;
+}
+
+void AnisotropyOverride::SetTexture(DWORD Stage, IDirect3DBaseTexture9* pTexture)
+{
+	if (Stage >= MaxSamplers)
+	{
+		return;
+	}
+
+	const DWORD FilterCaps = GetTextureFilterCaps(Stage, pTexture);
+	if (Samplers[Stage].FilterCaps != FilterCaps)
+	{
+		Samplers[Stage].FilterCaps = FilterCaps;
+		DirtyMask |= 1 << Stage;
+	}
+}
+
+void AnisotropyOverride::Apply(LPDIRECT3DDEVICE9 pDevice)
+{
+	DrawCount++;
+
+	for (DWORD x = 0; DirtyMask; x++)
+	{
+		if (!(DirtyMask & (1 << x)))
+		{
+			continue;
+		}
+		DirtyMask &= ~(1 << x);
+
+		for (int f = FILTER_MIN; f < FILTER_MAX; f++)
+		{
+			if (!Samplers[x].IsKnown[f])
+			{
+				continue;
+			}
+
+			const DWORD Value = GetEffectiveFilter(Samplers[x], f);
+			if (Value != Samplers[x].DeviceFilter[f] &&
+				SUCCEEDED(pDevice->SetSamplerState(x, (f == FILTER_MIN) ? D3DSAMP_MINFILTER : D3DSAMP_MAGFILTER, Value)))
+			{
+				Samplers[x].DeviceFilter[f] = Value;
+				FilterCount++;
+
+				if (Value == D3DTEXF_ANISOTROPIC && !IsLogged)
+				{
+					IsLogged = true;
+					Logging::Log() << "Setting Anisotropic Filtering at " << MaxAnisotropy << "x";
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+// Anisotropic filtering override, keeps the filters set by the application and the filters set on the device
+// Linear filters are changed to anisotropic at draw time, only for the samplers whose filter changes
+class AnisotropyOverride
+{
+private:
+	static constexpr DWORD MaxSamplers = 16;
+	static constexpr DWORD UnknownFilter = (DWORD)-1;
+
+	enum { FILTER_MIN, FILTER_MAG, FILTER_MAX };
+
+	struct SAMPLER
+	{
+		DWORD AppFilter[FILTER_MAX];			// Filters set by the application
+		DWORD DeviceFilter[FILTER_MAX];			// Filters set on the device
+		bool IsKnown[FILTER_MAX];				// Set once the application's filter was read from the device or set by the application
+		DWORD FilterCaps;						// Anisotropic filter caps for the texture bound to the stage
+	};
+
+	DWORD MaxAnisotropy = 0;
+	DWORD TextureFilterCaps = 0;
+	DWORD VolumeTextureFilterCaps = 0;
+	DWORD CubeTextureFilterCaps = 0;
+	SAMPLER Samplers[MaxSamplers] = {};
+	DWORD DirtyMask = 0;
+	bool IsLogged = false;
+
+	// Counters
+	ULONGLONG DrawCount = 0;
+	ULONGLONG FilterCount = 0;
+
+	static int GetFilterIndex(D3DSAMPLERSTATETYPE Type) { return (Type == D3DSAMP_MINFILTER) ? FILTER_MIN : (Type == D3DSAMP_MAGFILTER) ? FILTER_MAG : -1; }
+	DWORD GetTextureFilterCaps(DWORD Stage, IDirect3DBaseTexture9* pTexture);
+	DWORD GetEffectiveFilter(const SAMPLER& Sampler, int Filter);
+
+public:
+	~AnisotropyOverride() { LogCounters(); }
+
+	bool IsEnabled() { return MaxAnisotropy != 0; }
+	DWORD GetMaxAnisotropy() { return MaxAnisotropy; }
+	void LogCounters();
+
+	// Enabled once the device caps are known, the current filters and textures are read from the device
+	void Enable(LPDIRECT3DDEVICE9 pDevice, DWORD Anisotropy, const D3DCAPS9& Caps);
+	void Disable() { MaxAnisotropy = 0; }
+
+	// Reads the filters and textures back after a state block was applied, BeginCapture must be called before the apply
+	void Reload(LPDIRECT3DDEVICE9 pDevice);
+
+	// Puts the application's filters on the device, so state blocks capture them and applying a state block does not read back the override
+	void BeginCapture(LPDIRECT3DDEVICE9 pDevice);
+	void EndCapture() { DirtyMask = (1 << MaxSamplers) - 1; }
+
+	// Min and mag filters of pixel samplers are kept here and not sent to the device until the next draw
+	bool IsShadowed(DWORD Sampler, D3DSAMPLERSTATETYPE Type) { return IsEnabled() && Sampler < MaxSamplers && GetFilterIndex(Type) != -1; }
+	DWORD GetSamplerState(DWORD Sampler, D3DSAMPLERSTATETYPE Type);
+	void SetSamplerState(DWORD Sampler, D3DSAMPLERSTATETYPE Type, DWORD Value);
+	void SetTexture(DWORD Stage, IDirect3DBaseTexture9* pTexture);
+
+	void Apply(LPDIRECT3DDEVICE9 pDevice);
+};
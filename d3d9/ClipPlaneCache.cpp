@@ -0,0 +1,140 @@
+/**
+* Copyright (C) 2023 Elisha Riedlinger
+*
+* This software is  provided 'as-is', without any express  or implied  warranty. In no event will the
+* authors be held liable for any damages arising from the use of this software.
+* Permission  is granted  to anyone  to use  this software  for  any  purpose,  including  commercial
+* applications, and to alter it and redistribute it freely, subject to the following restrictions:
+*
+*   1. The origin of this software must not be misrepresented; you must not claim that you  wrote the
+*      original  software. If you use this  software  in a product, an  acknowledgment in the product
+*      documentation would be appreciated but is not required.
+*   2. Altered source versions must  be plainly  marked as such, and  must not be  misrepresented  as
+*      being the original software.
+*   3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "d3d9.h"
+
+void ClipPlaneCache::Reset()
+{
+	// Reset restores the default state, all planes are zero and disabled
+	ZeroMemory(Planes, sizeof(Planes));
+	EnableMask = 0;
+	SetMask = 0;
+	DirtyMask = 0;
+	IsShaderSet = false;
+}
+
+void ClipPlaneCache::LogCounters()
+{
+	if (!Enabled)
+	{
+		return;
+	}
+
+	Logging::Log() << "Clip planes sent: " << PlaneCount << " over " << DrawCount << " draws";
+}
+
+HRESULT ClipPlaneCache::GetClipPlane(DWORD Index, float* pPlane)
+{
+	if (!pPlane || Index >= MaxClipPlanes)
+	{
+		return D3DERR_INVALIDCALL;
+	}
+
+	memcpy(pPlane, Planes[Index], sizeof(Planes[0]));
+
+	return D3D_OK;
+}
+
+HRESULT ClipPlaneCache::SetClipPlane(DWORD Index, const float* pPlane)
+{
+	if (!pPlane || Index >= MaxClipPlanes)
+	{
+		return D3DERR_INVALIDCALL;
+	}
+
+	if ((SetMask & (1 << Index)) && memcmp(Planes[Index], pPlane, sizeof(Planes[0])) == 0)
+	{
+		return D3D_OK;
+	}
+
+	memcpy(Planes[Index], pPlane, sizeof(Planes[0]));
+	SetMask |= 1 << Index;
+	DirtyMask |= 1 << Index;
+
+	return D3D_OK;
+}
+
+void ClipPlaneCache::SetEnableMask(DWORD Mask)
+{
+	// Disabled planes stay dirty, so they are sent at the first draw after they are enabled
+	EnableMask = Mask & AllPlanes;
+}
+
+void ClipPlaneCache::SetTransform(D3DTRANSFORMSTATETYPE State)
+{
+	if (!IsShaderSet && (State == D3DTS_VIEW || State == D3DTS_PROJECTION))
+	{
+		Invalidate();
+	}
+}
+
+void ClipPlaneCache::SetVertexShader(bool IsSet)
+{
+	if (IsShaderSet != IsSet)
+	{
+		IsShaderSet = IsSet;
+		Invalidate();
+	}
+}
+
+void ClipPlaneCache::Reload(LPDIRECT3DDEVICE9 pDevice)
+{
+	// Pure devices cannot be queried, in that case the cached planes are sent again
+	for (DWORD x = 0; x < MaxClipPlanes; x++)
+	{
+		pDevice->GetClipPlane(x, Planes[x]);
+	}
+	DWORD Mask = 0;
+	if (SUCCEEDED(pDevice->GetRenderState(D3DRS_CLIPPLANEENABLE, &Mask)))
+	{
+		EnableMask = Mask & AllPlanes;
+	}
+	IDirect3DVertexShader9* pShader = nullptr;
+	if (SUCCEEDED(pDevice->GetVertexShader(&pShader)))
+	{
+		IsShaderSet = (pShader != nullptr);
+		if (pShader)
+		{
+			pShader->Release();
+		}
+	}
+	SetMask = AllPlanes;
+	Invalidate();
+}
+
+void ClipPlaneCache::Apply(LPDIRECT3DDEVICE9 pDevice, bool AllDirtyPlanes)
+{
+	if (!AllDirtyPlanes)
+	{
+		DrawCount++;
+	}
+
+	DWORD Mask = (AllDirtyPlanes) ? DirtyMask : DirtyMask & EnableMask;
+	if (!Mask)
+	{
+		return;
+	}
+
+	for (DWORD x = 0; x < MaxClipPlanes; x++)
+	{
+		if (Mask & (1 << x))
+		{
+			pDevice->SetClipPlane(x, Planes[x]);
+			PlaneCount++;
+		}
+	}
+	DirtyMask &= ~Mask;
+}
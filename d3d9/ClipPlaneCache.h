@@ -0,0 +1,51 @@
+#pragma once
+
+// Clip planes for CacheClipPlane, planes are sent to the device at draw time only when the device copy is out of date
+class ClipPlaneCache
+{
+private:
+	static constexpr DWORD MaxClipPlanes = 6;
+	static constexpr DWORD AllPlanes = (1 << MaxClipPlanes) - 1;
+
+	bool Enabled = false;
+	bool IsRecording = false;
+	bool IsShaderSet = false;	// Planes are in clip space when a vertex shader is set and in world space otherwise
+
+	float Planes[MaxClipPlanes][4] = {};
+	DWORD EnableMask = 0;		// D3DRS_CLIPPLANEENABLE
+	DWORD SetMask = 0;			// Planes set since the device was created or reset
+	DWORD DirtyMask = 0;		// Planes that need to be sent before the next draw
+
+	// Counters
+	ULONGLONG DrawCount = 0;
+	ULONGLONG PlaneCount = 0;
+
+	void Invalidate() { DirtyMask = SetMask; }
+
+public:
+	ClipPlaneCache(bool IsEnabled) : Enabled(IsEnabled) {}
+	~ClipPlaneCache() { LogCounters(); }
+
+	bool IsEnabled() { return Enabled; }
+	void Reset();
+	void LogCounters();
+
+	// Set* calls made while a state block is recorded are passed to the device and do not change the current state
+	void BeginRecording() { IsRecording = true; }
+	void EndRecording() { IsRecording = false; }
+	bool IsRecordingStateBlock() { return IsRecording; }
+
+	HRESULT GetClipPlane(DWORD Index, float* pPlane);
+	HRESULT SetClipPlane(DWORD Index, const float* pPlane);
+	void SetEnableMask(DWORD Mask);
+
+	// The device transforms fixed function planes with the current matrices, so they are sent again after a transform changes
+	void SetTransform(D3DTRANSFORMSTATETYPE State);
+	void SetVertexShader(bool IsSet);
+
+	// Reads the planes back after a state block was applied, the state block may have changed them
+	void Reload(LPDIRECT3DDEVICE9 pDevice);
+
+	// Sends the dirty planes, only planes that are enabled unless AllDirtyPlanes is set
+	void Apply(LPDIRECT3DDEVICE9 pDevice, bool AllDirtyPlanes = false);
+};
@@ -0,0 +1,244 @@
+/**
+* Copyright (C) 2023 Elisha Riedlinger
+*
+* This software is  provided 'as-is', without any express  or implied  warranty. In no event will the
+* authors be held liable for any damages arising from the use of this software.
+* Permission  is granted  to anyone  to use  this software  for  any  purpose,  including  commercial
+* applications, and to alter it and redistribute it freely, subject to the following restrictions:
+*
+*   1. The origin of this software must not be misrepresented; you must not claim that you  wrote the
+*      original  software. If you use this  software  in a product, an  acknowledgment in the product
+*      documentation would be appreciated but is not required.
+*   2. Altered source versions must  be plainly  marked as such, and  must not be  misrepresented  as
+*      being the original software.
+*   3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "d3d9.h"
+
+void DeviceStateCache::Invalidate()
+{
+	ZeroMemory(IsRenderStateSet, sizeof(IsRenderStateSet));
+	ZeroMemory(IsTextureStageStateSet, sizeof(IsTextureStageStateSet));
+	ZeroMemory(IsSamplerStateSet, sizeof(IsSamplerStateSet));
+	ZeroMemory(IsTextureSet, sizeof(IsTextureSet));
+	ZeroMemory(VertexShaderConstantF.IsSet, sizeof(VertexShaderConstantF.IsSet));
+	ZeroMemory(VertexShaderConstantI.IsSet, sizeof(VertexShaderConstantI.IsSet));
+	ZeroMemory(VertexShaderConstantB.IsSet, sizeof(VertexShaderConstantB.IsSet));
+	ZeroMemory(PixelShaderConstantF.IsSet, sizeof(PixelShaderConstantF.IsSet));
+	ZeroMemory(PixelShaderConstantI.IsSet, sizeof(PixelShaderConstantI.IsSet));
+	ZeroMemory(PixelShaderConstantB.IsSet, sizeof(PixelShaderConstantB.IsSet));
+}
+
+void DeviceStateCache::LogCounters()
+{
+	if (!Enabled)
+	{
+		return;
+	}
+
+	Logging::Log() << "Redundant states filtered:" <<
+		" RenderState " << FilteredCount[COUNTER_RENDERSTATE] << "/" << CallCount[COUNTER_RENDERSTATE] <<
+		" TextureStageState " << FilteredCount[COUNTER_TEXTURESTAGESTATE] << "/" << CallCount[COUNTER_TEXTURESTAGESTATE] <<
+		" SamplerState " << FilteredCount[COUNTER_SAMPLERSTATE] << "/" << CallCount[COUNTER_SAMPLERSTATE] <<
+		" Texture " << FilteredCount[COUNTER_TEXTURE] << "/" << CallCount[COUNTER_TEXTURE] <<
+		" ShaderConstant " << FilteredCount[COUNTER_SHADERCONSTANT] << "/" << CallCount[COUNTER_SHADERCONSTANT];
+}
+
+DWORD DeviceStateCache::GetSamplerIndex(DWORD Sampler)
+{
+	if (Sampler < 16)
+	{
+		return Sampler;
+	}
+	if (Sampler >= D3DDMAPSAMPLER && Sampler <= D3DVERTEXTEXTURESAMPLER3)
+	{
+		return 16 + Sampler - D3DDMAPSAMPLER;
+	}
+	return MaxSamplers;
+}
+
+bool DeviceStateCache::Count(DWORD Counter, bool IsRedundant)
+{
+	CallCount[Counter]++;
+	if (IsRedundant)
+	{
+		FilteredCount[Counter]++;
+	}
+	return IsRedundant;
+}
+
+bool DeviceStateCache::FilterRenderState(D3DRENDERSTATETYPE State, DWORD Value)
+{
+	if (!IsFiltering())
+	{
+		return false;
+	}
+
+	return Count(COUNTER_RENDERSTATE, (DWORD)State < MaxRenderStates && IsRenderStateSet[State] && RenderState[State] == Value);
+}
+
+void DeviceStateCache::SaveRenderState(D3DRENDERSTATETYPE State, DWORD Value)
+{
+	if (IsFiltering() && (DWORD)State < MaxRenderStates)
+	{
+		RenderState[State] = Value;
+		IsRenderStateSet[State] = true;
+	}
+}
+
+void DeviceStateCache::ClearRenderState(D3DRENDERSTATETYPE State)
+{
+	if ((DWORD)State < MaxRenderStates)
+	{
+		IsRenderStateSet[State] = false;
+	}
+}
+
+bool DeviceStateCache::FilterTextureStageState(DWORD Stage, D3DTEXTURESTAGESTATETYPE Type, DWORD Value)
+{
+	if (!IsFiltering())
+	{
+		return false;
+	}
+
+	return Count(COUNTER_TEXTURESTAGESTATE, Stage < MaxTextureStages && (DWORD)Type < MaxTextureStageStates &&
+		IsTextureStageStateSet[Stage][Type] && TextureStageState[Stage][Type] == Value);
+}
+
+void DeviceStateCache::SaveTextureStageState(DWORD Stage, D3DTEXTURESTAGESTATETYPE Type, DWORD Value)
+{
+	if (IsFiltering() && Stage < MaxTextureStages && (DWORD)Type < MaxTextureStageStates)
+	{
+		TextureStageState[Stage][Type] = Value;
+		IsTextureStageStateSet[Stage][Type] = true;
+	}
+}
+
+bool DeviceStateCache::FilterSamplerState(DWORD Sampler, D3DSAMPLERSTATETYPE Type, DWORD Value)
+{
+	if (!IsFiltering())
+	{
+		return false;
+	}
+
+	DWORD Index = GetSamplerIndex(Sampler);
+	return Count(COUNTER_SAMPLERSTATE, Index < MaxSamplers && (DWORD)Type < MaxSamplerStates &&
+		IsSamplerStateSet[Index][Type] && SamplerState[Index][Type] == Value);
+}
+
+void DeviceStateCache::SaveSamplerState(DWORD Sampler, D3DSAMPLERSTATETYPE Type, DWORD Value)
+{
+	DWORD Index = GetSamplerIndex(Sampler);
+	if (IsFiltering() && Index < MaxSamplers && (DWORD)Type < MaxSamplerStates)
+	{
+		SamplerState[Index][Type] = Value;
+		IsSamplerStateSet[Index][Type] = true;
+	}
+}
+
+void DeviceStateCache::ClearSamplerState(DWORD Sampler, D3DSAMPLERSTATETYPE Type)
+{
+	DWORD Index = GetSamplerIndex(Sampler);
+	if (Index < MaxSamplers && (DWORD)Type < MaxSamplerStates)
+	{
+		IsSamplerStateSet[Index][Type] = false;
+	}
+}
+
+bool DeviceStateCache::FilterTexture(DWORD Stage, IDirect3DBaseTexture9* pTexture)
+{
+	if (!IsFiltering())
+	{
+		return false;
+	}
+
+	// The device holds a reference to bound textures so the address cannot be reused while it is cached
+	DWORD Index = GetSamplerIndex(Stage);
+	return Count(COUNTER_TEXTURE, Index < MaxSamplers && IsTextureSet[Index] && Texture[Index] == pTexture);
+}
+
+void DeviceStateCache::SaveTexture(DWORD Stage, IDirect3DBaseTexture9* pTexture)
+{
+	DWORD Index = GetSamplerIndex(Stage);
+	if (IsFiltering() && Index < MaxSamplers)
+	{
+		Texture[Index] = pTexture;
+		IsTextureSet[Index] = true;
+	}
+}
+
+template <DWORD Registers, DWORD Width>
+bool DeviceStateCache::FilterConstants(ConstantCache<Registers, Width>& Cache, UINT& StartRegister, const void*& pConstantData, UINT& Count)
+{
+	if (!IsFiltering())
+	{
+		return false;
+	}
+
+	// Registers outside of the cache are always passed through
+	if (!pConstantData || !Count || StartRegister >= Registers || Count > Registers - StartRegister)
+	{
+		return this->Count(COUNTER_SHADERCONSTANT, false);
+	}
+
+	const DWORD* pData = (const DWORD*)pConstantData;
+	auto IsChanged = [&](UINT x) { return !Cache.IsSet[StartRegister + x] || memcmp(Cache.Value[StartRegister + x], pData + x * Width, Width * sizeof(DWORD)) != 0; };
+
+	UINT First = 0;
+	while (First < Count && !IsChanged(First))
+	{
+		First++;
+	}
+	if (First == Count)
+	{
+		return this->Count(COUNTER_SHADERCONSTANT, true);
+	}
+	UINT Last = Count - 1;
+	while (Last > First && !IsChanged(Last))
+	{
+		Last--;
+	}
+
+	StartRegister += First;
+	pConstantData = pData + First * Width;
+	Count = Last - First + 1;
+
+	return this->Count(COUNTER_SHADERCONSTANT, false);
+}
+
+template <DWORD Registers, DWORD Width>
+void DeviceStateCache::SaveConstants(ConstantCache<Registers, Width>& Cache, UINT StartRegister, const void* pConstantData, UINT Count)
+{
+	if (!IsFiltering() || !pConstantData)
+	{
+		return;
+	}
+
+	const DWORD* pData = (const DWORD*)pConstantData;
+	for (UINT x = 0; x < Count && StartRegister + x < Registers; x++)
+	{
+		memcpy(Cache.Value[StartRegister + x], pData + x * Width, Width * sizeof(DWORD));
+		Cache.IsSet[StartRegister + x] = true;
+	}
+}
+
+#define DEFINE_CONSTANT_FILTER(Shader, Type, DataType) \
+	bool DeviceStateCache::Filter ## Shader ## ShaderConstant ## Type(UINT& StartRegister, const DataType*& pConstantData, UINT& Count) \
+	{ \
+		const void* pData = pConstantData; \
+		bool ret = FilterConstants(Shader ## ShaderConstant ## Type, StartRegister, pData, Count); \
+		pConstantData = (const DataType*)pData; \
+		return ret; \
+	} \
+	void DeviceStateCache::Save ## Shader ## ShaderConstant ## Type(UINT StartRegister, const DataType* pConstantData, UINT Count) \
+	{ \
+		SaveConstants(Shader ## ShaderConstant ## Type, StartRegister, pConstantData, Count); \
+	}
+
+DEFINE_CONSTANT_FILTER(Vertex, F, float)
+DEFINE_CONSTANT_FILTER(Vertex, I, int)
+DEFINE_CONSTANT_FILTER(Vertex, B, BOOL)
+DEFINE_CONSTANT_FILTER(Pixel, F, float)
+DEFINE_CONSTANT_FILTER(Pixel, I, int)
+DEFINE_CONSTANT_FILTER(Pixel, B, BOOL)
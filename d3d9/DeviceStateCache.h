@@ -0,0 +1,88 @@
+#pragma once
+
+// Shadow copy of the device state used to drop Set* calls that would not change anything
+class DeviceStateCache
+{
+private:
+	static constexpr DWORD MaxRenderStates = 256;
+	static constexpr DWORD MaxTextureStages = 8;
+	static constexpr DWORD MaxTextureStageStates = D3DTSS_CONSTANT + 1;
+	static constexpr DWORD MaxSamplers = 16 + 5;		// Pixel samplers, displacement map sampler and vertex samplers
+	static constexpr DWORD MaxSamplerStates = D3DSAMP_DMAPOFFSET + 1;
+
+	template <DWORD Registers, DWORD Width>
+	struct ConstantCache
+	{
+		DWORD Value[Registers][Width];
+		bool IsSet[Registers];
+	};
+
+	bool Enabled = false;
+	bool IsRecording = false;
+
+	DWORD RenderState[MaxRenderStates];
+	bool IsRenderStateSet[MaxRenderStates];
+	DWORD TextureStageState[MaxTextureStages][MaxTextureStageStates];
+	bool IsTextureStageStateSet[MaxTextureStages][MaxTextureStageStates];
+	DWORD SamplerState[MaxSamplers][MaxSamplerStates];
+	bool IsSamplerStateSet[MaxSamplers][MaxSamplerStates];
+	IDirect3DBaseTexture9* Texture[MaxSamplers];
+	bool IsTextureSet[MaxSamplers];
+
+	ConstantCache<256, 4> VertexShaderConstantF;
+	ConstantCache<16, 4> VertexShaderConstantI;
+	ConstantCache<16, 1> VertexShaderConstantB;
+	ConstantCache<224, 4> PixelShaderConstantF;
+	ConstantCache<16, 4> PixelShaderConstantI;
+	ConstantCache<16, 1> PixelShaderConstantB;
+
+	// Counters
+	enum { COUNTER_RENDERSTATE, COUNTER_TEXTURESTAGESTATE, COUNTER_SAMPLERSTATE, COUNTER_TEXTURE, COUNTER_SHADERCONSTANT, COUNTER_MAX };
+	ULONGLONG CallCount[COUNTER_MAX] = {};
+	ULONGLONG FilteredCount[COUNTER_MAX] = {};
+
+	static DWORD GetSamplerIndex(DWORD Sampler);
+	bool IsFiltering() { return Enabled && !IsRecording; }
+	bool Count(DWORD Counter, bool IsRedundant);
+	template <DWORD Registers, DWORD Width>
+	bool FilterConstants(ConstantCache<Registers, Width>& Cache, UINT& StartRegister, const void*& pConstantData, UINT& Count);
+	template <DWORD Registers, DWORD Width>
+	void SaveConstants(ConstantCache<Registers, Width>& Cache, UINT StartRegister, const void* pConstantData, UINT Count);
+
+public:
+	DeviceStateCache(bool IsEnabled) : Enabled(IsEnabled) { Invalidate(); }
+	~DeviceStateCache() { LogCounters(); }
+
+	void Invalidate();
+	void LogCounters();
+
+	// State blocks record Set* calls instead of applying them, so nothing is filtered or saved while recording
+	void BeginRecording() { IsRecording = true; }
+	void EndRecording() { IsRecording = false; }
+
+	// Filter* returns true when the call is redundant and can be dropped, Save* records a successful call
+	bool FilterRenderState(D3DRENDERSTATETYPE State, DWORD Value);
+	void SaveRenderState(D3DRENDERSTATETYPE State, DWORD Value);
+	void ClearRenderState(D3DRENDERSTATETYPE State);
+	bool FilterTextureStageState(DWORD Stage, D3DTEXTURESTAGESTATETYPE Type, DWORD Value);
+	void SaveTextureStageState(DWORD Stage, D3DTEXTURESTAGESTATETYPE Type, DWORD Value);
+	bool FilterSamplerState(DWORD Sampler, D3DSAMPLERSTATETYPE Type, DWORD Value);
+	void SaveSamplerState(DWORD Sampler, D3DSAMPLERSTATETYPE Type, DWORD Value);
+	void ClearSamplerState(DWORD Sampler, D3DSAMPLERSTATETYPE Type);
+	bool FilterTexture(DWORD Stage, IDirect3DBaseTexture9* pTexture);
+	void SaveTexture(DWORD Stage, IDirect3DBaseTexture9* pTexture);
+
+	// Shader constant filters trim the register range down to the registers that actually change
+	bool FilterVertexShaderConstantF(UINT& StartRegister, const float*& pConstantData, UINT& Vector4fCount);
+	void SaveVertexShaderConstantF(UINT StartRegister, const float* pConstantData, UINT Vector4fCount);
+	bool FilterVertexShaderConstantI(UINT& StartRegister, const int*& pConstantData, UINT& Vector4iCount);
+	void SaveVertexShaderConstantI(UINT StartRegister, const int* pConstantData, UINT Vector4iCount);
+	bool FilterVertexShaderConstantB(UINT& StartRegister, const BOOL*& pConstantData, UINT& BoolCount);
+	void SaveVertexShaderConstantB(UINT StartRegister, const BOOL* pConstantData, UINT BoolCount);
+	bool FilterPixelShaderConstantF(UINT& StartRegister, const float*& pConstantData, UINT& Vector4fCount);
+	void SavePixelShaderConstantF(UINT StartRegister, const float* pConstantData, UINT Vector4fCount);
+	bool FilterPixelShaderConstantI(UINT& StartRegister, const int*& pConstantData, UINT& Vector4iCount);
+	void SavePixelShaderConstantI(UINT StartRegister, const int* pConstantData, UINT Vector4iCount);
+	bool FilterPixelShaderConstantB(UINT& StartRegister, const BOOL*& pConstantData, UINT& BoolCount);
+	void SavePixelShaderConstantB(UINT StartRegister, const BOOL* pConstantData, UINT BoolCount);
+};
@@ -0,0 +1,244 @@
+/**
+* Copyright (C) 2023 Elisha Riedlinger
+*
+* This software is  provided 'as-is', without any express  or implied  warranty. In no event will the
+* authors be held liable for any damages arising from the use of this software.
+* Permission  is granted  to anyone  to use  this software  for  any  purpose,  including  commercial
+* applications, and to alter it and redistribute it freely, subject to the following restrictions:
+*
+*   1. The origin of this software must not be misrepresented; you must not claim that you  wrote the
+*      original  software. If you use this  software  in a product, an  acknowledgment in the product
+*      documentation would be appreciated but is not required.
+*   2. Altered source versions must  be plainly  marked as such, and  must not be  misrepresented  as
+*      being the original software.
+*   3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "d3d9.h"
+#include "d3dx9.h"
+
+void FrontBufferCapture::LogCounters()
+{
+	if (!CallCount)
+	{
+		return;
+	}
+
+	LARGE_INTEGER Frequency = {};
+	QueryPerformanceFrequency(&Frequency);
+
+	Logging::Log() << "Front buffer capture:" <<
+		" Calls " << CallCount <<
+		" Allocations " << AllocationCount <<
+		" AverageLatency " << (Frequency.QuadPart ? (TotalTicks * 1000000 / Frequency.QuadPart) / (LONGLONG)CallCount : 0) << "us" <<
+		(Pipelined ? " Pipelined" : "");
+}
+
+DWORD WINAPI FrontBufferCapture::CaptureThreadFunc(LPVOID lpParam)
+{
+	FrontBufferCapture* self = (FrontBufferCapture*)lpParam;
+
+	while (true)
+	{
+		WaitForSingleObject(self->workerEvent, INFINITE);
+
+		EnterCriticalSection(&self->StateLock);
+		const bool EndThread = self->EndThread;
+		const DWORD BackIndex = self->FrontIndex ^ 1;
+		LeaveCriticalSection(&self->StateLock);
+
+		if (EndThread)
+		{
+			break;
+		}
+
+		// The main thread only reads the front surface, so the back surface can be written without holding the lock
+		HRESULT hr = self->d3d9Device->GetFrontBufferData(self->SwapChain, self->pSurface[BackIndex]);
+
+		EnterCriticalSection(&self->StateLock);
+		if (SUCCEEDED(hr))
+		{
+			self->FrontIndex = BackIndex;
+			self->HasFrame = true;
+		}
+		self->IsCapturing = false;
+		SetEvent(self->idleEvent);
+		LeaveCriticalSection(&self->StateLock);
+	}
+
+	return 0;
+}
+
+void FrontBufferCapture::StartThread()
+{
+	if (workerThread)
+	{
+		return;
+	}
+
+	EndThread = false;
+	InitializeCriticalSection(&StateLock);
+	workerEvent = CreateEvent(nullptr, FALSE, FALSE, nullptr);
+	idleEvent = CreateEvent(nullptr, TRUE, TRUE, nullptr);
+	workerThread = CreateThread(nullptr, 0, CaptureThreadFunc, this, 0, nullptr);
+}
+
+void FrontBufferCapture::StopThread()
+{
+	if (!workerThread)
+	{
+		return;
+	}
+
+	WaitForCapture();
+
+	EnterCriticalSection(&StateLock);
+	EndThread = true;								// Tell thread to exit
+	SetEvent(workerEvent);							// Trigger thread
+	LeaveCriticalSection(&StateLock);
+	WaitForSingleObject(workerThread, INFINITE);	// Wait for thread to finish
+	CloseHandle(workerThread);
+	CloseHandle(workerEvent);
+	CloseHandle(idleEvent);
+	DeleteCriticalSection(&StateLock);
+	workerThread = nullptr;
+	workerEvent = nullptr;
+	idleEvent = nullptr;
+}
+
+void FrontBufferCapture::WaitForCapture()
+{
+	if (workerThread)
+	{
+		WaitForSingleObject(idleEvent, INFINITE);
+	}
+}
+
+void FrontBufferCapture::StartCapture(LPDIRECT3DDEVICE9 pDevice, UINT iSwapChain)
+{
+	EnterCriticalSection(&StateLock);
+	if (!IsCapturing)
+	{
+		IsCapturing = true;
+		d3d9Device = pDevice;
+		SwapChain = iSwapChain;
+		ResetEvent(idleEvent);
+		SetEvent(workerEvent);
+	}
+	LeaveCriticalSection(&StateLock);
+}
+
+void FrontBufferCapture::ReleaseSurfaces()
+{
+	// The worker thread may still be writing to a surface
+	WaitForCapture();
+
+	for (auto& Surface : pSurface)
+	{
+		if (Surface)
+		{
+			Surface->Release();
+			Surface = nullptr;
+		}
+	}
+	Width = 0;
+	Height = 0;
+	FrontIndex = 0;
+	HasFrame = false;
+}
+
+HRESULT FrontBufferCapture::CreateSurfaces(LPDIRECT3DDEVICE9 pDevice, UINT NewWidth, UINT NewHeight, DWORD Count)
+{
+	ReleaseSurfaces();
+
+	for (DWORD x = 0; x < Count; x++)
+	{
+		// GetFrontBufferData always copies to a D3DFMT_A8R8G8B8 system memory surface
+		if (FAILED(pDevice->CreateOffscreenPlainSurface(NewWidth, NewHeight, D3DFMT_A8R8G8B8, D3DPOOL_SYSTEMMEM, &pSurface[x], nullptr)))
+		{
+			LOG_LIMIT(100, __FUNCTION__ << " Error: failed to create capture surface!");
+			ReleaseSurfaces();
+			return D3DERR_INVALIDCALL;
+		}
+		AllocationCount++;
+	}
+
+	Width = NewWidth;
+	Height = NewHeight;
+
+	return D3D_OK;
+}
+
+HRESULT FrontBufferCapture::GetFrontBufferData(LPDIRECT3DDEVICE9 pDevice, UINT iSwapChain, UINT CaptureWidth, UINT CaptureHeight, const RECT& SrcRect, IDirect3DSurface9* pDestSurface)
+{
+	D3DSURFACE_DESC Desc;
+	if (!pDevice || !pDestSurface || FAILED(pDestSurface->GetDesc(&Desc)))
+	{
+		return D3DERR_INVALIDCALL;
+	}
+
+	LARGE_INTEGER StartTime = {}, EndTime = {};
+	QueryPerformanceCounter(&StartTime);
+	CallCount++;
+
+	// Capturing on another thread needs a device that can be used from more than one thread
+	D3DDEVICE_CREATION_PARAMETERS Params = {};
+	const bool UsePipeline = Pipelined && SUCCEEDED(pDevice->GetCreationParameters(&Params)) && (Params.BehaviorFlags & D3DCREATE_MULTITHREADED);
+	const DWORD Count = UsePipeline ? 2 : 1;
+
+	// Recreate surfaces on resize
+	if (Width != CaptureWidth || Height != CaptureHeight || GetCount() != Count)
+	{
+		if (FAILED(CreateSurfaces(pDevice, CaptureWidth, CaptureHeight, Count)))
+		{
+			return D3DERR_INVALIDCALL;
+		}
+	}
+
+	HRESULT hr = D3D_OK;
+	DWORD ReadIndex = 0;
+	if (UsePipeline)
+	{
+		StartThread();
+
+		EnterCriticalSection(&StateLock);
+		const bool Ready = HasFrame;
+		ReadIndex = FrontIndex;
+		LeaveCriticalSection(&StateLock);
+
+		// Nothing captured yet, so capture the first frame directly
+		if (!Ready)
+		{
+			WaitForCapture();
+			ReadIndex = FrontIndex;
+			hr = pDevice->GetFrontBufferData(iSwapChain, pSurface[ReadIndex]);
+			HasFrame = SUCCEEDED(hr);
+		}
+	}
+	else
+	{
+		hr = pDevice->GetFrontBufferData(iSwapChain, pSurface[ReadIndex]);
+	}
+
+	// Copy data to DestSurface, stretching if the sizes differ
+	if (SUCCEEDED(hr))
+	{
+		const bool Stretch = (SrcRect.right - SrcRect.left != (LONG)Desc.Width || SrcRect.bottom - SrcRect.top != (LONG)Desc.Height);
+		hr = D3DXLoadSurfaceFromSurface(pDestSurface, nullptr, nullptr, pSurface[ReadIndex], nullptr, &SrcRect, Stretch ? D3DX_FILTER_POINT : D3DX_FILTER_NONE, 0);
+		if (FAILED(hr))
+		{
+			hr = D3DERR_INVALIDCALL;
+		}
+	}
+
+	// Start capturing the next frame
+	if (UsePipeline)
+	{
+		StartCapture(pDevice, iSwapChain);
+	}
+
+	QueryPerformanceCounter(&EndTime);
+	TotalTicks += EndTime.QuadPart - StartTime.QuadPart;
+
+	return hr;
+}
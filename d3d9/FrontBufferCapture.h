@@ -0,0 +1,50 @@
+#pragma once
+
+// Keeps the surfaces used to emulate GetFrontBufferData alive between calls, they are only recreated on resize or reset
+// When pipelined each call returns the previous capture while a worker thread captures the next one
+class FrontBufferCapture
+{
+private:
+	bool Pipelined = false;
+	UINT Width = 0;
+	UINT Height = 0;
+	IDirect3DSurface9* pSurface[2] = {};		// System memory copies of the front buffer, the second one is only used when pipelined
+	DWORD FrontIndex = 0;						// Surface holding the last finished capture
+	bool HasFrame = false;
+
+	// Worker thread used when pipelined
+	LPDIRECT3DDEVICE9 d3d9Device = nullptr;
+	UINT SwapChain = 0;
+	bool IsCapturing = false;
+	bool EndThread = false;
+	CRITICAL_SECTION StateLock = {};
+	HANDLE workerEvent = nullptr;
+	HANDLE idleEvent = nullptr;
+	HANDLE workerThread = nullptr;
+
+	// Counters
+	ULONGLONG CallCount = 0;
+	ULONGLONG AllocationCount = 0;
+	LONGLONG TotalTicks = 0;
+
+	static DWORD WINAPI CaptureThreadFunc(LPVOID lpParam);
+	void StartThread();
+	void StopThread();
+	void WaitForCapture();
+	void StartCapture(LPDIRECT3DDEVICE9 pDevice, UINT iSwapChain);
+	HRESULT CreateSurfaces(LPDIRECT3DDEVICE9 pDevice, UINT NewWidth, UINT NewHeight, DWORD Count);
+
+public:
+	FrontBufferCapture(bool IsPipelined) : Pipelined(IsPipelined) {}
+	~FrontBufferCapture() { LogCounters(); StopThread(); ReleaseSurfaces(); }
+
+	// Copies the front buffer rect SrcRect into pDestSurface, stretching if the sizes differ
+	// CaptureWidth and CaptureHeight are the size of the surface that receives the front buffer
+	HRESULT GetFrontBufferData(LPDIRECT3DDEVICE9 pDevice, UINT iSwapChain, UINT CaptureWidth, UINT CaptureHeight, const RECT& SrcRect, IDirect3DSurface9* pDestSurface);
+	void ReleaseSurfaces();
+	ULONG GetCount() { return (pSurface[0] ? 1 : 0) + (pSurface[1] ? 1 : 0); }
+
+	ULONGLONG GetCallCount() { return CallCount; }
+	ULONGLONG GetAllocationCount() { return AllocationCount; }
+	void LogCounters();
+};
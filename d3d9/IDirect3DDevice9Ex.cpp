@@ -17,6 +17,7 @@
 #include "d3d9.h"
 #include "d3dx9.h"
 #include "Utils\Utils.h"
+#include "ddraw\Blitter.h"
 #include <intrin.h>
 
 HRESULT m_IDirect3DDevice9Ex::QueryInterface(REFIID riid, void** ppvObj)
@@ -46,6 +47,8 @@ ULONG m_IDirect3DDevice9Ex::AddRef()
 {
 	Logging::LogDebug() << __FUNCTION__ << " (" << this << ")";
 
+	InterlockedIncrement(&RefCount);
+
 	return ProxyInterface->AddRef();
 }
 
@@ -53,6 +56,15 @@ ULONG m_IDirect3DDevice9Ex::Release()
 {
 	Logging::LogDebug() << __FUNCTION__ << " (" << this << ")";
 
+	// Pooled scratch and capture surfaces and streamed vertex buffers hold references to the device, release them once the application has released the device
+	// The device is only destroyed once the application also releases its own surfaces and buffers
+	if (InterlockedDecrement(&RefCount) == 0)
+	{
+		ScratchPool.ReleaseAll();
+		FrontBuffer.ReleaseSurfaces();
+		VertexStreaming.StopAll();
+	}
+
 	ULONG ref = ProxyInterface->Release();
 
 	if (ref == 0)
@@ -69,11 +81,11 @@ void m_IDirect3DDevice9Ex::ClearVars(D3DPRESENT_PARAMETERS* pPresentationParamet
 
 	// Clear variables
 	ZeroMemory(&Caps, sizeof(D3DCAPS9));
-	MaxAnisotropy = 0;
-	isAnisotropySet = false;
-	AnisotropyDisabledFlag = false;
-	isClipPlaneSet = false;
-	m_clipPlaneRenderState = 0;
+	Anisotropy.Disable();
+
+	// Reset restores the default device state
+	StateCache.Invalidate();
+	ClipPlanes.Reset();
 }
 
 template <typename T>
@@ -86,6 +98,12 @@ HRESULT m_IDirect3DDevice9Ex::ResetT(T func, D3DPRESENT_PARAMETERS &d3dpp, D3DPR
 
 	HRESULT hr;
 
+	// Capture surfaces are recreated after the reset, this also waits for a pipelined capture to finish
+	FrontBuffer.ReleaseSurfaces();
+
+	// Dynamic vertex buffers are in the default pool, buffers start streaming again once they are written every frame
+	VertexStreaming.StopAll();
+
 	// Check fullscreen
 	bool ForceFullscreen = false;
 	if (m_pD3DEx)
@@ -410,7 +428,16 @@ HRESULT m_IDirect3DDevice9Ex::BeginStateBlock()
 {
 	Logging::LogDebug() << __FUNCTION__ << " (" << this << ")";
 
-	return ProxyInterface->BeginStateBlock();
+	HRESULT hr = ProxyInterface->BeginStateBlock();
+
+	if (SUCCEEDED(hr))
+	{
+		IsRecordingStateBlock = true;
+		StateCache.BeginRecording();
+		ClipPlanes.BeginRecording();
+	}
+
+	return hr;
 }
 
 HRESULT m_IDirect3DDevice9Ex::CreateStateBlock(THIS_ D3DSTATEBLOCKTYPE Type, IDirect3DStateBlock9** ppSB)
@@ -422,8 +449,18 @@ HRESULT m_IDirect3DDevice9Ex::CreateStateBlock(THIS_ D3DSTATEBLOCKTYPE Type, IDi
 		return D3DERR_INVALIDCALL;
 	}
 
+	// Make sure the device has the current clip planes before they are captured
+	ApplyClipPlanes(true);
+
+	// State blocks capture the application's filters and, for StreamHotVertexBuffers, the managed buffers
+	BeginSamplerFilterCapture();
+	BeginVertexBufferCapture();
+
 	HRESULT hr = ProxyInterface->CreateStateBlock(Type, ppSB);
 
+	EndVertexBufferCapture();
+	EndSamplerFilterCapture();
+
 	if (SUCCEEDED(hr))
 	{
 		*ppSB = new m_IDirect3DStateBlock9(*ppSB, this);
@@ -440,6 +477,10 @@ HRESULT m_IDirect3DDevice9Ex::EndStateBlock(THIS_ IDirect3DStateBlock9** ppSB)
 
 	HRESULT hr = ProxyInterface->EndStateBlock(ppSB);
 
+	IsRecordingStateBlock = false;
+	StateCache.EndRecording();
+	ClipPlanes.EndRecording();
+
 	if (SUCCEEDED(hr) && ppSB)
 	{
 		*ppSB = ProxyAddressLookupTable->FindAddress<m_IDirect3DStateBlock9>(*ppSB);
@@ -507,12 +548,22 @@ HRESULT m_IDirect3DDevice9Ex::SetRenderState(D3DRENDERSTATETYPE State, DWORD Val
 		Value = TRUE;
 	}
 
+	if (StateCache.FilterRenderState(State, Value))
+	{
+		return D3D_OK;
+	}
+
 	HRESULT hr = ProxyInterface->SetRenderState(State, Value);
 
+	if (SUCCEEDED(hr))
+	{
+		StateCache.SaveRenderState(State, Value);
+	}
+
 	// CacheClipPlane
-	if (SUCCEEDED(hr) && State == D3DRS_CLIPPLANEENABLE)
+	if (SUCCEEDED(hr) && State == D3DRS_CLIPPLANEENABLE && !ClipPlanes.IsRecordingStateBlock())
 	{
-		m_clipPlaneRenderState = Value;
+		ClipPlanes.SetEnableMask(Value);
 	}
 
 	return hr;
@@ -534,7 +585,15 @@ HRESULT m_IDirect3DDevice9Ex::SetTransform(D3DTRANSFORMSTATETYPE State, CONST D3
 {
 	Logging::LogDebug() << __FUNCTION__ << " (" << this << ")";
 
-	return ProxyInterface->SetTransform(State, pMatrix);
+	HRESULT hr = ProxyInterface->SetTransform(State, pMatrix);
+
+	// CacheClipPlane
+	if (SUCCEEDED(hr) && !ClipPlanes.IsRecordingStateBlock())
+	{
+		ClipPlanes.SetTransform(State);
+	}
+
+	return hr;
 }
 
 void m_IDirect3DDevice9Ex::GetGammaRamp(THIS_ UINT iSwapChain, D3DGAMMARAMP* pRamp)
@@ -562,6 +621,9 @@ HRESULT m_IDirect3DDevice9Ex::DrawRectPatch(UINT Handle, CONST float *pNumSegs,
 {
 	Logging::LogDebug() << __FUNCTION__ << " (" << this << ")";
 
+	// StreamHotVertexBuffers
+	ApplyVertexBuffers();
+
 	return ProxyInterface->DrawRectPatch(Handle, pNumSegs, pRectPatchInfo);
 }
 
@@ -569,6 +631,9 @@ HRESULT m_IDirect3DDevice9Ex::DrawTriPatch(UINT Handle, CONST float *pNumSegs, C
 {
 	Logging::LogDebug() << __FUNCTION__ << " (" << this << ")";
 
+	// StreamHotVertexBuffers
+	ApplyVertexBuffers();
+
 	return ProxyInterface->DrawTriPatch(Handle, pNumSegs, pTriPatchInfo);
 }
 
@@ -689,15 +754,27 @@ HRESULT m_IDirect3DDevice9Ex::MultiplyTransform(D3DTRANSFORMSTATETYPE State, CON
 {
 	Logging::LogDebug() << __FUNCTION__ << " (" << this << ")";
 
-	return ProxyInterface->MultiplyTransform(State, pMatrix);
+	HRESULT hr = ProxyInterface->MultiplyTransform(State, pMatrix);
+
+	// CacheClipPlane
+	if (SUCCEEDED(hr) && !ClipPlanes.IsRecordingStateBlock())
+	{
+		ClipPlanes.SetTransform(State);
+	}
+
+	return hr;
 }
 
 HRESULT m_IDirect3DDevice9Ex::ProcessVertices(THIS_ UINT SrcStartIndex, UINT DestIndex, UINT VertexCount, IDirect3DVertexBuffer9* pDestBuffer, IDirect3DVertexDeclaration9* pVertexDecl, DWORD Flags)
 {
 	Logging::LogDebug() << __FUNCTION__ << " (" << this << ")";
 
+	// StreamHotVertexBuffers, the destination is written by the device so it uses the managed buffer
+	ApplyVertexBuffers();
+
 	if (pDestBuffer)
 	{
+		static_cast<m_IDirect3DVertexBuffer9 *>(pDestBuffer)->StopStreaming();
 		pDestBuffer = static_cast<m_IDirect3DVertexBuffer9 *>(pDestBuffer)->GetProxyInterface();
 	}
 
@@ -795,6 +872,8 @@ HRESULT m_IDirect3DDevice9Ex::Present(CONST RECT *pSourceRect, CONST RECT *pDest
 {
 	Logging::LogDebug() << __FUNCTION__ << " (" << this << ")";
 
+	EndFrame();
+
 	return ProxyInterface->Present(pSourceRect, pDestRect, hDestWindowOverride, pDirtyRegion);
 }
 
@@ -803,16 +882,16 @@ HRESULT m_IDirect3DDevice9Ex::DrawIndexedPrimitive(THIS_ D3DPRIMITIVETYPE Type,
 	Logging::LogDebug() << __FUNCTION__ << " (" << this << ")";
 
 	// CacheClipPlane
-	if (Config.CacheClipPlane && isClipPlaneSet)
+	if (ClipPlanes.IsEnabled())
 	{
 		ApplyClipPlanes();
 	}
 
-	// Reenable Anisotropic Filtering
-	if (MaxAnisotropy)
-	{
-		ReeableAnisotropicSamplerState();
-	}
+	// Anisotropic Filtering
+	ApplySamplerFilters();
+
+	// StreamHotVertexBuffers
+	ApplyVertexBuffers();
 
 	return ProxyInterface->DrawIndexedPrimitive(Type, BaseVertexIndex, MinVertexIndex, NumVertices, startIndex, primCount);
 }
@@ -822,16 +901,13 @@ HRESULT m_IDirect3DDevice9Ex::DrawIndexedPrimitiveUP(D3DPRIMITIVETYPE PrimitiveT
 	Logging::LogDebug() << __FUNCTION__ << " (" << this << ")";
 
 	// CacheClipPlane
-	if (Config.CacheClipPlane && isClipPlaneSet)
+	if (ClipPlanes.IsEnabled())
 	{
 		ApplyClipPlanes();
 	}
 
-	// Reenable Anisotropic Filtering
-	if (MaxAnisotropy)
-	{
-		ReeableAnisotropicSamplerState();
-	}
+	// Anisotropic Filtering
+	ApplySamplerFilters();
 
 	return ProxyInterface->DrawIndexedPrimitiveUP(PrimitiveType, MinIndex, NumVertices, PrimitiveCount, pIndexData, IndexDataFormat, pVertexStreamZeroData, VertexStreamZeroStride);
 }
@@ -841,16 +917,16 @@ HRESULT m_IDirect3DDevice9Ex::DrawPrimitive(D3DPRIMITIVETYPE PrimitiveType, UINT
 	Logging::LogDebug() << __FUNCTION__ << " (" << this << ")";
 
 	// CacheClipPlane
-	if (Config.CacheClipPlane && isClipPlaneSet)
+	if (ClipPlanes.IsEnabled())
 	{
 		ApplyClipPlanes();
 	}
 
-	// Reenable Anisotropic Filtering
-	if (MaxAnisotropy)
-	{
-		ReeableAnisotropicSamplerState();
-	}
+	// Anisotropic Filtering
+	ApplySamplerFilters();
+
+	// StreamHotVertexBuffers
+	ApplyVertexBuffers();
 
 	return ProxyInterface->DrawPrimitive(PrimitiveType, StartVertex, PrimitiveCount);
 }
@@ -860,16 +936,13 @@ HRESULT m_IDirect3DDevice9Ex::DrawPrimitiveUP(D3DPRIMITIVETYPE PrimitiveType, UI
 	Logging::LogDebug() << __FUNCTION__ << " (" << this << ")";
 
 	// CacheClipPlane
-	if (Config.CacheClipPlane && isClipPlaneSet)
+	if (ClipPlanes.IsEnabled())
 	{
 		ApplyClipPlanes();
 	}
 
-	// Reenable Anisotropic Filtering
-	if (MaxAnisotropy)
-	{
-		ReeableAnisotropicSamplerState();
-	}
+	// Anisotropic Filtering
+	ApplySamplerFilters();
 
 	return ProxyInterface->DrawPrimitiveUP(PrimitiveType, PrimitiveCount, pVertexStreamZeroData, VertexStreamZeroStride);
 }
@@ -886,7 +959,7 @@ HRESULT m_IDirect3DDevice9Ex::BeginScene()
 		if (SUCCEEDED(ProxyInterface->GetDeviceCaps(&Caps)))
 		{
 			// Set for Anisotropic Filtering
-			MaxAnisotropy = (Config.AnisotropicFiltering == 1) ? Caps.MaxAnisotropy : min((DWORD)Config.AnisotropicFiltering, Caps.MaxAnisotropy);
+			Anisotropy.Enable(ProxyInterface, (Config.AnisotropicFiltering == 1) ? Caps.MaxAnisotropy : min((DWORD)Config.AnisotropicFiltering, Caps.MaxAnisotropy), Caps);
 		}
 		else
 		{
@@ -899,9 +972,11 @@ HRESULT m_IDirect3DDevice9Ex::BeginScene()
 	if (DeviceMultiSampleFlag)
 	{
 		ProxyInterface->SetRenderState(D3DRS_MULTISAMPLEANTIALIAS, TRUE);
+		StateCache.ClearRenderState(D3DRS_MULTISAMPLEANTIALIAS);
 		if (SetSSAA)
 		{
 			ProxyInterface->SetRenderState(D3DRS_ADAPTIVETESS_Y, MAKEFOURCC('S', 'S', 'A', 'A'));
+			StateCache.ClearRenderState(D3DRS_ADAPTIVETESS_Y);
 		}
 	}
 
@@ -916,7 +991,18 @@ HRESULT m_IDirect3DDevice9Ex::GetStreamSource(THIS_ UINT StreamNumber, IDirect3D
 
 	if (SUCCEEDED(hr) && ppStreamData)
 	{
-		*ppStreamData = ProxyAddressLookupTable->FindAddress<m_IDirect3DVertexBuffer9>(*ppStreamData);
+		// StreamHotVertexBuffers, return the managed buffer that the dynamic buffer stands in for
+		m_IDirect3DVertexBuffer9* pBuffer = (*ppStreamData && VertexStreaming.GetCount()) ? VertexStreaming.FindStreamBuffer(*ppStreamData) : nullptr;
+		if (pBuffer)
+		{
+			pBuffer->AddRef();
+			(*ppStreamData)->Release();
+			*ppStreamData = pBuffer;
+		}
+		else
+		{
+			*ppStreamData = ProxyAddressLookupTable->FindAddress<m_IDirect3DVertexBuffer9>(*ppStreamData);
+		}
 	}
 
 	return hr;
@@ -928,7 +1014,10 @@ HRESULT m_IDirect3DDevice9Ex::SetStreamSource(THIS_ UINT StreamNumber, IDirect3D
 
 	if (pStreamData)
 	{
-		pStreamData = static_cast<m_IDirect3DVertexBuffer9 *>(pStreamData)->GetProxyInterface();
+		// StreamHotVertexBuffers, state blocks record the managed buffer
+		pStreamData = IsRecordingStateBlock ?
+			static_cast<m_IDirect3DVertexBuffer9 *>(pStreamData)->GetProxyInterface() :
+			static_cast<m_IDirect3DVertexBuffer9 *>(pStreamData)->GetStreamInterface();
 	}
 
 	return ProxyInterface->SetStreamSource(StreamNumber, pStreamData, OffsetInBytes, Stride);
@@ -1006,38 +1095,56 @@ HRESULT m_IDirect3DDevice9Ex::SetTexture(DWORD Stage, IDirect3DBaseTexture9 *pTe
 		{
 		case D3DRTYPE_TEXTURE:
 			pTexture = static_cast<m_IDirect3DTexture9 *>(pTexture)->GetProxyInterface();
-			if (MaxAnisotropy && Stage > 0)
-			{
-				DisableAnisotropicSamplerState((Caps.TextureFilterCaps & D3DPTFILTERCAPS_MINFANISOTROPIC), (Caps.TextureFilterCaps & D3DPTFILTERCAPS_MAGFANISOTROPIC));
-			}
 			break;
 		case D3DRTYPE_VOLUMETEXTURE:
 			pTexture = static_cast<m_IDirect3DVolumeTexture9 *>(pTexture)->GetProxyInterface();
-			if (MaxAnisotropy && Stage > 0)
-			{
-				DisableAnisotropicSamplerState((Caps.VolumeTextureFilterCaps & D3DPTFILTERCAPS_MINFANISOTROPIC), (Caps.VolumeTextureFilterCaps & D3DPTFILTERCAPS_MAGFANISOTROPIC));
-			}
 			break;
 		case D3DRTYPE_CUBETEXTURE:
 			pTexture = static_cast<m_IDirect3DCubeTexture9 *>(pTexture)->GetProxyInterface();
-			if (MaxAnisotropy && Stage > 0)
-			{
-				DisableAnisotropicSamplerState((Caps.CubeTextureFilterCaps & D3DPTFILTERCAPS_MINFANISOTROPIC), (Caps.CubeTextureFilterCaps & D3DPTFILTERCAPS_MAGFANISOTROPIC));
-			}
 			break;
 		default:
 			return D3DERR_INVALIDCALL;
 		}
 	}
 
-	return ProxyInterface->SetTexture(Stage, pTexture);
+	// Anisotropic Filtering, the filters are checked against the texture caps at the next draw
+	if (Anisotropy.IsEnabled() && !IsRecordingStateBlock)
+	{
+		Anisotropy.SetTexture(Stage, pTexture);
+	}
+
+	if (StateCache.FilterTexture(Stage, pTexture))
+	{
+		return D3D_OK;
+	}
+
+	HRESULT hr = ProxyInterface->SetTexture(Stage, pTexture);
+
+	if (SUCCEEDED(hr))
+	{
+		StateCache.SaveTexture(Stage, pTexture);
+	}
+
+	return hr;
 }
 
 HRESULT m_IDirect3DDevice9Ex::SetTextureStageState(DWORD Stage, D3DTEXTURESTAGESTATETYPE Type, DWORD Value)
 {
 	Logging::LogDebug() << __FUNCTION__ << " (" << this << ")";
 
-	return ProxyInterface->SetTextureStageState(Stage, Type, Value);
+	if (StateCache.FilterTextureStageState(Stage, Type, Value))
+	{
+		return D3D_OK;
+	}
+
+	HRESULT hr = ProxyInterface->SetTextureStageState(Stage, Type, Value);
+
+	if (SUCCEEDED(hr))
+	{
+		StateCache.SaveTextureStageState(Stage, Type, Value);
+	}
+
+	return hr;
 }
 
 HRESULT m_IDirect3DDevice9Ex::UpdateTexture(IDirect3DBaseTexture9 *pSourceTexture, IDirect3DBaseTexture9 *pDestinationTexture)
@@ -1094,16 +1201,9 @@ HRESULT m_IDirect3DDevice9Ex::GetClipPlane(DWORD Index, float *pPlane)
 	Logging::LogDebug() << __FUNCTION__ << " (" << this << ")";
 
 	// CacheClipPlane
-	if (Config.CacheClipPlane)
+	if (ClipPlanes.IsEnabled())
 	{
-		if (!pPlane || Index >= MAX_CLIP_PLANES)
-		{
-			return D3DERR_INVALIDCALL;
-		}
-
-		memcpy(pPlane, m_storedClipPlanes[Index], sizeof(m_storedClipPlanes[0]));
-
-		return D3D_OK;
+		return ClipPlanes.GetClipPlane(Index, pPlane);
 	}
 
 	return ProxyInterface->GetClipPlane(Index, pPlane);
@@ -1113,38 +1213,21 @@ HRESULT m_IDirect3DDevice9Ex::SetClipPlane(DWORD Index, CONST float *pPlane)
 {
 	Logging::LogDebug() << __FUNCTION__ << " (" << this << ")";
 
-	// CacheClipPlane
-	if (Config.CacheClipPlane)
+	// CacheClipPlane, state blocks need the call to record it
+	if (ClipPlanes.IsEnabled() && !ClipPlanes.IsRecordingStateBlock())
 	{
-		if (!pPlane || Index >= MAX_CLIP_PLANES)
-		{
-			return D3DERR_INVALIDCALL;
-		}
-
-		isClipPlaneSet = true;
-
-		memcpy(m_storedClipPlanes[Index], pPlane, sizeof(m_storedClipPlanes[0]));
-
-		return D3D_OK;
+		return ClipPlanes.SetClipPlane(Index, pPlane);
 	}
 
 	return ProxyInterface->SetClipPlane(Index, pPlane);
 }
 
 // CacheClipPlane
-void m_IDirect3DDevice9Ex::ApplyClipPlanes()
+void m_IDirect3DDevice9Ex::ApplyClipPlanes(bool AllDirtyPlanes)
 {
 	Logging::LogDebug() << __FUNCTION__ << " (" << this << ")";
 
-	DWORD index = 0;
-	for (const auto clipPlane : m_storedClipPlanes)
-	{
-		if ((m_clipPlaneRenderState & (1 << index)) != 0)
-		{
-			ProxyInterface->SetClipPlane(index, clipPlane);
-		}
-		index++;
-	}
+	ClipPlanes.Apply(ProxyInterface, AllDirtyPlanes);
 }
 
 HRESULT m_IDirect3DDevice9Ex::Clear(DWORD Count, CONST D3DRECT *pRects, DWORD Flags, D3DCOLOR Color, float Z, DWORD Stencil)
@@ -1218,7 +1301,15 @@ HRESULT m_IDirect3DDevice9Ex::SetVertexShader(THIS_ IDirect3DVertexShader9* pSha
 		pShader = static_cast<m_IDirect3DVertexShader9 *>(pShader)->GetProxyInterface();
 	}
 
-	return ProxyInterface->SetVertexShader(pShader);
+	HRESULT hr = ProxyInterface->SetVertexShader(pShader);
+
+	// CacheClipPlane
+	if (SUCCEEDED(hr) && !ClipPlanes.IsRecordingStateBlock())
+	{
+		ClipPlanes.SetVertexShader(pShader != nullptr);
+	}
+
+	return hr;
 }
 
 HRESULT m_IDirect3DDevice9Ex::CreateQuery(THIS_ D3DQUERYTYPE Type, IDirect3DQuery9** ppQuery)
@@ -1246,7 +1337,19 @@ HRESULT m_IDirect3DDevice9Ex::SetPixelShaderConstantB(THIS_ UINT StartRegister,
 {
 	Logging::LogDebug() << __FUNCTION__ << " (" << this << ")";
 
-	return ProxyInterface->SetPixelShaderConstantB(StartRegister, pConstantData, BoolCount);
+	if (StateCache.FilterPixelShaderConstantB(StartRegister, pConstantData, BoolCount))
+	{
+		return D3D_OK;
+	}
+
+	HRESULT hr = ProxyInterface->SetPixelShaderConstantB(StartRegister, pConstantData, BoolCount);
+
+	if (SUCCEEDED(hr))
+	{
+		StateCache.SavePixelShaderConstantB(StartRegister, pConstantData, BoolCount);
+	}
+
+	return hr;
 }
 
 HRESULT m_IDirect3DDevice9Ex::GetPixelShaderConstantB(THIS_ UINT StartRegister, BOOL* pConstantData, UINT BoolCount)
@@ -1260,7 +1363,19 @@ HRESULT m_IDirect3DDevice9Ex::SetPixelShaderConstantI(THIS_ UINT StartRegister,
 {
 	Logging::LogDebug() << __FUNCTION__ << " (" << this << ")";
 
-	return ProxyInterface->SetPixelShaderConstantI(StartRegister, pConstantData, Vector4iCount);
+	if (StateCache.FilterPixelShaderConstantI(StartRegister, pConstantData, Vector4iCount))
+	{
+		return D3D_OK;
+	}
+
+	HRESULT hr = ProxyInterface->SetPixelShaderConstantI(StartRegister, pConstantData, Vector4iCount);
+
+	if (SUCCEEDED(hr))
+	{
+		StateCache.SavePixelShaderConstantI(StartRegister, pConstantData, Vector4iCount);
+	}
+
+	return hr;
 }
 
 HRESULT m_IDirect3DDevice9Ex::GetPixelShaderConstantI(THIS_ UINT StartRegister, int* pConstantData, UINT Vector4iCount)
@@ -1274,7 +1389,19 @@ HRESULT m_IDirect3DDevice9Ex::SetPixelShaderConstantF(THIS_ UINT StartRegister,
 {
 	Logging::LogDebug() << __FUNCTION__ << " (" << this << ")";
 
-	return ProxyInterface->SetPixelShaderConstantF(StartRegister, pConstantData, Vector4fCount);
+	if (StateCache.FilterPixelShaderConstantF(StartRegister, pConstantData, Vector4fCount))
+	{
+		return D3D_OK;
+	}
+
+	HRESULT hr = ProxyInterface->SetPixelShaderConstantF(StartRegister, pConstantData, Vector4fCount);
+
+	if (SUCCEEDED(hr))
+	{
+		StateCache.SavePixelShaderConstantF(StartRegister, pConstantData, Vector4fCount);
+	}
+
+	return hr;
 }
 
 HRESULT m_IDirect3DDevice9Ex::GetPixelShaderConstantF(THIS_ UINT StartRegister, float* pConstantData, UINT Vector4fCount)
@@ -1302,7 +1429,19 @@ HRESULT m_IDirect3DDevice9Ex::SetVertexShaderConstantB(THIS_ UINT StartRegister,
 {
 	Logging::LogDebug() << __FUNCTION__ << " (" << this << ")";
 
-	return ProxyInterface->SetVertexShaderConstantB(StartRegister, pConstantData, BoolCount);
+	if (StateCache.FilterVertexShaderConstantB(StartRegister, pConstantData, BoolCount))
+	{
+		return D3D_OK;
+	}
+
+	HRESULT hr = ProxyInterface->SetVertexShaderConstantB(StartRegister, pConstantData, BoolCount);
+
+	if (SUCCEEDED(hr))
+	{
+		StateCache.SaveVertexShaderConstantB(StartRegister, pConstantData, BoolCount);
+	}
+
+	return hr;
 }
 
 HRESULT m_IDirect3DDevice9Ex::GetVertexShaderConstantB(THIS_ UINT StartRegister, BOOL* pConstantData, UINT BoolCount)
@@ -1316,7 +1455,19 @@ HRESULT m_IDirect3DDevice9Ex::SetVertexShaderConstantF(THIS_ UINT StartRegister,
 {
 	Logging::LogDebug() << __FUNCTION__ << " (" << this << ")";
 
-	return ProxyInterface->SetVertexShaderConstantF(StartRegister, pConstantData, Vector4fCount);
+	if (StateCache.FilterVertexShaderConstantF(StartRegister, pConstantData, Vector4fCount))
+	{
+		return D3D_OK;
+	}
+
+	HRESULT hr = ProxyInterface->SetVertexShaderConstantF(StartRegister, pConstantData, Vector4fCount);
+
+	if (SUCCEEDED(hr))
+	{
+		StateCache.SaveVertexShaderConstantF(StartRegister, pConstantData, Vector4fCount);
+	}
+
+	return hr;
 }
 
 HRESULT m_IDirect3DDevice9Ex::GetVertexShaderConstantF(THIS_ UINT StartRegister, float* pConstantData, UINT Vector4fCount)
@@ -1330,7 +1481,19 @@ HRESULT m_IDirect3DDevice9Ex::SetVertexShaderConstantI(THIS_ UINT StartRegister,
 {
 	Logging::LogDebug() << __FUNCTION__ << " (" << this << ")";
 
-	return ProxyInterface->SetVertexShaderConstantI(StartRegister, pConstantData, Vector4iCount);
+	if (StateCache.FilterVertexShaderConstantI(StartRegister, pConstantData, Vector4iCount))
+	{
+		return D3D_OK;
+	}
+
+	HRESULT hr = ProxyInterface->SetVertexShaderConstantI(StartRegister, pConstantData, Vector4iCount);
+
+	if (SUCCEEDED(hr))
+	{
+		StateCache.SaveVertexShaderConstantI(StartRegister, pConstantData, Vector4iCount);
+	}
+
+	return hr;
 }
 
 HRESULT m_IDirect3DDevice9Ex::GetVertexShaderConstantI(THIS_ UINT StartRegister, int* pConstantData, UINT Vector4iCount)
@@ -1461,6 +1624,19 @@ HRESULT m_IDirect3DDevice9Ex::GetSamplerState(THIS_ DWORD Sampler, D3DSAMPLERSTA
 {
 	Logging::LogDebug() << __FUNCTION__ << " (" << this << ")";
 
+	// Anisotropic Filtering, return the filter set by the application
+	if (Anisotropy.IsShadowed(Sampler, Type) && !IsRecordingStateBlock)
+	{
+		if (!pValue)
+		{
+			return D3DERR_INVALIDCALL;
+		}
+
+		*pValue = Anisotropy.GetSamplerState(Sampler, Type);
+
+		return D3D_OK;
+	}
+
 	return ProxyInterface->GetSamplerState(Sampler, Type, pValue);
 }
 
@@ -1468,6 +1644,13 @@ HRESULT m_IDirect3DDevice9Ex::SetSamplerState(THIS_ DWORD Sampler, D3DSAMPLERSTA
 {
 	Logging::LogDebug() << __FUNCTION__ << " (" << this << ")";
 
+	// Filter states are not filtered when AntiAliasing is toggled by them
+	if (!(Config.AntiAliasing && (Type == D3DSAMP_MINFILTER || Type == D3DSAMP_MAGFILTER)) &&
+		StateCache.FilterSamplerState(Sampler, Type, Value))
+	{
+		return D3D_OK;
+	}
+
 	// Disable AntiAliasing when using point filtering
 	if (Config.AntiAliasing)
 	{
@@ -1481,16 +1664,30 @@ HRESULT m_IDirect3DDevice9Ex::SetSamplerState(THIS_ DWORD Sampler, D3DSAMPLERSTA
 			{
 				ProxyInterface->SetRenderState(D3DRS_MULTISAMPLEANTIALIAS, TRUE);
 			}
+			StateCache.ClearRenderState(D3DRS_MULTISAMPLEANTIALIAS);
 		}
 	}
 
 	// Enable Anisotropic Filtering
-	if (MaxAnisotropy)
+	if (Anisotropy.IsEnabled())
 	{
+		const DWORD MaxAnisotropy = Anisotropy.GetMaxAnisotropy();
+
 		if (Type == D3DSAMP_MAXANISOTROPY)
 		{
 			if (SUCCEEDED(ProxyInterface->SetSamplerState(Sampler, D3DSAMP_MAXANISOTROPY, MaxAnisotropy)))
 			{
+				StateCache.SaveSamplerState(Sampler, Type, Value);
+				return D3D_OK;
+			}
+		}
+		else if (Anisotropy.IsShadowed(Sampler, Type))
+		{
+			// Filter is sent at the next draw, recorded state blocks keep the application's filter
+			if (!IsRecordingStateBlock)
+			{
+				Anisotropy.SetSamplerState(Sampler, Type, Value);
+				StateCache.SaveSamplerState(Sampler, Type, Value);
 				return D3D_OK;
 			}
 		}
@@ -1499,64 +1696,20 @@ HRESULT m_IDirect3DDevice9Ex::SetSamplerState(THIS_ DWORD Sampler, D3DSAMPLERSTA
 			if (SUCCEEDED(ProxyInterface->SetSamplerState(Sampler, D3DSAMP_MAXANISOTROPY, MaxAnisotropy)) &&
 				SUCCEEDED(ProxyInterface->SetSamplerState(Sampler, Type, D3DTEXF_ANISOTROPIC)))
 			{
-				if (!isAnisotropySet)
-				{
-					isAnisotropySet = true;
-					Logging::Log() << "Setting Anisotropic Filtering at " << MaxAnisotropy << "x";
-				}
+				StateCache.SaveSamplerState(Sampler, Type, Value);
 				return D3D_OK;
 			}
 		}
 	}
 
-	return ProxyInterface->SetSamplerState(Sampler, Type, Value);
-}
+	HRESULT hr = ProxyInterface->SetSamplerState(Sampler, Type, Value);
 
-void m_IDirect3DDevice9Ex::DisableAnisotropicSamplerState(bool AnisotropyMin, bool AnisotropyMag)
-{
-	DWORD Value = 0;
-	for (int x = 0; x < 4; x++)
+	if (SUCCEEDED(hr))
 	{
-		if (!AnisotropyMin)	// Anisotropic Min Filter is not supported for multi-stage textures
-		{
-			if (SUCCEEDED(ProxyInterface->GetSamplerState(x, D3DSAMP_MINFILTER, &Value)) && Value == D3DTEXF_ANISOTROPIC &&
-				SUCCEEDED(ProxyInterface->SetSamplerState(x, D3DSAMP_MINFILTER, D3DTEXF_LINEAR)))
-			{
-				AnisotropyDisabledFlag = true;
-			}
-		}
-		if (!AnisotropyMag)	// Anisotropic Mag Filter is not supported for multi-stage textures
-		{
-			if (SUCCEEDED(ProxyInterface->GetSamplerState(x, D3DSAMP_MAGFILTER, &Value)) && Value == D3DTEXF_ANISOTROPIC &&
-				SUCCEEDED(ProxyInterface->SetSamplerState(x, D3DSAMP_MAGFILTER, D3DTEXF_LINEAR)))
-			{
-				AnisotropyDisabledFlag = true;
-			}
-		}
+		StateCache.SaveSamplerState(Sampler, Type, Value);
 	}
-}
 
-void m_IDirect3DDevice9Ex::ReeableAnisotropicSamplerState()
-{
-	if (AnisotropyDisabledFlag)
-	{
-		bool Flag = false;
-		DWORD Value = 0;
-		for (int x = 0; x < 4; x++)
-		{
-			if (!(SUCCEEDED(ProxyInterface->GetSamplerState(x, D3DSAMP_MINFILTER, &Value)) && Value == D3DTEXF_LINEAR &&
-				SUCCEEDED(ProxyInterface->SetSamplerState(x, D3DSAMP_MINFILTER, D3DTEXF_ANISOTROPIC))))
-			{
-				Flag = true;	// Unable to re-eanble Anisotropic filtering
-			}
-			if (!(SUCCEEDED(ProxyInterface->GetSamplerState(x, D3DSAMP_MAGFILTER, &Value)) && Value == D3DTEXF_LINEAR &&
-				SUCCEEDED(ProxyInterface->SetSamplerState(x, D3DSAMP_MAGFILTER, D3DTEXF_ANISOTROPIC))))
-			{
-				Flag = true;	// Unable to re-eanble Anisotropic filtering
-			}
-		}
-		AnisotropyDisabledFlag = Flag;
-	}
+	return hr;
 }
 
 HRESULT m_IDirect3DDevice9Ex::SetDepthStencilSurface(THIS_ IDirect3DSurface9* pNewZStencil)
@@ -1714,7 +1867,6 @@ HRESULT m_IDirect3DDevice9Ex::StretchRect(THIS_ IDirect3DSurface9* pSourceSurfac
 	return ProxyInterface->StretchRect(pSourceSurface, pSourceRect, pDestSurface, pDestRect, Filter);
 }
 
-// Stretch source rect to destination rect
 HRESULT m_IDirect3DDevice9Ex::StretchRectFake(THIS_ IDirect3DSurface9* pSourceSurface, CONST RECT* pSourceRect, IDirect3DSurface9* pDestSurface, CONST RECT* pDestRect, D3DTEXTUREFILTERTYPE Filter)
 {
 	Logging::LogDebug() << __FUNCTION__ << " (" << this << ")";
@@ -1790,36 +1942,21 @@ HRESULT m_IDirect3DDevice9Ex::StretchRectFake(THIS_ IDirect3DSurface9* pSourceSu
 	LONG SrcRectWidth = SrcRect.right - SrcRect.left;
 	LONG SrcRectHeight = SrcRect.bottom - SrcRect.top;
 
-	// Get ratio
-	float WidthRatio = (float)SrcRectWidth / (float)DestRectWidth;
-	float HeightRatio = (float)SrcRectHeight / (float)DestRectHeight;
+	// Get surface pointers
+	BYTE* pSrc = (BYTE*)SrcLockRect.pBits + (SrcRect.top * SrcLockRect.Pitch) + (SrcRect.left * ByteCount);
+	BYTE* pDest = (BYTE*)DestLockRect.pBits + (DestRect.top * DestLockRect.Pitch) + (DestRect.left * ByteCount);
 
-	// Copy memory using color key
-	switch (ByteCount)
+	// Unsupported surface bit count
+	if (ByteCount < 1 || ByteCount > 4)
 	{
-	case 1: // 8-bit surfaces
-	case 2: // 16-bit surfaces
-	case 3: // 24-bit surfaces
-	case 4: // 32-bit surfaces
-	{
-		for (LONG y = 0; y < DestRectHeight; y++)
-		{
-			DWORD StartDestLoc = ((y + DestRect.top) * DestLockRect.Pitch) + (DestRect.left * ByteCount);
-			DWORD StartSrcLoc = ((((DWORD)((float)y * HeightRatio)) + SrcRect.top) * SrcLockRect.Pitch) + (SrcRect.left * ByteCount);
-
-			for (LONG x = 0; x < DestRectWidth; x++)
-			{
-				memcpy((BYTE*)DestLockRect.pBits + StartDestLoc + x * ByteCount, (BYTE*)((BYTE*)SrcLockRect.pBits + StartSrcLoc + ((DWORD)((float)x * WidthRatio)) * ByteCount), ByteCount);
-			}
-		}
-		break;
-	}
-	default: // Unsupported surface bit count
 		pSourceSurface->UnlockRect();
 		pDestSurface->UnlockRect();
 		return D3DERR_INVALIDCALL;
 	}
 
+	// Copy memory, point filtered stretch shared with DirectDraw Blt
+	Blitter::Blt(pDest, DestLockRect.Pitch, DestRectWidth, DestRectHeight, pSrc, SrcLockRect.Pitch, SrcRectWidth, SrcRectHeight, ByteCount, 0, 0, 0);
+
 	// Unlock rect and return
 	pSourceSurface->UnlockRect();
 	pDestSurface->UnlockRect();
@@ -1873,48 +2010,8 @@ HRESULT m_IDirect3DDevice9Ex::FakeGetFrontBufferData(THIS_ UINT iSwapChain, IDir
 	RectSrc.right = RectSrc.left + rcClient.right;
 	RectSrc.bottom = RectSrc.top + rcClient.bottom;
 
-	// Create new surface to hold data
-	IDirect3DSurface9 *pSrcSurface = nullptr;
-	if (FAILED(ProxyInterface->CreateOffscreenPlainSurface(max(screenWidth, RectSrc.right), max(screenHeight, RectSrc.bottom), Desc.Format, Desc.Pool, &pSrcSurface, nullptr)))
-	{
-		return D3DERR_INVALIDCALL;
-	}
-
-	// Get FrontBuffer data to new surface
-	HRESULT hr = ProxyInterface->GetFrontBufferData(iSwapChain, pSrcSurface);
-	if (FAILED(hr))
-	{
-		pSrcSurface->Release();
-		return hr;
-	}
-
-	// Copy data to DestSurface
-	hr = D3DERR_INVALIDCALL;
-	if (rcClient.left == 0 && rcClient.top == 0 && (LONG)Desc.Width == rcClient.right && (LONG)Desc.Height == rcClient.bottom)
-	{
-		POINT PointDest = { 0, 0 };
-		hr = CopyRects(pSrcSurface, &RectSrc, 1, pDestSurface, &PointDest);
-	}
-
-	// Try using StretchRect
-	if (FAILED(hr))
-	{
-		IDirect3DSurface9 *pTmpSurface = nullptr;
-		if (SUCCEEDED(ProxyInterface->CreateOffscreenPlainSurface(Desc.Width, Desc.Height, Desc.Format, Desc.Pool, &pTmpSurface, nullptr)))
-		{
-			if (SUCCEEDED(StretchRect(pSrcSurface, &RectSrc, pTmpSurface, nullptr, D3DTEXF_NONE)))
-			{
-				POINT PointDest = { 0, 0 };
-				RECT Rect = { 0, 0, (LONG)Desc.Width, (LONG)Desc.Height };
-				hr = CopyRects(pTmpSurface, &Rect, 1, pDestSurface, &PointDest);
-			}
-			pTmpSurface->Release();
-		}
-	}
-
-	// Release surface
-	pSrcSurface->Release();
-	return hr;
+	// Get FrontBuffer data and copy it to DestSurface
+	return FrontBuffer.GetFrontBufferData(ProxyInterface, iSwapChain, (UINT)max(screenWidth, RectSrc.right), (UINT)max(screenHeight, RectSrc.bottom), RectSrc, pDestSurface);
 }
 
 HRESULT m_IDirect3DDevice9Ex::GetRenderTargetData(THIS_ IDirect3DSurface9* pRenderTarget, IDirect3DSurface9* pDestSurface)
@@ -2030,11 +2127,13 @@ HRESULT m_IDirect3DDevice9Ex::ComposeRects(THIS_ IDirect3DSurface9* pSrc, IDirec
 
 	if (pSrcRectDescs)
 	{
+		static_cast<m_IDirect3DVertexBuffer9 *>(pSrcRectDescs)->StopStreaming();
 		pSrcRectDescs = static_cast<m_IDirect3DVertexBuffer9 *>(pSrcRectDescs)->GetProxyInterface();
 	}
 
 	if (pDstRectDescs)
 	{
+		static_cast<m_IDirect3DVertexBuffer9 *>(pDstRectDescs)->StopStreaming();
 		pDstRectDescs = static_cast<m_IDirect3DVertexBuffer9 *>(pDstRectDescs)->GetProxyInterface();
 	}
 
@@ -2051,6 +2150,8 @@ HRESULT m_IDirect3DDevice9Ex::PresentEx(THIS_ CONST RECT* pSourceRect, CONST REC
 		return D3DERR_INVALIDCALL;
 	}
 
+	EndFrame();
+
 	return ProxyInterfaceEx->PresentEx(pSourceRect, pDestRect, hDestWindowOverride, pDirtyRegion, dwFlags);
 }
 
@@ -9,6 +9,7 @@ private:
 	LPDIRECT3DDEVICE9EX ProxyInterfaceEx = nullptr;
 	m_IDirect3D9Ex* m_pD3DEx;
 	REFIID WrapperID;
+	LONG RefCount = 1;			// References held by the application, pooled resources add references to the proxy device
 
 	D3DCAPS9 Caps = {};
 
@@ -17,17 +18,25 @@ private:
 	bool SetSSAA = false;
 
 	// Anisotropic Filtering
-	DWORD MaxAnisotropy = 0;
-	bool isAnisotropySet = false;
-	bool AnisotropyDisabledFlag = false;	// Tracks when Anisotropic Fintering was disabled becasue lack of multi-stage texture support
-	void DisableAnisotropicSamplerState(bool AnisotropyMin, bool AnisotropyMag);
-	void ReeableAnisotropicSamplerState();
+	AnisotropyOverride Anisotropy;
+
+	// Set while a state block is recorded
+	bool IsRecordingStateBlock = false;
 
 	// For CacheClipPlane
-	bool isClipPlaneSet = false;
-	DWORD m_clipPlaneRenderState = 0;
-	static constexpr size_t MAX_CLIP_PLANES = 6;
-	float m_storedClipPlanes[MAX_CLIP_PLANES][4];
+	ClipPlaneCache ClipPlanes { Config.CacheClipPlane != 0 };
+
+	// For FilterRedundantStates
+	DeviceStateCache StateCache { Config.FilterRedundantStates };
+
+	// For emulated locking of multisampled surfaces
+	ScratchSurfacePool ScratchPool;
+
+	// For FakeGetFrontBufferData
+	FrontBufferCapture FrontBuffer { Config.AsyncFrontBufferCapture };
+
+	// For StreamHotVertexBuffers
+	VertexBufferStreaming VertexStreaming { Config.StreamHotVertexBuffers };
 
 	// For Reset & ResetEx
 	void ClearVars(D3DPRESENT_PARAMETERS* pPresentationParameters);
@@ -151,7 +160,7 @@ public:
 	STDMETHOD(GetLightEnable)(THIS_ DWORD Index, BOOL* pEnable);
 	STDMETHOD(SetClipPlane)(THIS_ DWORD Index, CONST float* pPlane);
 	STDMETHOD(GetClipPlane)(THIS_ DWORD Index, float* pPlane);
-	void ApplyClipPlanes();
+	void ApplyClipPlanes(bool AllDirtyPlanes = false);
 	STDMETHOD(SetRenderState)(THIS_ D3DRENDERSTATETYPE State, DWORD Value);
 	STDMETHOD(GetRenderState)(THIS_ D3DRENDERSTATETYPE State, DWORD* pValue);
 	STDMETHOD(CreateStateBlock)(THIS_ D3DSTATEBLOCKTYPE Type, IDirect3DStateBlock9** ppSB);
@@ -234,4 +243,18 @@ public:
 
 	// Helper functions
 	LPDIRECT3DDEVICE9 GetProxyInterface() { return ProxyInterface; }
+	void InvalidateStateCache() { StateCache.Invalidate(); }
+	void ReloadClipPlanes() { if (ClipPlanes.IsEnabled()) { ClipPlanes.Reload(ProxyInterface); } }
+	void ApplySamplerFilters() { if (Anisotropy.IsEnabled()) { Anisotropy.Apply(ProxyInterface); } }
+	void ReloadSamplerFilters() { if (Anisotropy.IsEnabled()) { Anisotropy.Reload(ProxyInterface); } }
+	void BeginSamplerFilterCapture() { if (Anisotropy.IsEnabled()) { Anisotropy.BeginCapture(ProxyInterface); } }
+	void EndSamplerFilterCapture() { if (Anisotropy.IsEnabled()) { Anisotropy.EndCapture(); } }
+	ScratchSurfacePool& GetScratchPool() { return ScratchPool; }
+	VertexBufferStreaming& GetVertexBufferStreaming() { return VertexStreaming; }
+	void ApplyVertexBuffers() { VertexStreaming.Apply(); }
+	void ReloadVertexBuffers() { VertexStreaming.Reload(ProxyInterface); }
+	void BeginVertexBufferCapture() { VertexStreaming.BeginCapture(ProxyInterface); }
+	void EndVertexBufferCapture() { VertexStreaming.EndCapture(ProxyInterface); }
+	void EndFrame() { VertexStreaming.NextFrame(); }
+	bool IsRecording() { return IsRecordingStateBlock; }
 };
@@ -73,12 +73,42 @@ HRESULT m_IDirect3DStateBlock9::Capture(THIS)
 {
 	Logging::LogDebug() << __FUNCTION__ << " (" << this << ")";
 
-	return ProxyInterface->Capture();
+	// Make sure the device has the current clip planes before they are captured
+	m_pDeviceEx->ApplyClipPlanes(true);
+
+	// State blocks capture the application's filters and the managed vertex buffers in place of the anisotropic filters and the dynamic buffers
+	m_pDeviceEx->BeginSamplerFilterCapture();
+	m_pDeviceEx->BeginVertexBufferCapture();
+
+	HRESULT hr = ProxyInterface->Capture();
+
+	m_pDeviceEx->EndVertexBufferCapture();
+	m_pDeviceEx->EndSamplerFilterCapture();
+
+	return hr;
 }
 
 HRESULT m_IDirect3DStateBlock9::Apply(THIS)
 {
 	Logging::LogDebug() << __FUNCTION__ << " (" << this << ")";
 
-	return ProxyInterface->Apply();
+	// Clip planes the state block does not set keep the application's planes
+	m_pDeviceEx->ApplyClipPlanes(true);
+
+	// Filters the state block does not set keep the application's filters, not the anisotropic filters
+	m_pDeviceEx->BeginSamplerFilterCapture();
+
+	HRESULT hr = ProxyInterface->Apply();
+
+	if (SUCCEEDED(hr))
+	{
+		m_pDeviceEx->InvalidateStateCache();
+		m_pDeviceEx->ReloadClipPlanes();
+		m_pDeviceEx->ReloadSamplerFilters();
+		m_pDeviceEx->ReloadVertexBuffers();
+	}
+
+	m_pDeviceEx->EndSamplerFilterCapture();
+
+	return hr;
 }
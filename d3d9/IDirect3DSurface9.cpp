@@ -55,7 +55,7 @@ ULONG m_IDirect3DSurface9::Release(THIS)
 	if (ref == 0 && pEmuSurface)
 	{
 		pEmuSurface->UnlockRect();
-		pEmuSurface->Release();
+		m_pDeviceEx->GetScratchPool().Release(pEmuSurface, EmuSize);
 		pEmuSurface = nullptr;
 	}
 
@@ -164,8 +164,11 @@ HRESULT m_IDirect3DSurface9::LockRect(THIS_ D3DLOCKED_RECT* pLockedRect, CONST R
 		D3DSURFACE_DESC Desc;
 		if (SUCCEEDED(GetDesc(&Desc)))
 		{
-			// Create new surface for lock
-			if (SUCCEEDED(m_pDeviceEx->CreateOffscreenPlainSurface(Desc.Width, Desc.Height, Desc.Format, D3DPOOL_SCRATCH, &pEmuSurface, nullptr)))
+			ScratchSurfacePool& ScratchPool = m_pDeviceEx->GetScratchPool();
+
+			// Get surface for lock
+			pEmuSurface = ScratchPool.Acquire(m_pDeviceEx, Desc.Width, Desc.Height, Desc.Format);
+			if (pEmuSurface)
 			{
 				EmuReadOnly = (Flags & D3DLOCK_READONLY);
 				EmuRect.left = 0;
@@ -183,6 +186,10 @@ HRESULT m_IDirect3DSurface9::LockRect(THIS_ D3DLOCKED_RECT* pLockedRect, CONST R
 				D3DLOCKED_RECT LockedRect = {};
 				if (SUCCEEDED(pEmuSurface->LockRect(&LockedRect, &EmuRect, Flags)))
 				{
+					EmuSize = LockedRect.Pitch * Desc.Height;
+					EmuRectSize = (UINT)((ULONGLONG)LockedRect.Pitch * (EmuRect.right - EmuRect.left) / Desc.Width) * (EmuRect.bottom - EmuRect.top);
+					ScratchPool.AddBytesCopied(EmuRectSize);
+
 					pLockedRect->pBits = LockedRect.pBits;
 					pLockedRect->Pitch = LockedRect.Pitch;
 					return D3D_OK;
@@ -223,6 +230,9 @@ HRESULT m_IDirect3DSurface9::UnlockRect(THIS)
 	{
 		hr = pEmuSurface->UnlockRect();
 		POINT Point = { EmuRect.left, EmuRect.top };
+		ScratchSurfacePool& ScratchPool = m_pDeviceEx->GetScratchPool();
+
+		// Read only locks did not change the data so there is nothing to copy back
 		if (!EmuReadOnly)
 		{
 			// Copy emulated surface data
@@ -230,8 +240,9 @@ HRESULT m_IDirect3DSurface9::UnlockRect(THIS)
 			{
 				LOG_LIMIT(100, __FUNCTION__ << " Error: copying emulated surface!");
 			}
+			ScratchPool.AddBytesCopied(EmuRectSize);
 		}
-		pEmuSurface->Release();
+		ScratchPool.Release(pEmuSurface, EmuSize);
 		pEmuSurface = nullptr;
 	}
 	else
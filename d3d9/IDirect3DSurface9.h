@@ -10,6 +10,8 @@ private:
 	bool IsLocked = false;
 	bool EmuReadOnly = false;
 	RECT EmuRect = {};
+	UINT EmuSize = 0;			// Bytes used by the emulated surface, needed when giving it back to the pool
+	UINT EmuRectSize = 0;		// Bytes copied for the locked rect
 	IDirect3DSurface9* pEmuSurface = nullptr;
 
 public:
@@ -50,7 +50,15 @@ ULONG m_IDirect3DVertexBuffer9::Release(THIS)
 {
 	Logging::LogDebug() << __FUNCTION__ << " (" << this << ")";
 
-	return ProxyInterface->Release();
+	ULONG ref = ProxyInterface->Release();
+
+	// The device keeps its own reference to the dynamic buffer while it is bound
+	if (ref == 0 && StreamBuffer)
+	{
+		ReleaseStream(true);
+	}
+
+	return ref;
 }
 
 HRESULT m_IDirect3DVertexBuffer9::GetDevice(THIS_ IDirect3DDevice9** ppDevice)
@@ -122,6 +130,12 @@ HRESULT m_IDirect3DVertexBuffer9::Lock(THIS_ UINT OffsetToLock, UINT SizeToLock,
 {
 	Logging::LogDebug() << __FUNCTION__ << " (" << this << ")";
 
+	// StreamHotVertexBuffers
+	if (CanStream)
+	{
+		return LockStream(OffsetToLock, SizeToLock, ppbData, Flags);
+	}
+
 	return ProxyInterface->Lock(OffsetToLock, SizeToLock, ppbData, Flags);
 }
 
@@ -129,6 +143,12 @@ HRESULT m_IDirect3DVertexBuffer9::Unlock(THIS)
 {
 	Logging::LogDebug() << __FUNCTION__ << " (" << this << ")";
 
+	// StreamHotVertexBuffers
+	if (CanStream)
+	{
+		return UnlockStream();
+	}
+
 	return ProxyInterface->Unlock();
 }
 
@@ -138,3 +158,203 @@ HRESULT m_IDirect3DVertexBuffer9::GetDesc(THIS_ D3DVERTEXBUFFER_DESC *pDesc)
 
 	return ProxyInterface->GetDesc(pDesc);
 }
+
+void m_IDirect3DVertexBuffer9::AddDirtyRange(UINT Offset, UINT Size)
+{
+	if (!Size)
+	{
+		return;
+	}
+
+	if (DirtyStart == DirtyEnd)
+	{
+		DirtyStart = Offset;
+		DirtyEnd = Offset + Size;
+	}
+	else
+	{
+		DirtyStart = min(DirtyStart, Offset);
+		DirtyEnd = max(DirtyEnd, Offset + Size);
+	}
+}
+
+HRESULT m_IDirect3DVertexBuffer9::LockStream(UINT OffsetToLock, UINT SizeToLock, void** ppbData, DWORD Flags)
+{
+	VertexBufferStreaming& Streaming = m_pDeviceEx->GetVertexBufferStreaming();
+
+	// Held so an upload on the render thread cannot clear a write made by this lock
+	Utils::ScopedCriticalSection ThreadLock(Streaming.GetLock());
+
+	// Streaming starts between locks, and not while a state block is recorded since the stream sources are changed
+	if (!StreamBuffer && !(Flags & D3DLOCK_READONLY) && VertexBufferStreaming::RecordWrite(Profile, Streaming.GetFrame()) &&
+		!LockCount && !m_pDeviceEx->IsRecording())
+	{
+		StartStreaming();
+	}
+
+	if (!StreamBuffer)
+	{
+		HRESULT hr = ProxyInterface->Lock(OffsetToLock, SizeToLock, ppbData, Flags);
+
+		if (SUCCEEDED(hr))
+		{
+			LockCount++;
+		}
+
+		return hr;
+	}
+
+	if (!ppbData || OffsetToLock > Desc.Size || SizeToLock > Desc.Size - OffsetToLock)
+	{
+		return D3DERR_INVALIDCALL;
+	}
+
+	// Discard and no overwrite flags are not valid for managed buffers and are ignored, the upload picks its own flags
+	// A size of zero locks the rest of the buffer
+	*ppbData = Shadow.data() + OffsetToLock;
+	if (!(Flags & D3DLOCK_READONLY))
+	{
+		AddDirtyRange(OffsetToLock, SizeToLock ? SizeToLock : Desc.Size - OffsetToLock);
+	}
+	LockCount++;
+
+	return D3D_OK;
+}
+
+HRESULT m_IDirect3DVertexBuffer9::UnlockStream()
+{
+	Utils::ScopedCriticalSection ThreadLock(m_pDeviceEx->GetVertexBufferStreaming().GetLock());
+
+	if (!StreamBuffer)
+	{
+		HRESULT hr = ProxyInterface->Unlock();
+
+		if (SUCCEEDED(hr) && LockCount)
+		{
+			LockCount--;
+		}
+
+		return hr;
+	}
+
+	if (!LockCount)
+	{
+		return D3DERR_INVALIDCALL;
+	}
+
+	if (--LockCount == 0 && DirtyStart != DirtyEnd)
+	{
+		m_pDeviceEx->GetVertexBufferStreaming().SetDirty();
+	}
+
+	return D3D_OK;
+}
+
+void m_IDirect3DVertexBuffer9::StartStreaming()
+{
+	LPDIRECT3DDEVICE9 pDevice = m_pDeviceEx->GetProxyInterface();
+
+	HRESULT hr = pDevice->CreateVertexBuffer(Desc.Size, Desc.Usage | D3DUSAGE_DYNAMIC | D3DUSAGE_WRITEONLY, Desc.FVF, D3DPOOL_DEFAULT, &StreamBuffer, nullptr);
+	if (FAILED(hr))
+	{
+		// Keep using the managed buffer, such as when video memory is full
+		LOG_LIMIT(100, __FUNCTION__ << " Warning: failed to create dynamic vertex buffer: " << (D3DERR)hr << " " << Desc.Size);
+		StreamBuffer = nullptr;
+		CanStream = false;
+		return;
+	}
+
+	void* pData = nullptr;
+	if (FAILED(ProxyInterface->Lock(0, 0, &pData, D3DLOCK_READONLY)))
+	{
+		StreamBuffer->Release();
+		StreamBuffer = nullptr;
+		CanStream = false;
+		return;
+	}
+	Shadow.assign((BYTE*)pData, (BYTE*)pData + Desc.Size);
+	ProxyInterface->Unlock();
+
+	// The dynamic buffer is filled at the next draw
+	AddDirtyRange(0, Desc.Size);
+	m_pDeviceEx->GetVertexBufferStreaming().Add(pDevice, this);
+}
+
+// Called by VertexBufferStreaming with its lock held
+bool m_IDirect3DVertexBuffer9::UploadStream()
+{
+	if (DirtyStart == DirtyEnd)
+	{
+		return true;
+	}
+
+	if (LockCount)
+	{
+		return false;
+	}
+
+	VertexBufferStreaming& Streaming = m_pDeviceEx->GetVertexBufferStreaming();
+
+	// When part of the buffer was written, the rest of the dynamic buffer is current and only the written range is copied with no overwrite
+	// Discard gives a new buffer when the GPU still uses the old one, it is used when the whole buffer was written or a draw in this frame
+	// already read the buffer, since that draw is likely still pending and would see the new data
+	const bool IsPartial = (DirtyEnd - DirtyStart < Desc.Size && LastUploadFrame != Streaming.GetFrame());
+	const UINT Offset = IsPartial ? DirtyStart : 0;
+	const UINT Size = IsPartial ? DirtyEnd - DirtyStart : Desc.Size;
+
+	void* pData = nullptr;
+	if (SUCCEEDED(StreamBuffer->Lock(Offset, Size, &pData, IsPartial ? D3DLOCK_NOOVERWRITE : D3DLOCK_DISCARD)))
+	{
+		memcpy(pData, Shadow.data() + Offset, Size);
+		StreamBuffer->Unlock();
+		DirtyStart = 0;
+		DirtyEnd = 0;
+		LastUploadFrame = Streaming.GetFrame();
+		Streaming.AddUpload(Size);
+	}
+
+	// The upload is tried again after the next unlock if the device is lost
+	return true;
+}
+
+// Copies the data back to the managed buffer and binds the managed buffer again
+// Used before a reset, since default pool buffers must be released first, and when the managed buffer is used outside of a stream
+void m_IDirect3DVertexBuffer9::StopStreaming()
+{
+	Utils::ScopedCriticalSection ThreadLock(m_pDeviceEx->GetVertexBufferStreaming().GetLock());
+
+	if (!StreamBuffer)
+	{
+		return;
+	}
+
+	void* pData = nullptr;
+	if (SUCCEEDED(ProxyInterface->Lock(0, 0, &pData, 0)))
+	{
+		memcpy(pData, Shadow.data(), Desc.Size);
+		ProxyInterface->Unlock();
+	}
+
+	ReleaseStream(false);
+}
+
+void m_IDirect3DVertexBuffer9::ReleaseStream(bool IsBufferReleased)
+{
+	Utils::ScopedCriticalSection ThreadLock(m_pDeviceEx->GetVertexBufferStreaming().GetLock());
+
+	if (!StreamBuffer)
+	{
+		return;
+	}
+
+	m_pDeviceEx->GetVertexBufferStreaming().Remove(IsBufferReleased ? nullptr : m_pDeviceEx->GetProxyInterface(), this);
+
+	StreamBuffer->Release();
+	StreamBuffer = nullptr;
+	std::vector<BYTE>().swap(Shadow);
+	Profile = {};
+	LockCount = 0;
+	DirtyStart = 0;
+	DirtyEnd = 0;
+	LastUploadFrame = 0;
+}
@@ -6,16 +6,44 @@ private:
 	LPDIRECT3DVERTEXBUFFER9 ProxyInterface;
 	m_IDirect3DDevice9Ex* m_pDeviceEx;
 
+	// For StreamHotVertexBuffers
+	bool CanStream = false;
+	D3DVERTEXBUFFER_DESC Desc = {};
+	VertexBufferStreaming::PROFILE Profile;
+	UINT LockCount = 0;
+	UINT DirtyStart = 0;							// Range written since the last upload, empty when nothing was written
+	UINT DirtyEnd = 0;
+	DWORD LastUploadFrame = 0;						// Draws from this frame can still read the dynamic buffer
+	LPDIRECT3DVERTEXBUFFER9 StreamBuffer = nullptr;	// Dynamic buffer bound in place of the managed buffer
+	std::vector<BYTE> Shadow;						// Copy of the buffer that is locked by the application while streaming
+
+	void AddDirtyRange(UINT Offset, UINT Size);
+	HRESULT LockStream(UINT OffsetToLock, UINT SizeToLock, void** ppbData, DWORD Flags);
+	HRESULT UnlockStream();
+	void StartStreaming();
+	void ReleaseStream(bool IsBufferReleased);
+
 public:
 	m_IDirect3DVertexBuffer9(LPDIRECT3DVERTEXBUFFER9 pBuffer8, m_IDirect3DDevice9Ex* pDevice) : ProxyInterface(pBuffer8), m_pDeviceEx(pDevice)
 	{
 		LOG_LIMIT(3, "Creating interface " << __FUNCTION__ << " (" << this << ")");
 
 		pDevice->ProxyAddressLookupTable->SaveAddress(this, ProxyInterface);
+
+		// Software processing buffers are read by the CPU, so they are not moved to video memory
+		if (pDevice->GetVertexBufferStreaming().IsEnabled() && SUCCEEDED(ProxyInterface->GetDesc(&Desc)))
+		{
+			CanStream = (Desc.Pool == D3DPOOL_MANAGED && Desc.Size && !(Desc.Usage & D3DUSAGE_SOFTWAREPROCESSING));
+		}
 	}
 	~m_IDirect3DVertexBuffer9()
 	{
 		LOG_LIMIT(3, __FUNCTION__ << " (" << this << ")" << " deleting interface!");
+
+		if (StreamBuffer)
+		{
+			StreamBuffer->Release();
+		}
 	}
 
 	/*** IUnknown methods ***/
@@ -38,4 +66,8 @@ public:
 
 	// Helper functions
 	LPDIRECT3DVERTEXBUFFER9 GetProxyInterface() { return ProxyInterface; }
+	LPDIRECT3DVERTEXBUFFER9 GetStreamBuffer() { return StreamBuffer; }
+	LPDIRECT3DVERTEXBUFFER9 GetStreamInterface() { return StreamBuffer ? StreamBuffer : ProxyInterface; }
+	bool UploadStream();
+	void StopStreaming();
 };
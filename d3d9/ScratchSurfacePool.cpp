@@ -0,0 +1,93 @@
+/**
+* Copyright (C) 2023 Elisha Riedlinger
+*
+* This software is  provided 'as-is', without any express  or implied  warranty. In no event will the
+* authors be held liable for any damages arising from the use of this software.
+* Permission  is granted  to anyone  to use  this software  for  any  purpose,  including  commercial
+* applications, and to alter it and redistribute it freely, subject to the following restrictions:
+*
+*   1. The origin of this software must not be misrepresented; you must not claim that you  wrote the
+*      original  software. If you use this  software  in a product, an  acknowledgment in the product
+*      documentation would be appreciated but is not required.
+*   2. Altered source versions must  be plainly  marked as such, and  must not be  misrepresented  as
+*      being the original software.
+*   3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "d3d9.h"
+
+void ScratchSurfacePool::LogCounters()
+{
+	if (!HitCount && !MissCount)
+	{
+		return;
+	}
+
+	Logging::Log() << "Scratch surface pool:" <<
+		" Hits " << HitCount << "/" << HitCount + MissCount <<
+		" BytesCopied " << BytesCopied;
+}
+
+void ScratchSurfacePool::Trim(UINT MaxSize)
+{
+	while (PoolSize > MaxSize && !FreeSurfaces.empty())
+	{
+		auto Oldest = std::min_element(FreeSurfaces.begin(), FreeSurfaces.end(),
+			[](const ENTRY& a, const ENTRY& b) { return a.LastUsed < b.LastUsed; });
+
+		PoolSize -= Oldest->Size;
+		Oldest->pSurface->Release();
+		FreeSurfaces.erase(Oldest);
+	}
+}
+
+IDirect3DSurface9* ScratchSurfacePool::Acquire(IDirect3DDevice9* pDevice, UINT Width, UINT Height, D3DFORMAT Format)
+{
+	{
+		Utils::ScopedCriticalSection ThreadLock(PoolLock);
+
+		for (auto it = FreeSurfaces.begin(); it != FreeSurfaces.end(); it++)
+		{
+			if (it->Width == Width && it->Height == Height && it->Format == Format)
+			{
+				IDirect3DSurface9* pSurface = it->pSurface;
+				PoolSize -= it->Size;
+				FreeSurfaces.erase(it);
+				HitCount++;
+				return pSurface;
+			}
+		}
+
+		MissCount++;
+	}
+
+	IDirect3DSurface9* pSurface = nullptr;
+	if (FAILED(pDevice->CreateOffscreenPlainSurface(Width, Height, Format, D3DPOOL_SCRATCH, &pSurface, nullptr)))
+	{
+		return nullptr;
+	}
+
+	return pSurface;
+}
+
+void ScratchSurfacePool::Release(IDirect3DSurface9* pSurface, UINT Size)
+{
+	if (!pSurface)
+	{
+		return;
+	}
+
+	D3DSURFACE_DESC Desc;
+	if (Size > MaxPoolSize || FAILED(pSurface->GetDesc(&Desc)))
+	{
+		pSurface->Release();
+		return;
+	}
+
+	Utils::ScopedCriticalSection ThreadLock(PoolLock);
+
+	Trim(MaxPoolSize - Size);
+
+	FreeSurfaces.push_back({ pSurface, Desc.Width, Desc.Height, Desc.Format, Size, ++UseCount });
+	PoolSize += Size;
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+// Keeps the scratch surfaces used to emulate locking multisampled surfaces so they are not created on every lock
+class ScratchSurfacePool
+{
+private:
+	static constexpr UINT MaxPoolSize = 64 * 1024 * 1024;		// Bytes kept in free surfaces before the least recently used ones are released
+
+	struct ENTRY
+	{
+		IDirect3DSurface9* pSurface;
+		UINT Width;
+		UINT Height;
+		D3DFORMAT Format;
+		UINT Size;
+		ULONGLONG LastUsed;
+	};
+	std::vector<ENTRY> FreeSurfaces;
+	UINT PoolSize = 0;
+	ULONGLONG UseCount = 0;
+	Utils::CriticalSection PoolLock;	// Multithreaded devices can lock surfaces from several threads
+
+	// Counters
+	ULONGLONG HitCount = 0;
+	ULONGLONG MissCount = 0;
+	ULONGLONG BytesCopied = 0;
+
+	// Called with PoolLock held
+	void Trim(UINT MaxSize);
+
+public:
+	~ScratchSurfacePool() { LogCounters(); }
+
+	// Returns a surface from the pool or creates a new one, the caller owns the returned reference
+	IDirect3DSurface9* Acquire(IDirect3DDevice9* pDevice, UINT Width, UINT Height, D3DFORMAT Format);
+	// Gives a surface back to the pool, Size is the number of bytes used by the surface
+	void Release(IDirect3DSurface9* pSurface, UINT Size);
+	void ReleaseAll() { Utils::ScopedCriticalSection ThreadLock(PoolLock); Trim(0); }
+
+	void AddBytesCopied(ULONGLONG Bytes) { Utils::ScopedCriticalSection ThreadLock(PoolLock); BytesCopied += Bytes; }
+	ULONGLONG GetHitCount() { return HitCount; }
+	ULONGLONG GetMissCount() { return MissCount; }
+	ULONGLONG GetBytesCopied() { return BytesCopied; }
+	void LogCounters();
+};
@@ -0,0 +1,171 @@
+/**
+* Copyright (C) 2023 Elisha Riedlinger
+*
+* This software is  provided 'as-is', without any express  or implied  warranty. In no event will the
+* authors be held liable for any damages arising from the use of this software.
+* Permission  is granted  to anyone  to use  this software  for  any  purpose,  including  commercial
+* applications, and to alter it and redistribute it freely, subject to the following restrictions:
+*
+*   1. The origin of this software must not be misrepresented; you must not claim that you  wrote the
+*      original  software. If you use this  software  in a product, an  acknowledgment in the product
+*      documentation would be appreciated but is not required.
+*   2. Altered source versions must  be plainly  marked as such, and  must not be  misrepresented  as
+*      being the original software.
+*   3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "d3d9.h"
+
+bool VertexBufferStreaming::RecordWrite(PROFILE& Profile, DWORD Frame)
+{
+	if (Profile.LastFrame != Frame)
+	{
+		// A frame without writes restarts the count
+		Profile.FrameCount = (Profile.LastFrame && Profile.LastFrame + 1 == Frame) ? Profile.FrameCount + 1 : 1;
+		Profile.LastFrame = Frame;
+	}
+
+	return Profile.FrameCount >= HotFrames;
+}
+
+void VertexBufferStreaming::LogCounters()
+{
+	if (!StreamCount)
+	{
+		return;
+	}
+
+	Logging::Log() << "Vertex buffer streaming:" <<
+		" Buffers " << StreamCount <<
+		" Uploads " << UploadCount <<
+		" BytesUploaded " << BytesUploaded;
+}
+
+void VertexBufferStreaming::RebindStreams(LPDIRECT3DDEVICE9 pDevice, LPDIRECT3DVERTEXBUFFER9 pOld, LPDIRECT3DVERTEXBUFFER9 pNew)
+{
+	for (UINT Stream = 0; Stream < MaxStreams; Stream++)
+	{
+		IDirect3DVertexBuffer9* pStreamData = nullptr;
+		UINT Offset = 0, Stride = 0;
+		if (SUCCEEDED(pDevice->GetStreamSource(Stream, &pStreamData, &Offset, &Stride)) && pStreamData)
+		{
+			if (pStreamData == pOld)
+			{
+				pDevice->SetStreamSource(Stream, pNew, Offset, Stride);
+			}
+			pStreamData->Release();
+		}
+	}
+}
+
+void VertexBufferStreaming::Add(LPDIRECT3DDEVICE9 pDevice, m_IDirect3DVertexBuffer9* pBuffer)
+{
+	{
+		Utils::ScopedCriticalSection ThreadLock(BufferLock);
+
+		Buffers.push_back(pBuffer);
+		StreamCount++;
+		IsDirty = true;
+	}
+
+	RebindStreams(pDevice, pBuffer->GetProxyInterface(), pBuffer->GetStreamBuffer());
+}
+
+void VertexBufferStreaming::Remove(LPDIRECT3DDEVICE9 pDevice, m_IDirect3DVertexBuffer9* pBuffer)
+{
+	{
+		Utils::ScopedCriticalSection ThreadLock(BufferLock);
+
+		auto it = std::find(Buffers.begin(), Buffers.end(), pBuffer);
+		if (it == Buffers.end())
+		{
+			return;
+		}
+		Buffers.erase(it);
+	}
+
+	// The managed buffer is released when there is no device
+	if (pDevice)
+	{
+		RebindStreams(pDevice, pBuffer->GetStreamBuffer(), pBuffer->GetProxyInterface());
+	}
+}
+
+void VertexBufferStreaming::StopAll()
+{
+	std::vector<m_IDirect3DVertexBuffer9*> List;
+	{
+		Utils::ScopedCriticalSection ThreadLock(BufferLock);
+
+		List = Buffers;
+	}
+
+	// Each buffer removes itself from the list
+	for (m_IDirect3DVertexBuffer9* pBuffer : List)
+	{
+		pBuffer->StopStreaming();
+	}
+}
+
+m_IDirect3DVertexBuffer9* VertexBufferStreaming::FindStreamBuffer(IDirect3DVertexBuffer9* pStreamBuffer)
+{
+	Utils::ScopedCriticalSection ThreadLock(BufferLock);
+
+	for (m_IDirect3DVertexBuffer9* pBuffer : Buffers)
+	{
+		if (pBuffer->GetStreamBuffer() == pStreamBuffer)
+		{
+			return pBuffer;
+		}
+	}
+
+	return nullptr;
+}
+
+void VertexBufferStreaming::RebindAll(LPDIRECT3DDEVICE9 pDevice, bool UseStreamBuffers)
+{
+	Utils::ScopedCriticalSection ThreadLock(BufferLock);
+
+	if (Buffers.empty())
+	{
+		return;
+	}
+
+	for (UINT Stream = 0; Stream < MaxStreams; Stream++)
+	{
+		IDirect3DVertexBuffer9* pStreamData = nullptr;
+		UINT Offset = 0, Stride = 0;
+		if (FAILED(pDevice->GetStreamSource(Stream, &pStreamData, &Offset, &Stride)) || !pStreamData)
+		{
+			continue;
+		}
+
+		for (m_IDirect3DVertexBuffer9* pBuffer : Buffers)
+		{
+			LPDIRECT3DVERTEXBUFFER9 pOld = UseStreamBuffers ? pBuffer->GetProxyInterface() : pBuffer->GetStreamBuffer();
+			LPDIRECT3DVERTEXBUFFER9 pNew = UseStreamBuffers ? pBuffer->GetStreamBuffer() : pBuffer->GetProxyInterface();
+			if (pOld == pStreamData)
+			{
+				pDevice->SetStreamSource(Stream, pNew, Offset, Stride);
+				break;
+			}
+		}
+		pStreamData->Release();
+	}
+}
+
+void VertexBufferStreaming::Upload()
+{
+	Utils::ScopedCriticalSection ThreadLock(BufferLock);
+
+	IsDirty = false;
+
+	for (m_IDirect3DVertexBuffer9* pBuffer : Buffers)
+	{
+		// Buffers that are still locked are uploaded at a later draw
+		if (!pBuffer->UploadStream())
+		{
+			IsDirty = true;
+		}
+	}
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+// For StreamHotVertexBuffers, managed vertex buffers that are written every frame are drawn from dynamic default pool buffers
+// The application writes to a system memory copy, which is uploaded with D3DLOCK_DISCARD at the next draw so the driver renames the buffer instead of stalling
+// When only part of the copy was written, just that range is uploaded with D3DLOCK_NOOVERWRITE
+class VertexBufferStreaming
+{
+public:
+	static constexpr DWORD HotFrames = 4;		// Consecutive frames with writes before a buffer is streamed
+
+	// Lock profile kept by each managed buffer
+	struct PROFILE
+	{
+		DWORD LastFrame = 0;	// Last frame the buffer was written in, frames start at one
+		DWORD FrameCount = 0;	// Consecutive frames the buffer was written in
+	};
+
+	// Records a write lock, returns true once the buffer was written in HotFrames consecutive frames
+	// Buffers that are only written at load time or every few frames are left alone
+	static bool RecordWrite(PROFILE& Profile, DWORD Frame);
+
+private:
+	static constexpr UINT MaxStreams = 16;
+
+	bool Enabled = false;
+	DWORD Frame = 1;
+	bool IsDirty = false;							// Set when a streamed buffer was unlocked after a write
+	std::vector<m_IDirect3DVertexBuffer9*> Buffers;	// Buffers that are streamed, each one holds a dynamic buffer
+	Utils::CriticalSection BufferLock;				// Buffers can be locked from other threads on multithreaded devices, also guards the streaming state of each buffer
+
+	// Counters
+	ULONGLONG StreamCount = 0;
+	ULONGLONG UploadCount = 0;
+	ULONGLONG BytesUploaded = 0;
+
+	// Moves the stream sources that use pOld to pNew, keeping their offset and stride
+	static void RebindStreams(LPDIRECT3DDEVICE9 pDevice, LPDIRECT3DVERTEXBUFFER9 pOld, LPDIRECT3DVERTEXBUFFER9 pNew);
+	// Binds either the dynamic or the managed buffer of every streamed buffer that is bound
+	void RebindAll(LPDIRECT3DDEVICE9 pDevice, bool UseStreamBuffers);
+
+public:
+	VertexBufferStreaming(bool IsEnabled) : Enabled(IsEnabled) {}
+	~VertexBufferStreaming() { LogCounters(); }
+
+	bool IsEnabled() { return Enabled; }
+	Utils::CriticalSection& GetLock() { return BufferLock; }
+	DWORD GetFrame() { return Frame; }
+	void NextFrame() { Frame++; }
+	void LogCounters();
+
+	ULONG GetCount() { return (ULONG)Buffers.size(); }
+
+	// Called when a buffer starts or stops streaming, stream sources are moved between the managed and the dynamic buffer
+	void Add(LPDIRECT3DDEVICE9 pDevice, m_IDirect3DVertexBuffer9* pBuffer);
+	void Remove(LPDIRECT3DDEVICE9 pDevice, m_IDirect3DVertexBuffer9* pBuffer);
+	void StopAll();
+
+	// Returns the wrapper of a dynamic buffer returned by the device, or nullptr if it is not a streamed buffer
+	m_IDirect3DVertexBuffer9* FindStreamBuffer(IDirect3DVertexBuffer9* pStreamBuffer);
+
+	// Binds the dynamic buffers again after a state block set the managed buffers
+	void Reload(LPDIRECT3DDEVICE9 pDevice) { RebindAll(pDevice, true); }
+
+	// State blocks keep the managed buffers, so they do not hold default pool buffers across a reset or bind stale buffers after streaming stops
+	void BeginCapture(LPDIRECT3DDEVICE9 pDevice) { RebindAll(pDevice, false); }
+	void EndCapture(LPDIRECT3DDEVICE9 pDevice) { RebindAll(pDevice, true); }
+
+	// Uploads the buffers written since the last draw
+	void SetDirty() { IsDirty = true; }
+	void Apply() { if (IsDirty) { Upload(); } }
+	void Upload();
+	void AddUpload(UINT Size) { UploadCount++; BytesUploaded += Size; }
+};
@@ -53,6 +53,12 @@ extern bool DeviceMultiSampleFlag;
 extern D3DMULTISAMPLE_TYPE DeviceMultiSampleType;
 extern DWORD DeviceMultiSampleQuality;
 
+#include "DeviceStateCache.h"
+#include "ClipPlaneCache.h"
+#include "AnisotropyOverride.h"
+#include "ScratchSurfacePool.h"
+#include "FrontBufferCapture.h"
+#include "VertexBufferStreaming.h"
 #include "IDirect3D9Ex.h"
 #include "IDirect3DDevice9Ex.h"
 #include "IDirect3DCubeTexture9.h"
@@ -1,7 +1,10 @@
 #pragma once
 
 #include <unordered_map>
+#include <vector>
 #include <algorithm>
+#include "Utils\ScopedLock.h"
+#include "Utils\WrapperAllocator.h"
 
 constexpr UINT MaxIndex = 43;
 
@@ -11,6 +14,9 @@ class AddressLookupTableDdraw
 private:
 	bool ConstructorFlag = false;
 	std::unordered_map<void*, class AddressLookupTableDdrawObject*> g_map[MaxIndex];
+	std::unordered_map<class AddressLookupTableDdrawObject*, void*> g_reverse[MaxIndex];
+	SRWLOCK g_lock[MaxIndex] = {};			// Guards g_map and g_reverse, each cache index has its own lock
+	Utils::CriticalSection CreateLock;		// Recursive because wrapper constructors can create other wrappers
 
 	template <typename T>
 	struct AddressCacheIndex { static constexpr UINT CacheIndex = 0; };
@@ -151,9 +157,18 @@ private:
 	{
 		for (DWORD x = 29; x < MaxIndex; x++)
 		{
-			for (const auto& entry : g_map[x])
+			// Deleted objects remove themselves from the map, so the entries are copied before they are deleted
+			std::vector<AddressLookupTableDdrawObject*> Objects;
 			{
-				entry.second->DeleteMe();
+				Utils::ScopedSharedLock Lock(g_lock[x]);
+				for (const auto& entry : g_map[x])
+				{
+					Objects.push_back(entry.second);
+				}
+			}
+			for (const auto& Object : Objects)
+			{
+				Object->DeleteMe();
 			}
 		}
 	}
@@ -165,9 +180,15 @@ private:
 
 		if (!Interface)
 		{
-			X *InterfaceX = new X((I*)Proxy, DxVersion);
+			// Check again while holding the create lock, another thread may have wrapped the proxy in the meantime
+			Utils::ScopedCriticalSection Lock(CreateLock);
+			Interface = FindAddressAllInterfaces<T>(Proxy);
+			if (!Interface)
+			{
+				X *InterfaceX = new X((I*)Proxy, DxVersion);
 
-			Interface = (T*)InterfaceX->GetWrapperInterfaceX(DxVersion);
+				Interface = (T*)InterfaceX->GetWrapperInterfaceX(DxVersion);
+			}
 		}
 
 		return Interface;
@@ -180,7 +201,13 @@ private:
 
 		if (!Interface)
 		{
-			Interface = new T(static_cast<T *>(Proxy));
+			// Check again while holding the create lock, another thread may have wrapped the proxy in the meantime
+			Utils::ScopedCriticalSection Lock(CreateLock);
+			Interface = FindAddressAllInterfaces<T>(Proxy);
+			if (!Interface)
+			{
+				Interface = new T(static_cast<T *>(Proxy));
+			}
 		}
 
 		return Interface;
@@ -251,6 +278,7 @@ private:
 		}
 
 		constexpr UINT CacheIndex = AddressCacheIndex<T>::CacheIndex;
+		Utils::ScopedSharedLock Lock(g_lock[CacheIndex]);
 		auto it = g_map[CacheIndex].find(Proxy);
 
 		if (it != std::end(g_map[CacheIndex]))
@@ -309,10 +337,10 @@ public:
 		}
 
 		constexpr UINT CacheIndex = AddressCacheIndex<T>::CacheIndex;
-		auto it = std::find_if(g_map[CacheIndex].begin(), g_map[CacheIndex].end(),
-			[=](auto Map) -> bool { return Map.second == Wrapper; });
+		Utils::ScopedSharedLock Lock(g_lock[CacheIndex]);
+		auto it = g_reverse[CacheIndex].find(Wrapper);
 
-		if (it != std::end(g_map[CacheIndex]))
+		if (it != std::end(g_reverse[CacheIndex]))
 		{
 			return true;
 		}
@@ -329,6 +357,7 @@ public:
 		}
 
 		constexpr UINT CacheIndex = AddressCacheIndex<T>::CacheIndex;
+		Utils::ScopedSharedLock Lock(g_lock[CacheIndex]);
 		auto it = g_map[CacheIndex].find(Proxy);
 
 		if (it != std::end(g_map[CacheIndex]))
@@ -345,7 +374,22 @@ public:
 		constexpr UINT CacheIndex = AddressCacheIndex<T>::CacheIndex;
 		if (Wrapper && Proxy)
 		{
+			Utils::ScopedExclusiveLock Lock(g_lock[CacheIndex]);
+
+			// Remove stale entries so both maps stay one-to-one
+			auto it = g_map[CacheIndex].find(Proxy);
+			if (it != std::end(g_map[CacheIndex]))
+			{
+				g_reverse[CacheIndex].erase(it->second);
+			}
+			auto rit = g_reverse[CacheIndex].find(Wrapper);
+			if (rit != std::end(g_reverse[CacheIndex]))
+			{
+				g_map[CacheIndex].erase(rit->second);
+			}
+
 			g_map[CacheIndex][Proxy] = Wrapper;
+			g_reverse[CacheIndex][Wrapper] = Proxy;
 		}
 	}
 
@@ -358,18 +402,24 @@ public:
 		}
 
 		constexpr UINT CacheIndex = AddressCacheIndex<T>::CacheIndex;
-		auto it = std::find_if(g_map[CacheIndex].begin(), g_map[CacheIndex].end(),
-			[=](auto Map) -> bool { return Map.second == Wrapper; });
-
-		if (it != std::end(g_map[CacheIndex]))
+		bool IsEmpty = false;
 		{
-			it = g_map[CacheIndex].erase(it);
+			Utils::ScopedExclusiveLock Lock(g_lock[CacheIndex]);
+			auto it = g_reverse[CacheIndex].find(Wrapper);
+
+			if (it != std::end(g_reverse[CacheIndex]))
+			{
+				g_map[CacheIndex].erase(it->second);
+				g_reverse[CacheIndex].erase(it);
+			}
+
+			IsEmpty = g_map[CacheIndex].empty();
 		}
 
+		// The lock is released first because deleting the objects removes them from their own maps
 #pragma warning (push)
 #pragma warning (disable : 4127)
-		if (CacheIndex == AddressCacheIndex<m_IDirectDrawX>::CacheIndex &&
-			g_map[AddressCacheIndex<m_IDirectDrawX>::CacheIndex].size() == 0)
+		if (CacheIndex == AddressCacheIndex<m_IDirectDrawX>::CacheIndex && IsEmpty)
 		{
 			DeleteAll();
 		}
@@ -382,6 +432,10 @@ class AddressLookupTableDdrawObject
 public:
 	virtual ~AddressLookupTableDdrawObject() {}
 
+	// Wrappers are created and released often, so they are allocated from recycled blocks
+	static void* operator new(size_t Size) { return Utils::WrapperAllocator::Allocate(Size); }
+	static void operator delete(void* ptr, size_t Size) { Utils::WrapperAllocator::Free(ptr, Size); }
+
 	void DeleteMe()
 	{
 		delete this;
@@ -0,0 +1,331 @@
+/**
+* Copyright (C) 2023 Elisha Riedlinger
+*
+* This software is  provided 'as-is', without any express  or implied  warranty. In no event will the
+* authors be held liable for any damages arising from the use of this software.
+* Permission  is granted  to anyone  to use  this software  for  any  purpose,  including  commercial
+* applications, and to alter it and redistribute it freely, subject to the following restrictions:
+*
+*   1. The origin of this software must not be misrepresented; you must not claim that you  wrote the
+*      original  software. If you use this  software  in a product, an  acknowledgment in the product
+*      documentation would be appreciated but is not required.
+*   2. Altered source versions must  be plainly  marked as such, and  must not be  misrepresented  as
+*      being the original software.
+*   3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include <emmintrin.h>
+#include <vector>
+#include "ddraw.h"
+
+namespace
+{
+	template <int Size> __m128i _mm_set1_epi(DWORD a);
+	template <> __m128i _mm_set1_epi<1>(DWORD a) { return _mm_set1_epi8((char)a); }
+	template <> __m128i _mm_set1_epi<2>(DWORD a) { return _mm_set1_epi16((short)a); }
+	template <> __m128i _mm_set1_epi<4>(DWORD a) { return _mm_set1_epi32((int)a); }
+
+	template <int Size> __m128i _mm_cmpgt_epi(__m128i a, __m128i b);
+	template <> __m128i _mm_cmpgt_epi<1>(__m128i a, __m128i b) { return _mm_cmpgt_epi8(a, b); }
+	template <> __m128i _mm_cmpgt_epi<2>(__m128i a, __m128i b) { return _mm_cmpgt_epi16(a, b); }
+	template <> __m128i _mm_cmpgt_epi<4>(__m128i a, __m128i b) { return _mm_cmpgt_epi32(a, b); }
+
+	// Reverse the order of the pixels in a vector
+	template <int Size> __m128i ReverseVector(__m128i v);
+	template <> __m128i ReverseVector<4>(__m128i v)
+	{
+		return _mm_shuffle_epi32(v, _MM_SHUFFLE(0, 1, 2, 3));
+	}
+	template <> __m128i ReverseVector<2>(__m128i v)
+	{
+		v = _mm_shufflelo_epi16(v, _MM_SHUFFLE(0, 1, 2, 3));
+		v = _mm_shufflehi_epi16(v, _MM_SHUFFLE(0, 1, 2, 3));
+		return _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2));
+	}
+	template <> __m128i ReverseVector<1>(__m128i v)
+	{
+		v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+		return ReverseVector<2>(v);
+	}
+
+	__forceinline DWORD GetPixelColor(BYTE Pixel) { return Pixel; }
+	__forceinline DWORD GetPixelColor(WORD Pixel) { return Pixel; }
+	__forceinline DWORD GetPixelColor(DWORD Pixel) { return Pixel; }
+	__forceinline DWORD GetPixelColor(const TRIBYTE& Pixel) { return Pixel.first + (Pixel.second << 8) + (Pixel.third << 16); }
+
+	template <typename T, bool IsColorKey, bool IsMirror>
+	void CopyRow(T* pDest, const T* pSrc, LONG Width, DWORD ColorKeyLow, DWORD ColorKeyHigh)
+	{
+		if constexpr (!IsColorKey && !IsMirror)
+		{
+			memcpy(pDest, pSrc, Width * sizeof(T));
+			return;
+		}
+
+		LONG x = 0;
+
+		// Process 16 bytes at a time, 24-bit pixels don't fit evenly in a vector so they use the scalar loop
+		if constexpr (sizeof(T) != 3)
+		{
+			constexpr int Size = sizeof(T);
+			constexpr LONG PixelsPerVector = 16 / Size;
+
+			// Bias values by the sign bit so that signed compares can be used for unsigned color keys
+			const __m128i Bias = _mm_set1_epi<Size>(1ul << (Size * 8 - 1));
+			const __m128i KeyLow = _mm_xor_si128(_mm_set1_epi<Size>(ColorKeyLow), Bias);
+			const __m128i KeyHigh = _mm_xor_si128(_mm_set1_epi<Size>(ColorKeyHigh), Bias);
+
+			for (; x + PixelsPerVector <= Width; x += PixelsPerVector)
+			{
+				__m128i Src;
+				if constexpr (IsMirror)
+				{
+					Src = ReverseVector<Size>(_mm_loadu_si128((const __m128i*)(pSrc + Width - x - PixelsPerVector)));
+				}
+				else
+				{
+					Src = _mm_loadu_si128((const __m128i*)(pSrc + x));
+				}
+
+				if constexpr (IsColorKey)
+				{
+					const __m128i Biased = _mm_xor_si128(Src, Bias);
+					const __m128i CopyMask = _mm_or_si128(_mm_cmpgt_epi<Size>(KeyLow, Biased), _mm_cmpgt_epi<Size>(Biased, KeyHigh));
+					const __m128i Dest = _mm_loadu_si128((const __m128i*)(pDest + x));
+					Src = _mm_or_si128(_mm_and_si128(CopyMask, Src), _mm_andnot_si128(CopyMask, Dest));
+				}
+
+				_mm_storeu_si128((__m128i*)(pDest + x), Src);
+			}
+		}
+
+		// Copy remaining pixels
+		for (; x < Width; x++)
+		{
+			const T& Pixel = pSrc[IsMirror ? Width - x - 1 : x];
+			if constexpr (IsColorKey)
+			{
+				DWORD PixelColor = GetPixelColor(Pixel);
+				if (PixelColor >= ColorKeyLow && PixelColor <= ColorKeyHigh)
+				{
+					continue;
+				}
+			}
+			pDest[x] = Pixel;
+		}
+	}
+
+	template <typename T, bool IsColorKey>
+	void StretchRow(T* pDest, const T* pSrc, LONG Width, const DWORD* pColumnTable, DWORD ColorKeyLow, DWORD ColorKeyHigh)
+	{
+		LONG x = 0;
+
+		// Unroll the table lookups when every pixel is copied
+		if constexpr (!IsColorKey)
+		{
+			for (; x + 4 <= Width; x += 4)
+			{
+				pDest[x] = pSrc[pColumnTable[x]];
+				pDest[x + 1] = pSrc[pColumnTable[x + 1]];
+				pDest[x + 2] = pSrc[pColumnTable[x + 2]];
+				pDest[x + 3] = pSrc[pColumnTable[x + 3]];
+			}
+		}
+
+		for (; x < Width; x++)
+		{
+			const T& Pixel = pSrc[pColumnTable[x]];
+			if constexpr (IsColorKey)
+			{
+				DWORD PixelColor = GetPixelColor(Pixel);
+				if (PixelColor >= ColorKeyLow && PixelColor <= ColorKeyHigh)
+				{
+					continue;
+				}
+			}
+			pDest[x] = Pixel;
+		}
+	}
+
+	template <typename T, bool IsColorKey, bool IsMirror>
+	void BltRect(BYTE* pDest, INT DestPitch, LONG DestWidth, LONG DestHeight,
+		const BYTE* pSrc, INT SrcPitch, LONG SrcWidth, LONG SrcHeight, DWORD ColorKeyLow, DWORD ColorKeyHigh)
+	{
+		// Same size copy
+		if (SrcWidth == DestWidth && SrcHeight == DestHeight)
+		{
+			for (LONG y = 0; y < DestHeight; y++)
+			{
+				CopyRow<T, IsColorKey, IsMirror>((T*)pDest, (const T*)pSrc, DestWidth, ColorKeyLow, ColorKeyHigh);
+				pSrc += SrcPitch;
+				pDest += DestPitch;
+			}
+			return;
+		}
+
+		// Build the source column table once using integer stepping, rows of the same width are copied without it
+		const bool IsSameWidth = (SrcWidth == DestWidth);
+		std::vector<DWORD> ColumnTable(IsSameWidth ? 0 : DestWidth);
+		for (LONG x = 0; x < (LONG)ColumnTable.size(); x++)
+		{
+			DWORD r = (DWORD)(((ULONGLONG)x * SrcWidth) / DestWidth);
+			ColumnTable[x] = (IsMirror) ? SrcWidth - r - 1 : r;
+		}
+
+		// Stretch rows, reusing the last destination row when the source row repeats
+		const BYTE* pLastDest = nullptr;
+		LONG LastSrcRow = -1;
+		for (LONG y = 0; y < DestHeight; y++)
+		{
+			LONG SrcRow = (LONG)(((ULONGLONG)y * SrcHeight) / DestHeight);
+			if (!IsColorKey && SrcRow == LastSrcRow && pLastDest)
+			{
+				memcpy(pDest, pLastDest, DestWidth * sizeof(T));
+			}
+			else if (IsSameWidth)
+			{
+				CopyRow<T, IsColorKey, IsMirror>((T*)pDest, (const T*)(pSrc + SrcRow * SrcPitch), DestWidth, ColorKeyLow, ColorKeyHigh);
+			}
+			else
+			{
+				StretchRow<T, IsColorKey>((T*)pDest, (const T*)(pSrc + SrcRow * SrcPitch), DestWidth, ColumnTable.data(), ColorKeyLow, ColorKeyHigh);
+			}
+			LastSrcRow = SrcRow;
+			pLastDest = pDest;
+			pDest += DestPitch;
+		}
+	}
+
+	template <typename T>
+	void BltFormat(BYTE* pDest, INT DestPitch, LONG DestWidth, LONG DestHeight,
+		const BYTE* pSrc, INT SrcPitch, LONG SrcWidth, LONG SrcHeight, DWORD dwFlags, DWORD ColorKeyLow, DWORD ColorKeyHigh)
+	{
+		const bool IsColorKey = ((dwFlags & BLT_COLORKEY) != 0);
+		const bool IsMirror = ((dwFlags & BLT_MIRRORLEFTRIGHT) != 0);
+
+		if (IsColorKey)
+		{
+			IsMirror ?
+				BltRect<T, true, true>(pDest, DestPitch, DestWidth, DestHeight, pSrc, SrcPitch, SrcWidth, SrcHeight, ColorKeyLow, ColorKeyHigh) :
+				BltRect<T, true, false>(pDest, DestPitch, DestWidth, DestHeight, pSrc, SrcPitch, SrcWidth, SrcHeight, ColorKeyLow, ColorKeyHigh);
+		}
+		else
+		{
+			IsMirror ?
+				BltRect<T, false, true>(pDest, DestPitch, DestWidth, DestHeight, pSrc, SrcPitch, SrcWidth, SrcHeight, ColorKeyLow, ColorKeyHigh) :
+				BltRect<T, false, false>(pDest, DestPitch, DestWidth, DestHeight, pSrc, SrcPitch, SrcWidth, SrcHeight, ColorKeyLow, ColorKeyHigh);
+		}
+	}
+
+	// Fills larger than this bypass the cache
+	constexpr size_t NonTemporalFillSize = 1024 * 1024;
+
+	// 48 bytes is a multiple of 16 and of every pixel size, the extra 16 bytes allow unaligned loads at any offset
+	constexpr DWORD FillPatternSize = 48;
+
+	template <bool IsNonTemporal>
+	void FillRow(BYTE* pDest, size_t Size, const BYTE* Pattern)
+	{
+		// Align destination to 16 bytes
+		size_t x = 0;
+		for (; x < Size && ((size_t)(pDest + x) & 15); x++)
+		{
+			pDest[x] = Pattern[x];
+		}
+
+		// Pattern is continued from the offset reached by the unaligned bytes
+		const DWORD Offset = x % FillPatternSize;
+		const __m128i v0 = _mm_loadu_si128((const __m128i*)(Pattern + Offset));
+		const __m128i v1 = _mm_loadu_si128((const __m128i*)(Pattern + (Offset + 16) % FillPatternSize));
+		const __m128i v2 = _mm_loadu_si128((const __m128i*)(Pattern + (Offset + 32) % FillPatternSize));
+
+		for (; x + FillPatternSize <= Size; x += FillPatternSize)
+		{
+			if constexpr (IsNonTemporal)
+			{
+				_mm_stream_si128((__m128i*)(pDest + x), v0);
+				_mm_stream_si128((__m128i*)(pDest + x + 16), v1);
+				_mm_stream_si128((__m128i*)(pDest + x + 32), v2);
+			}
+			else
+			{
+				_mm_store_si128((__m128i*)(pDest + x), v0);
+				_mm_store_si128((__m128i*)(pDest + x + 16), v1);
+				_mm_store_si128((__m128i*)(pDest + x + 32), v2);
+			}
+		}
+
+		// Remaining bytes
+		for (; x < Size; x++)
+		{
+			pDest[x] = Pattern[x % FillPatternSize];
+		}
+	}
+}
+
+void Blitter::Blt(BYTE* pDest, INT DestPitch, LONG DestWidth, LONG DestHeight,
+	const BYTE* pSrc, INT SrcPitch, LONG SrcWidth, LONG SrcHeight,
+	DWORD ByteCount, DWORD dwFlags, DWORD ColorKeyLow, DWORD ColorKeyHigh)
+{
+	if (!pDest || !pSrc || DestWidth <= 0 || DestHeight <= 0 || SrcWidth <= 0 || SrcHeight <= 0)
+	{
+		return;
+	}
+
+	switch (ByteCount)
+	{
+	case 1:
+		BltFormat<BYTE>(pDest, DestPitch, DestWidth, DestHeight, pSrc, SrcPitch, SrcWidth, SrcHeight, dwFlags, ColorKeyLow, ColorKeyHigh);
+		break;
+	case 2:
+		BltFormat<WORD>(pDest, DestPitch, DestWidth, DestHeight, pSrc, SrcPitch, SrcWidth, SrcHeight, dwFlags, ColorKeyLow, ColorKeyHigh);
+		break;
+	case 3:
+		BltFormat<TRIBYTE>(pDest, DestPitch, DestWidth, DestHeight, pSrc, SrcPitch, SrcWidth, SrcHeight, dwFlags, ColorKeyLow, ColorKeyHigh);
+		break;
+	case 4:
+		BltFormat<DWORD>(pDest, DestPitch, DestWidth, DestHeight, pSrc, SrcPitch, SrcWidth, SrcHeight, dwFlags, ColorKeyLow, ColorKeyHigh);
+		break;
+	}
+}
+
+void Blitter::ColorFill(BYTE* pDest, INT DestPitch, LONG Width, LONG Height, DWORD ByteCount, DWORD Color)
+{
+	if (!pDest || Width <= 0 || Height <= 0 || !ByteCount || ByteCount > 4)
+	{
+		return;
+	}
+
+	alignas(16) BYTE Pattern[FillPatternSize + 16];
+	for (DWORD x = 0; x < sizeof(Pattern); x++)
+	{
+		Pattern[x] = (BYTE)(Color >> ((x % ByteCount) * 8));
+	}
+
+	size_t RowSize = Width * ByteCount;
+
+	// Fill contiguous rows as a single row
+	if (DestPitch == (INT)RowSize)
+	{
+		RowSize *= Height;
+		Height = 1;
+	}
+
+	if (RowSize * Height >= NonTemporalFillSize)
+	{
+		for (LONG y = 0; y < Height; y++)
+		{
+			FillRow<true>(pDest, RowSize, Pattern);
+			pDest += DestPitch;
+		}
+		_mm_sfence();
+	}
+	else
+	{
+		for (LONG y = 0; y < Height; y++)
+		{
+			FillRow<false>(pDest, RowSize, Pattern);
+			pDest += DestPitch;
+		}
+	}
+}
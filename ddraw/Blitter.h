@@ -0,0 +1,17 @@
+#pragma once
+
+#include <ddraw.h>
+
+namespace Blitter
+{
+	// Copies a rect with optional source color key (BLT_COLORKEY) and left/right mirroring (BLT_MIRRORLEFTRIGHT)
+	// Stretches using point filtering when the source and destination sizes differ
+	// Mirroring up/down is done by the caller passing the last destination row and a negative pitch
+	void Blt(BYTE* pDest, INT DestPitch, LONG DestWidth, LONG DestHeight,
+		const BYTE* pSrc, INT SrcPitch, LONG SrcWidth, LONG SrcHeight,
+		DWORD ByteCount, DWORD dwFlags, DWORD ColorKeyLow, DWORD ColorKeyHigh);
+
+	// Fills a rect with a color, 24-bit colors are repeated as a 3-byte pattern
+	// Large fills use non-temporal stores so that they don't evict the cache
+	void ColorFill(BYTE* pDest, INT DestPitch, LONG Width, LONG Height, DWORD ByteCount, DWORD Color);
+}
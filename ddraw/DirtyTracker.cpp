@@ -0,0 +1,186 @@
+/**
+* Copyright (C) 2023 Elisha Riedlinger
+*
+* This software is  provided 'as-is', without any express  or implied  warranty. In no event will the
+* authors be held liable for any damages arising from the use of this software.
+* Permission  is granted  to anyone  to use  this software  for  any  purpose,  including  commercial
+* applications, and to alter it and redistribute it freely, subject to the following restrictions:
+*
+*   1. The origin of this software must not be misrepresented; you must not claim that you  wrote the
+*      original  software. If you use this  software  in a product, an  acknowledgment in the product
+*      documentation would be appreciated but is not required.
+*   2. Altered source versions must  be plainly  marked as such, and  must not be  misrepresented  as
+*      being the original software.
+*   3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "ddraw.h"
+
+void DirtyTracker::Reset()
+{
+	Width = 0;
+	Height = 0;
+	ByteCount = 0;
+	Shadow.clear();
+	ChangedRects.clear();
+}
+
+bool DirtyTracker::IsTileChanged(const BYTE* pBits, INT Pitch, const RECT& Rect)
+{
+	const DWORD ShadowPitch = Width * ByteCount;
+	const size_t RowSize = (Rect.right - Rect.left) * ByteCount;
+
+	const BYTE* pSrc = pBits + Rect.top * Pitch + Rect.left * ByteCount;
+	const BYTE* pShadow = Shadow.data() + Rect.top * ShadowPitch + Rect.left * ByteCount;
+	for (LONG y = Rect.top; y < Rect.bottom; y++)
+	{
+		if (memcmp(pSrc, pShadow, RowSize) != 0)
+		{
+			return true;
+		}
+		pSrc += Pitch;
+		pShadow += ShadowPitch;
+	}
+	return false;
+}
+
+void DirtyTracker::MergeRect(const RECT& Rect)
+{
+	// Extend a rect from the tile row above if it covers the same columns
+	for (RECT& Entry : ChangedRects)
+	{
+		if (Entry.bottom == Rect.top && Entry.left == Rect.left && Entry.right == Rect.right)
+		{
+			Entry.bottom = Rect.bottom;
+			return;
+		}
+	}
+	ChangedRects.push_back(Rect);
+}
+
+// Get a list of rects covering every tile that changed since it was last uploaded
+std::vector<RECT>& DirtyTracker::GetChangedRects(const BYTE* pBits, INT Pitch, DWORD dwWidth, DWORD dwHeight, DWORD BitCount, bool CompareAll)
+{
+	ChangedRects.clear();
+
+	const RECT FullRect = { 0, 0, (LONG)dwWidth, (LONG)dwHeight };
+
+	// Surface size or format changed so the whole surface needs to be uploaded
+	if (!pBits || Width != (LONG)dwWidth || Height != (LONG)dwHeight || ByteCount != BitCount / 8 || Shadow.empty())
+	{
+		Width = dwWidth;
+		Height = dwHeight;
+		ByteCount = BitCount / 8;
+		Shadow.assign((pBits && BitCount % 8 == 0) ? Width * Height * ByteCount : 0, 0);
+
+		ChangedRects.push_back(FullRect);
+		return ChangedRects;
+	}
+
+	// Compare the whole surface when it can be written without a lock, otherwise only where the application was given a pointer to it
+	const RECT Area = (CompareAll) ? FullRect : LockedArea;
+	const LONG AreaRight = min(Area.right, Width);
+	const LONG AreaBottom = min(Area.bottom, Height);
+	if (Area.left >= AreaRight || Area.top >= AreaBottom)
+	{
+		return ChangedRects;
+	}
+
+	// Only compare the tiles that cover the area
+	const LONG FirstX = Area.left / TileWidth;
+	const LONG FirstY = Area.top / TileHeight;
+	const LONG TilesX = (AreaRight + TileWidth - 1) / TileWidth;
+	const LONG TilesY = (AreaBottom + TileHeight - 1) / TileHeight;
+	const LONG TileCount = (TilesX - FirstX) * (TilesY - FirstY);
+	LONG ChangedTiles = 0;
+
+	for (LONG ty = FirstY; ty < TilesY; ty++)
+	{
+		const LONG top = ty * TileHeight;
+		const LONG bottom = min(top + TileHeight, Height);
+
+		// Merge changed tiles in this row into horizontal spans
+		LONG SpanLeft = -1;
+		for (LONG tx = FirstX; tx <= TilesX; tx++)
+		{
+			const LONG left = tx * TileWidth;
+			const RECT Tile = { left, top, min(left + TileWidth, Width), bottom };
+
+			if (tx < TilesX && IsTileChanged(pBits, Pitch, Tile))
+			{
+				ChangedTiles++;
+				if (SpanLeft < 0)
+				{
+					SpanLeft = left;
+				}
+			}
+			else if (SpanLeft >= 0)
+			{
+				MergeRect({ SpanLeft, top, min(left, Width), bottom });
+				SpanLeft = -1;
+			}
+		}
+
+		// Too much of the area changed, upload it all at once
+		if (ChangedTiles * 2 > TileCount || ChangedRects.size() > MaxRects)
+		{
+			ChangedRects.clear();
+			ChangedRects.push_back({ FirstX * TileWidth, FirstY * TileHeight, min(TilesX * TileWidth, Width), min(TilesY * TileHeight, Height) });
+			break;
+		}
+	}
+
+	return ChangedRects;
+}
+
+// Store rect from surface memory after it has been uploaded
+void DirtyTracker::UpdateRect(const BYTE* pBits, INT Pitch, const RECT& Rect)
+{
+	if (!pBits || Shadow.empty())
+	{
+		return;
+	}
+
+	const LONG left = max(Rect.left, 0L);
+	const LONG top = max(Rect.top, 0L);
+	const LONG right = min(Rect.right, Width);
+	const LONG bottom = min(Rect.bottom, Height);
+	if (left >= right || top >= bottom)
+	{
+		return;
+	}
+
+	const DWORD ShadowPitch = Width * ByteCount;
+	const size_t RowSize = (right - left) * ByteCount;
+
+	const BYTE* pSrc = pBits + top * Pitch + left * ByteCount;
+	BYTE* pShadow = Shadow.data() + top * ShadowPitch + left * ByteCount;
+	for (LONG y = top; y < bottom; y++)
+	{
+		memcpy(pShadow, pSrc, RowSize);
+		pSrc += Pitch;
+		pShadow += ShadowPitch;
+	}
+}
+
+// Add rect the application was given a write pointer to
+void DirtyTracker::AddLockRect(const RECT& Rect)
+{
+	const LONG left = max(Rect.left, 0L);
+	const LONG top = max(Rect.top, 0L);
+	if (left >= Rect.right || top >= Rect.bottom)
+	{
+		return;
+	}
+
+	if (LockedArea.left >= LockedArea.right || LockedArea.top >= LockedArea.bottom)
+	{
+		LockedArea = { left, top, Rect.right, Rect.bottom };
+		return;
+	}
+
+	LockedArea.left = min(LockedArea.left, left);
+	LockedArea.top = min(LockedArea.top, top);
+	LockedArea.right = max(LockedArea.right, Rect.right);
+	LockedArea.bottom = max(LockedArea.bottom, Rect.bottom);
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <vector>
+#include <ddraw.h>
+
+// Tracks which tiles of surface memory changed since they were last uploaded
+class DirtyTracker
+{
+private:
+	static constexpr LONG TileWidth = 32;
+	static constexpr LONG TileHeight = 32;
+	static constexpr size_t MaxRects = 64;
+
+	LONG Width = 0;
+	LONG Height = 0;
+	DWORD ByteCount = 0;
+	std::vector<BYTE> Shadow;				// Copy of the surface memory as it was last uploaded
+	std::vector<RECT> ChangedRects;
+	RECT LockedArea = {};					// Area the application was given a write pointer to, memory outside of it is not compared
+											// Kept on reset because the application can hold the pointer across a device reset
+
+	bool IsTileChanged(const BYTE* pBits, INT Pitch, const RECT& Rect);
+	void MergeRect(const RECT& Rect);
+
+public:
+	void Reset();
+	// CompareAll is set when the memory can be written without a lock, otherwise only the locked area is compared
+	std::vector<RECT>& GetChangedRects(const BYTE* pBits, INT Pitch, DWORD dwWidth, DWORD dwHeight, DWORD BitCount, bool CompareAll);
+	void UpdateRect(const BYTE* pBits, INT Pitch, const RECT& Rect);
+	void AddLockRect(const RECT& Rect);
+};
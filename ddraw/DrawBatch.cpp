@@ -0,0 +1,252 @@
+/**
+* Copyright (C) 2023 Elisha Riedlinger
+*
+* This software is  provided 'as-is', without any express  or implied  warranty. In no event will the
+* authors be held liable for any damages arising from the use of this software.
+* Permission  is granted  to anyone  to use  this software  for  any  purpose,  including  commercial
+* applications, and to alter it and redistribute it freely, subject to the following restrictions:
+*
+*   1. The origin of this software must not be misrepresented; you must not claim that you  wrote the
+*      original  software. If you use this  software  in a product, an  acknowledgment in the product
+*      documentation would be appreciated but is not required.
+*   2. Altered source versions must  be plainly  marked as such, and  must not be  misrepresented  as
+*      being the original software.
+*   3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "ddraw.h"
+
+D3DPRIMITIVETYPE DrawBatch::GetListType(D3DPRIMITIVETYPE dptPrimitiveType)
+{
+	switch (dptPrimitiveType)
+	{
+	case D3DPT_POINTLIST:
+		return D3DPT_POINTLIST;
+	case D3DPT_LINELIST:
+	case D3DPT_LINESTRIP:
+		return D3DPT_LINELIST;
+	case D3DPT_TRIANGLELIST:
+	case D3DPT_TRIANGLESTRIP:
+	case D3DPT_TRIANGLEFAN:
+		return D3DPT_TRIANGLELIST;
+	default:
+		return (D3DPRIMITIVETYPE)0;
+	}
+}
+
+// Strips and fans are converted to lists keeping the winding order and the flat shading vertex of each primitive
+void DrawBatch::AddIndices(D3DPRIMITIVETYPE dptPrimitiveType, WORD BaseVertex, const WORD* lpIndices, DWORD dwCount)
+{
+	auto Index = [&](DWORD x) -> WORD { return BaseVertex + (lpIndices ? lpIndices[x] : (WORD)x); };
+
+	switch (dptPrimitiveType)
+	{
+	case D3DPT_POINTLIST:
+	case D3DPT_LINELIST:
+	case D3DPT_TRIANGLELIST:
+	{
+		DWORD Count = (dptPrimitiveType == D3DPT_POINTLIST) ? dwCount : (dptPrimitiveType == D3DPT_LINELIST) ? dwCount - dwCount % 2 : dwCount - dwCount % 3;
+		for (DWORD x = 0; x < Count; x++)
+		{
+			Indices.push_back(Index(x));
+		}
+		break;
+	}
+	case D3DPT_LINESTRIP:
+		for (DWORD x = 0; x + 1 < dwCount; x++)
+		{
+			Indices.push_back(Index(x));
+			Indices.push_back(Index(x + 1));
+		}
+		break;
+	case D3DPT_TRIANGLESTRIP:
+		for (DWORD x = 0; x + 2 < dwCount; x++)
+		{
+			Indices.push_back(Index(x));
+			Indices.push_back(Index((x & 1) ? x + 2 : x + 1));
+			Indices.push_back(Index((x & 1) ? x + 1 : x + 2));
+		}
+		break;
+	case D3DPT_TRIANGLEFAN:
+		for (DWORD x = 1; x + 1 < dwCount; x++)
+		{
+			Indices.push_back(Index(x));
+			Indices.push_back(Index(x + 1));
+			Indices.push_back(Index(0));
+		}
+		break;
+	}
+}
+
+bool DrawBatch::Add(D3DPRIMITIVETYPE dptPrimitiveType, DWORD dwVertexTypeDesc, DWORD dwFlags, DWORD dwDirectXVersion, DWORD dwColorKeyLow, DWORD dwColorKeyHigh,
+	const void* lpVertices, DWORD dwVertexCount, const WORD* lpIndices, DWORD dwIndexCount)
+{
+	// Legacy vertices are converted while they are added to the batch
+	const bool IsLVertex = (dwVertexTypeDesc == D3DFVF_LVERTEX);
+	if (IsLVertex)
+	{
+		dwVertexTypeDesc = D3DFVF_LVERTEX9;
+	}
+
+	D3DPRIMITIVETYPE ListType = GetListType(dptPrimitiveType);
+	DWORD Count = (lpIndices) ? dwIndexCount : dwVertexCount;
+	DWORD VertexStride = GetVertexStride(dwVertexTypeDesc);
+
+	if (!ListType || !lpVertices || !VertexStride || !dwVertexCount || dwVertexCount > MaxBatchVertices ||
+		Count < ((ListType == D3DPT_TRIANGLELIST) ? 3u : (ListType == D3DPT_LINELIST) ? 2u : 1u))
+	{
+		return false;
+	}
+
+	// Out of range indices are left for Direct3D9 to handle
+	if (lpIndices)
+	{
+		for (DWORD x = 0; x < dwIndexCount; x++)
+		{
+			if (lpIndices[x] >= dwVertexCount)
+			{
+				return false;
+			}
+		}
+	}
+
+	if (IsEmpty())
+	{
+		Vertices.clear();
+		PrimitiveType = ListType;
+		FVF = dwVertexTypeDesc;
+		Flags = dwFlags;
+		DirectXVersion = dwDirectXVersion;
+		ColorKeyLow = dwColorKeyLow;
+		ColorKeyHigh = dwColorKeyHigh;
+		Stride = VertexStride;
+	}
+	else if (PrimitiveType != ListType || FVF != dwVertexTypeDesc || Flags != dwFlags || DirectXVersion != dwDirectXVersion ||
+		ColorKeyLow != dwColorKeyLow || ColorKeyHigh != dwColorKeyHigh ||
+		Vertices.size() / Stride + dwVertexCount > MaxBatchVertices)
+	{
+		return false;
+	}
+
+	WORD BaseVertex = (WORD)(Vertices.size() / Stride);
+	if (IsLVertex)
+	{
+		Vertices.resize(Vertices.size() + dwVertexCount * Stride);
+		VertexConvert::LVertexToLVertex9((D3DLVERTEX9*)(Vertices.data() + BaseVertex * Stride), (const D3DLVERTEX*)lpVertices, dwVertexCount);
+	}
+	else
+	{
+		const BYTE* pVertices = (const BYTE*)lpVertices;
+		Vertices.insert(Vertices.end(), pVertices, pVertices + dwVertexCount * Stride);
+	}
+	AddIndices(dptPrimitiveType, BaseVertex, lpIndices, Count);
+	DrawCount++;
+
+	return true;
+}
+
+HRESULT DrawBatch::UploadBuffers(LPDIRECT3DDEVICE9 d3d9Device, UINT& BaseVertex, UINT& StartIndex)
+{
+	UINT VertexSize = Vertices.size();
+	UINT IndexSize = Indices.size() * sizeof(WORD);
+	if (VertexSize > VertexBufferSize || IndexSize > IndexBufferSize)
+	{
+		return DDERR_GENERIC;
+	}
+
+	if (!VertexBuffer && FAILED(d3d9Device->CreateVertexBuffer(VertexBufferSize, D3DUSAGE_DYNAMIC | D3DUSAGE_WRITEONLY, 0, D3DPOOL_DEFAULT, &VertexBuffer, nullptr)))
+	{
+		LOG_LIMIT(100, __FUNCTION__ << " Error: failed to create batch vertex buffer!");
+		return DDERR_GENERIC;
+	}
+	if (!IndexBuffer && FAILED(d3d9Device->CreateIndexBuffer(IndexBufferSize, D3DUSAGE_DYNAMIC | D3DUSAGE_WRITEONLY, D3DFMT_INDEX16, D3DPOOL_DEFAULT, &IndexBuffer, nullptr)))
+	{
+		LOG_LIMIT(100, __FUNCTION__ << " Error: failed to create batch index buffer!");
+		return DDERR_GENERIC;
+	}
+
+	// Vertices are placed on a stride boundary so they can be addressed with BaseVertexIndex
+	UINT VertexOffset = ((VertexBufferPos + Stride - 1) / Stride) * Stride;
+	DWORD VertexLockFlags = D3DLOCK_NOOVERWRITE;
+	if (VertexOffset + VertexSize > VertexBufferSize)
+	{
+		VertexOffset = 0;
+		VertexLockFlags = D3DLOCK_DISCARD;
+	}
+	UINT IndexOffset = IndexBufferPos;
+	DWORD IndexLockFlags = D3DLOCK_NOOVERWRITE;
+	if (IndexOffset + IndexSize > IndexBufferSize)
+	{
+		IndexOffset = 0;
+		IndexLockFlags = D3DLOCK_DISCARD;
+	}
+
+	void* pData = nullptr;
+	if (FAILED(VertexBuffer->Lock(VertexOffset, VertexSize, &pData, VertexLockFlags)))
+	{
+		return DDERR_GENERIC;
+	}
+	memcpy(pData, Vertices.data(), VertexSize);
+	VertexBuffer->Unlock();
+
+	if (FAILED(IndexBuffer->Lock(IndexOffset, IndexSize, &pData, IndexLockFlags)))
+	{
+		return DDERR_GENERIC;
+	}
+	memcpy(pData, Indices.data(), IndexSize);
+	IndexBuffer->Unlock();
+
+	VertexBufferPos = VertexOffset + VertexSize;
+	IndexBufferPos = IndexOffset + IndexSize;
+	BaseVertex = VertexOffset / Stride;
+	StartIndex = IndexOffset / sizeof(WORD);
+
+	if (FAILED(d3d9Device->SetStreamSource(0, VertexBuffer, 0, Stride)) || FAILED(d3d9Device->SetIndices(IndexBuffer)))
+	{
+		return DDERR_GENERIC;
+	}
+
+	return D3D_OK;
+}
+
+HRESULT DrawBatch::Draw(LPDIRECT3DDEVICE9 d3d9Device)
+{
+	if (IsEmpty())
+	{
+		return D3D_OK;
+	}
+
+	UINT NumVertices = Vertices.size() / Stride;
+	UINT PrimitiveCount = GetNumberOfPrimitives(PrimitiveType, Indices.size());
+
+	UINT BaseVertex = 0, StartIndex = 0;
+	if (SUCCEEDED(UploadBuffers(d3d9Device, BaseVertex, StartIndex)))
+	{
+		return d3d9Device->DrawIndexedPrimitive(PrimitiveType, BaseVertex, 0, NumVertices, StartIndex, PrimitiveCount);
+	}
+
+	return d3d9Device->DrawIndexedPrimitiveUP(PrimitiveType, 0, NumVertices, PrimitiveCount, Indices.data(), D3DFMT_INDEX16, Vertices.data(), Stride);
+}
+
+void DrawBatch::Clear()
+{
+	Vertices.clear();
+	Indices.clear();
+	DrawCount = 0;
+}
+
+void DrawBatch::ReleaseBuffers()
+{
+	if (VertexBuffer)
+	{
+		VertexBuffer->Release();
+		VertexBuffer = nullptr;
+	}
+	if (IndexBuffer)
+	{
+		IndexBuffer->Release();
+		IndexBuffer = nullptr;
+	}
+	VertexBufferPos = 0;
+	IndexBufferPos = 0;
+}
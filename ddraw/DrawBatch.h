@@ -0,0 +1,52 @@
+#pragma once
+
+#include <vector>
+#include <ddraw.h>
+
+// Collects consecutive DrawPrimitive calls with the same FVF and draw flags into a single indexed list draw
+class DrawBatch
+{
+private:
+	static constexpr DWORD MaxBatchVertices = 0xFFFF;				// Limit for 16-bit indices
+	static constexpr UINT VertexBufferSize = 1024 * 1024;
+	static constexpr UINT IndexBufferSize = 256 * 1024;
+
+	D3DPRIMITIVETYPE PrimitiveType = D3DPT_TRIANGLELIST;
+	DWORD FVF = 0;
+	DWORD Flags = 0;
+	DWORD DirectXVersion = 0;
+	DWORD ColorKeyLow = 0;
+	DWORD ColorKeyHigh = 0;
+	DWORD Stride = 0;
+	DWORD DrawCount = 0;
+	std::vector<BYTE> Vertices;
+	std::vector<WORD> Indices;
+
+	// Ring buffers used to upload the batch
+	LPDIRECT3DVERTEXBUFFER9 VertexBuffer = nullptr;
+	LPDIRECT3DINDEXBUFFER9 IndexBuffer = nullptr;
+	UINT VertexBufferPos = 0;
+	UINT IndexBufferPos = 0;
+
+	static D3DPRIMITIVETYPE GetListType(D3DPRIMITIVETYPE dptPrimitiveType);
+	void AddIndices(D3DPRIMITIVETYPE dptPrimitiveType, WORD BaseVertex, const WORD* lpIndices, DWORD dwCount);
+	HRESULT UploadBuffers(LPDIRECT3DDEVICE9 d3d9Device, UINT& BaseVertex, UINT& StartIndex);
+
+public:
+	~DrawBatch() { ReleaseBuffers(); }
+
+	bool IsEmpty() { return Indices.empty(); }
+	DWORD GetFVF() { return FVF; }
+	DWORD GetFlags() { return Flags; }
+	DWORD GetDirectXVersion() { return DirectXVersion; }
+	DWORD GetColorKeyLow() { return ColorKeyLow; }
+	DWORD GetColorKeyHigh() { return ColorKeyHigh; }
+	DWORD GetDrawCount() { return DrawCount; }
+
+	// Returns false if the draw cannot be added to the current batch
+	bool Add(D3DPRIMITIVETYPE dptPrimitiveType, DWORD dwVertexTypeDesc, DWORD dwFlags, DWORD dwDirectXVersion, DWORD dwColorKeyLow, DWORD dwColorKeyHigh,
+		const void* lpVertices, DWORD dwVertexCount, const WORD* lpIndices, DWORD dwIndexCount);
+	HRESULT Draw(LPDIRECT3DDEVICE9 d3d9Device);
+	void Clear();
+	void ReleaseBuffers();
+};
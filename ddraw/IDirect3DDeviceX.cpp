@@ -176,6 +176,25 @@ HRESULT m_IDirect3DDeviceX::CreateExecuteBuffer(LPD3DEXECUTEBUFFERDESC lpDesc, L
 {
 	Logging::LogDebug() << __FUNCTION__ << " (" << this << ")";
 
+	if (Config.Dd7to9)
+	{
+		if (!lpDesc || !lplpDirect3DExecuteBuffer || lpDesc->dwSize != sizeof(D3DEXECUTEBUFFERDESC) ||
+			!(lpDesc->dwFlags & D3DDEB_BUFSIZE) || !lpDesc->dwBufferSize)
+		{
+			return DDERR_INVALIDPARAMS;
+		}
+
+		// Check for device interface
+		if (FAILED(CheckInterface(__FUNCTION__, false)))
+		{
+			return DDERR_GENERIC;
+		}
+
+		*lplpDirect3DExecuteBuffer = new m_IDirect3DExecuteBuffer(ddrawParent->GetCurrentD3DDevice(), lpDesc);
+
+		return D3D_OK;
+	}
+
 	if (ProxyDirectXVersion != 1)
 	{
 		LOG_LIMIT(100, __FUNCTION__ << " Error: Not Implemented");
@@ -196,6 +215,47 @@ HRESULT m_IDirect3DDeviceX::Execute(LPDIRECT3DEXECUTEBUFFER lpDirect3DExecuteBuf
 {
 	Logging::LogDebug() << __FUNCTION__ << " (" << this << ")";
 
+	if (Config.Dd7to9)
+	{
+		if (!lpDirect3DExecuteBuffer)
+		{
+			return DDERR_INVALIDPARAMS;
+		}
+
+		// Check for device interface
+		if (FAILED(CheckInterface(__FUNCTION__, true)))
+		{
+			return DDERR_GENERIC;
+		}
+
+		m_IDirect3DExecuteBuffer* pExecuteBuffer = nullptr;
+		lpDirect3DExecuteBuffer->QueryInterface(IID_GetInterfaceX, (LPVOID*)&pExecuteBuffer);
+
+		if (!pExecuteBuffer)
+		{
+			LOG_LIMIT(100, __FUNCTION__ << " Error: could not get execute buffer wrapper!");
+			return DDERR_INVALIDPARAMS;
+		}
+
+		// Use the viewport passed in for this execute
+		if (lpDirect3DViewport)
+		{
+			D3DVIEWPORT Viewport = {};
+			Viewport.dwSize = sizeof(D3DVIEWPORT);
+
+			if (SUCCEEDED(lpDirect3DViewport->GetViewport(&Viewport)))
+			{
+				D3DVIEWPORT7 Viewport7;
+
+				ConvertViewport(Viewport7, Viewport);
+
+				SetViewport(&Viewport7);
+			}
+		}
+
+		return pExecuteBuffer->Execute(this, dwFlags);
+	}
+
 	if (ProxyDirectXVersion != 1)
 	{
 		LOG_LIMIT(100, __FUNCTION__ << " Error: Not Implemented");
@@ -253,6 +313,26 @@ HRESULT m_IDirect3DDeviceX::CreateMatrix(LPD3DMATRIXHANDLE lpD3DMatHandle)
 {
 	Logging::LogDebug() << __FUNCTION__ << " (" << this << ")";
 
+	if (Config.Dd7to9)
+	{
+		if (!lpD3DMatHandle)
+		{
+			return DDERR_INVALIDPARAMS;
+		}
+
+		// Zero is not a valid handle
+		if (!++LastMatrixHandle)
+		{
+			++LastMatrixHandle;
+		}
+
+		MatrixMap[LastMatrixHandle] = {};
+
+		*lpD3DMatHandle = LastMatrixHandle;
+
+		return D3D_OK;
+	}
+
 	if (ProxyDirectXVersion != 1)
 	{
 		LOG_LIMIT(100, __FUNCTION__ << " Error: Not Implemented");
@@ -266,6 +346,20 @@ HRESULT m_IDirect3DDeviceX::SetMatrix(D3DMATRIXHANDLE d3dMatHandle, const LPD3DM
 {
 	Logging::LogDebug() << __FUNCTION__ << " (" << this << ")";
 
+	if (Config.Dd7to9)
+	{
+		auto it = MatrixMap.find(d3dMatHandle);
+
+		if (!lpD3DMatrix || it == MatrixMap.end())
+		{
+			return DDERR_INVALIDPARAMS;
+		}
+
+		it->second = *lpD3DMatrix;
+
+		return D3D_OK;
+	}
+
 	if (ProxyDirectXVersion != 1)
 	{
 		LOG_LIMIT(100, __FUNCTION__ << " Error: Not Implemented");
@@ -279,6 +373,20 @@ HRESULT m_IDirect3DDeviceX::GetMatrix(D3DMATRIXHANDLE lpD3DMatHandle, LPD3DMATRI
 {
 	Logging::LogDebug() << __FUNCTION__ << " (" << this << ")";
 
+	if (Config.Dd7to9)
+	{
+		auto it = MatrixMap.find(lpD3DMatHandle);
+
+		if (!lpD3DMatrix || it == MatrixMap.end())
+		{
+			return DDERR_INVALIDPARAMS;
+		}
+
+		*lpD3DMatrix = it->second;
+
+		return D3D_OK;
+	}
+
 	if (ProxyDirectXVersion != 1)
 	{
 		LOG_LIMIT(100, __FUNCTION__ << " Error: Not Implemented");
@@ -292,6 +400,16 @@ HRESULT m_IDirect3DDeviceX::DeleteMatrix(D3DMATRIXHANDLE d3dMatHandle)
 {
 	Logging::LogDebug() << __FUNCTION__ << " (" << this << ")";
 
+	if (Config.Dd7to9)
+	{
+		if (!MatrixMap.erase(d3dMatHandle))
+		{
+			return DDERR_INVALIDPARAMS;
+		}
+
+		return D3D_OK;
+	}
+
 	if (ProxyDirectXVersion != 1)
 	{
 		LOG_LIMIT(100, __FUNCTION__ << " Error: Not Implemented");
@@ -1097,7 +1215,15 @@ HRESULT m_IDirect3DDeviceX::SetTextureStageState(DWORD dwStage, D3DTEXTURESTAGES
 		case D3DTSS_BORDERCOLOR:
 			return (*d3d9Device)->SetSamplerState(dwStage, D3DSAMP_BORDERCOLOR, dwValue);
 		case D3DTSS_MAGFILTER:
-			return (*d3d9Device)->SetSamplerState(dwStage, D3DSAMP_MAGFILTER, dwValue);
+		{
+			HRESULT hr = (*d3d9Device)->SetSamplerState(dwStage, D3DSAMP_MAGFILTER, dwValue);
+			if (SUCCEEDED(hr) && dwStage == 0 && !IsRecordingState)
+			{
+				DrawStates.ssMagFilter.Value = dwValue;
+				DrawStates.ssMagFilter.IsSet = true;
+			}
+			return hr;
+		}
 		case D3DTSS_MINFILTER:
 			return (*d3d9Device)->SetSamplerState(dwStage, D3DSAMP_MINFILTER, dwValue);
 		case D3DTSS_MIPFILTER:
@@ -2018,6 +2144,8 @@ HRESULT m_IDirect3DDeviceX::SetLight(DWORD dwLightIndex, LPD3DLIGHT7 lpLight)
 
 		if (SUCCEEDED(hr))
 		{
+			LightIndexCount = max(LightIndexCount, dwLightIndex + 1);
+
 #ifdef ENABLE_DEBUGOVERLAY
 			DOverlay.SetLight(dwLightIndex, lpLight);
 #endif
@@ -2068,6 +2196,8 @@ HRESULT m_IDirect3DDeviceX::LightEnable(DWORD dwLightIndex, BOOL bEnable)
 
 		if (SUCCEEDED(hr))
 		{
+			LightIndexCount = max(LightIndexCount, dwLightIndex + 1);
+
 #ifdef ENABLE_DEBUGOVERLAY
 			DOverlay.LightEnable(dwLightIndex, bEnable);
 #endif
@@ -2264,7 +2394,14 @@ HRESULT m_IDirect3DDeviceX::SetRenderState(D3DRENDERSTATETYPE dwRenderStateType,
 			LOG_LIMIT(100, __FUNCTION__ << " Warning: Render state type not implemented: " << dwRenderStateType);
 		}
 
-		return (*d3d9Device)->SetRenderState(dwRenderStateType, dwRenderState);
+		HRESULT hr = (*d3d9Device)->SetRenderState(dwRenderStateType, dwRenderState);
+
+		if (SUCCEEDED(hr))
+		{
+			SaveDrawState(dwRenderStateType, dwRenderState);
+		}
+
+		return hr;
 	}
 
 	switch (ProxyDirectXVersion)
@@ -2375,7 +2512,14 @@ HRESULT m_IDirect3DDeviceX::BeginStateBlock()
 			return DDERR_GENERIC;
 		}
 
-		return (*d3d9Device)->BeginStateBlock();
+		HRESULT hr = (*d3d9Device)->BeginStateBlock();
+
+		if (SUCCEEDED(hr))
+		{
+			IsRecordingState = true;
+		}
+
+		return hr;
 	}
 
 	return GetProxyInterfaceV7()->BeginStateBlock();
@@ -2398,6 +2542,8 @@ HRESULT m_IDirect3DDeviceX::EndStateBlock(LPDWORD lpdwBlockHandle)
 			return DDERR_GENERIC;
 		}
 
+		IsRecordingState = false;
+
 		// ToDo: Validate BlockHandle
 		return (*d3d9Device)->EndStateBlock(reinterpret_cast<IDirect3DStateBlock9**>(lpdwBlockHandle));
 	}
@@ -2418,13 +2564,22 @@ HRESULT m_IDirect3DDeviceX::DrawPrimitive(D3DPRIMITIVETYPE dptPrimitiveType, DWO
 			return DDERR_INVALIDPARAMS;
 		}
 
-		// Check for device interface
-		if (FAILED(CheckInterface(__FUNCTION__, true)))
+		// Check for device interface, batched draws are flushed below
+		if (FAILED(CheckInterface(__FUNCTION__, true, false)))
 		{
 			return DDERR_GENERIC;
 		}
 
-		// Update vertices for Direct3D9 (needs to be first)
+		// Check for color key
+		UpdateDrawFlags(dwFlags);
+
+		// Add to batched draws, legacy vertices are converted directly into the batch
+		if (AddToDrawBatch(dptPrimitiveType, dwVertexTypeDesc, lpVertices, dwVertexCount, nullptr, 0, dwFlags, DirectXVersion))
+		{
+			return D3D_OK;
+		}
+
+		// Update vertices for Direct3D9
 		UpdateVertices(dwVertexTypeDesc, lpVertices, dwVertexCount);
 
 		// Set fixed function vertex type
@@ -2434,9 +2589,6 @@ HRESULT m_IDirect3DDeviceX::DrawPrimitive(D3DPRIMITIVETYPE dptPrimitiveType, DWO
 			return D3DERR_INVALIDVERTEXTYPE;
 		}
 
-		// Check for color key
-		UpdateDrawFlags(dwFlags);
-
 		// Handle dwFlags
 		SetDrawStates(dwVertexTypeDesc, dwFlags, DirectXVersion);
 
@@ -2649,13 +2801,22 @@ HRESULT m_IDirect3DDeviceX::DrawIndexedPrimitive(D3DPRIMITIVETYPE dptPrimitiveTy
 			return DDERR_INVALIDPARAMS;
 		}
 
-		// Check for device interface
-		if (FAILED(CheckInterface(__FUNCTION__, true)))
+		// Check for device interface, batched draws are flushed below
+		if (FAILED(CheckInterface(__FUNCTION__, true, false)))
 		{
 			return DDERR_GENERIC;
 		}
 
-		// Update vertices for Direct3D9 (needs to be first)
+		// Check for color key
+		UpdateDrawFlags(dwFlags);
+
+		// Add to batched draws, legacy vertices are converted directly into the batch
+		if (AddToDrawBatch(dptPrimitiveType, dwVertexTypeDesc, lpVertices, dwVertexCount, lpIndices, dwIndexCount, dwFlags, DirectXVersion))
+		{
+			return D3D_OK;
+		}
+
+		// Update vertices for Direct3D9
 		UpdateVertices(dwVertexTypeDesc, lpVertices, dwVertexCount);
 
 		// Set fixed function vertex type
@@ -2665,9 +2826,6 @@ HRESULT m_IDirect3DDeviceX::DrawIndexedPrimitive(D3DPRIMITIVETYPE dptPrimitiveTy
 			return D3DERR_INVALIDVERTEXTYPE;
 		}
 
-		// Check for color key
-		UpdateDrawFlags(dwFlags);
-
 		// Handle dwFlags
 		SetDrawStates(dwVertexTypeDesc, dwFlags, DirectXVersion);
 
@@ -2954,6 +3112,9 @@ HRESULT m_IDirect3DDeviceX::ApplyStateBlock(DWORD dwBlockHandle)
 			return DDERR_INVALIDPARAMS;
 		}
 
+		// Applied states are not known until they are read back from the device
+		InvalidateDrawStates();
+
 		// ToDo: Validate BlockHandle
 		return reinterpret_cast<IDirect3DStateBlock9*>(dwBlockHandle)->Apply();
 	}
@@ -3311,7 +3472,7 @@ void m_IDirect3DDeviceX::ReleaseDevice()
 	}
 }
 
-HRESULT m_IDirect3DDeviceX::CheckInterface(char *FunctionName, bool CheckD3DDevice)
+HRESULT m_IDirect3DDeviceX::CheckInterface(char *FunctionName, bool CheckD3DDevice, bool FlushDraws)
 {
 	// Check ddrawParent device
 	if (!ddrawParent)
@@ -3335,6 +3496,12 @@ HRESULT m_IDirect3DDeviceX::CheckInterface(char *FunctionName, bool CheckD3DDevi
 			DOverlay.Setup(ddrawParent->GetHwnd(), *d3d9Device);
 		}
 #endif
+
+		// Draw batched primitives before anything else uses the device
+		if (FlushDraws)
+		{
+			FlushDrawBatch();
+		}
 	}
 
 	return DD_OK;
@@ -3359,6 +3526,92 @@ void m_IDirect3DDeviceX::ResetDevice()
 	}
 	// Reset clip status
 	ZeroMemory(&D3DClipStatus, sizeof(D3DCLIPSTATUS));
+
+	// Device states are reset to their defaults
+	InvalidateDrawStates();
+	IsRecordingState = false;
+}
+
+bool m_IDirect3DDeviceX::AddToDrawBatch(D3DPRIMITIVETYPE dptPrimitiveType, DWORD dwVertexTypeDesc, LPVOID lpVertices, DWORD dwVertexCount, LPWORD lpIndices, DWORD dwIndexCount, DWORD dwFlags, DWORD DirectXVersion)
+{
+	DWORD ColorKeyLow = (dwFlags & D3DDP_DXW_COLORKEYENABLE) ? DrawStates.dwColorSpaceLowValue : 0;
+	DWORD ColorKeyHigh = (dwFlags & D3DDP_DXW_COLORKEYENABLE) ? DrawStates.dwColorSpaceHighValue : 0;
+
+	if (Config.DdrawBatchPrimitives &&
+		PendingDraws.Add(dptPrimitiveType, dwVertexTypeDesc, dwFlags, DirectXVersion, ColorKeyLow, ColorKeyHigh, lpVertices, dwVertexCount, lpIndices, dwIndexCount))
+	{
+		return true;
+	}
+
+	// Draw doesn't match the pending batch so start a new one
+	FlushDrawBatch();
+
+	return (Config.DdrawBatchPrimitives &&
+		PendingDraws.Add(dptPrimitiveType, dwVertexTypeDesc, dwFlags, DirectXVersion, ColorKeyLow, ColorKeyHigh, lpVertices, dwVertexCount, lpIndices, dwIndexCount));
+}
+
+void m_IDirect3DDeviceX::FlushDrawBatch()
+{
+	if (PendingDraws.IsEmpty() || IsFlushingDraws)
+	{
+		return;
+	}
+
+	if (!d3d9Device || !*d3d9Device)
+	{
+		PendingDraws.Clear();
+		return;
+	}
+
+	// SetDrawStates calls back into the device so prevent flushing again
+	IsFlushingDraws = true;
+
+	DWORD dwVertexTypeDesc = PendingDraws.GetFVF();
+	DWORD dwFlags = PendingDraws.GetFlags();
+	DWORD DirectXVersion = PendingDraws.GetDirectXVersion();
+
+	Logging::LogDebug() << __FUNCTION__ << " Drawing " << PendingDraws.GetDrawCount() << " batched primitive calls";
+
+	// Keep the color key of the draw that caused the flush
+	DWORD ColorSpaceLowValue = DrawStates.dwColorSpaceLowValue;
+	DWORD ColorSpaceHighValue = DrawStates.dwColorSpaceHighValue;
+
+	// Set fixed function vertex type
+	if (SUCCEEDED((*d3d9Device)->SetFVF(dwVertexTypeDesc)))
+	{
+		DrawStates.dwColorSpaceLowValue = PendingDraws.GetColorKeyLow();
+		DrawStates.dwColorSpaceHighValue = PendingDraws.GetColorKeyHigh();
+
+		// Handle dwFlags
+		SetDrawStates(dwVertexTypeDesc, dwFlags, DirectXVersion);
+
+		HRESULT hr = PendingDraws.Draw(*d3d9Device);
+
+		// Handle dwFlags
+		RestoreDrawStates(dwVertexTypeDesc, dwFlags, DirectXVersion);
+
+		if (FAILED(hr))
+		{
+			LOG_LIMIT(100, __FUNCTION__ << " Error: batched draw call failed: " << (D3DERR)hr);
+		}
+	}
+	else
+	{
+		LOG_LIMIT(100, __FUNCTION__ << " Error: invalid FVF type: " << Logging::hex(dwVertexTypeDesc));
+	}
+
+	PendingDraws.Clear();
+
+	DrawStates.dwColorSpaceLowValue = ColorSpaceLowValue;
+	DrawStates.dwColorSpaceHighValue = ColorSpaceHighValue;
+
+	IsFlushingDraws = false;
+}
+
+void m_IDirect3DDeviceX::ReleaseDrawBatch()
+{
+	PendingDraws.Clear();
+	PendingDraws.ReleaseBuffers();
 }
 
 inline void m_IDirect3DDeviceX::UpdateDrawFlags(DWORD& dwFlags)
@@ -3370,27 +3623,78 @@ inline void m_IDirect3DDeviceX::UpdateDrawFlags(DWORD& dwFlags)
 	}
 }
 
+inline m_IDirect3DDeviceX::DRAWSTATE* m_IDirect3DDeviceX::GetDrawState(D3DRENDERSTATETYPE dwRenderStateType)
+{
+	switch ((DWORD)dwRenderStateType)
+	{
+	case D3DRS_CLIPPING:
+		return &DrawStates.rsClipping;
+	case D3DRS_LIGHTING:
+		return &DrawStates.rsLighting;
+	case D3DRS_ALPHABLENDENABLE:
+		return &DrawStates.rsAlphaBlendEnable;
+	case D3DRS_SRCBLEND:
+		return &DrawStates.rsSrcBlend;
+	case D3DRS_DESTBLEND:
+		return &DrawStates.rsDestBlend;
+	default:
+		return nullptr;
+	}
+}
+
+inline void m_IDirect3DDeviceX::SaveDrawState(D3DRENDERSTATETYPE dwRenderStateType, DWORD dwRenderState)
+{
+	// State blocks record states without applying them to the device
+	DRAWSTATE* pState = GetDrawState(dwRenderStateType);
+	if (pState && !IsRecordingState)
+	{
+		pState->Value = dwRenderState;
+		pState->IsSet = true;
+	}
+}
+
+void m_IDirect3DDeviceX::InvalidateDrawStates()
+{
+	DrawStates.rsClipping.IsSet = false;
+	DrawStates.rsLighting.IsSet = false;
+	DrawStates.rsAlphaBlendEnable.IsSet = false;
+	DrawStates.rsSrcBlend.IsSet = false;
+	DrawStates.rsDestBlend.IsSet = false;
+	DrawStates.ssMagFilter.IsSet = false;
+}
+
+inline void m_IDirect3DDeviceX::OverrideDrawState(D3DRENDERSTATETYPE dwRenderStateType, DWORD dwRenderState, DWORD Override)
+{
+	DRAWSTATE* pState = GetDrawState(dwRenderStateType);
+	if (!pState->IsSet)
+	{
+		(*d3d9Device)->GetRenderState(dwRenderStateType, &pState->Value);
+		pState->IsSet = true;
+	}
+
+	// Only change the device if the app's value is different
+	if (pState->Value != dwRenderState)
+	{
+		(*d3d9Device)->SetRenderState(dwRenderStateType, dwRenderState);
+		DrawStates.Overrides |= Override;
+	}
+}
+
 inline void m_IDirect3DDeviceX::SetDrawStates(DWORD dwVertexTypeDesc, DWORD dwFlags, DWORD DirectXVersion)
 {
 	if (DirectXVersion < 7)
 	{
 		// dwFlags (D3DDP_WAIT) can be ignored safely
+		// D3DDP_DONOTUPDATEEXTENTS can be ignored because D3DRENDERSTATE_EXTENTS is not implemented
 
 		// Handle dwFlags
 		if (dwFlags & D3DDP_DONOTCLIP)
 		{
-			GetRenderState(D3DRENDERSTATE_CLIPPING, &DrawStates.rsClipping);
-			SetRenderState(D3DRENDERSTATE_CLIPPING, FALSE);
+			OverrideDrawState(D3DRS_CLIPPING, FALSE, OVERRIDE_CLIPPING);
 		}
 		if ((dwFlags & D3DDP_DONOTLIGHT) || !(dwVertexTypeDesc & D3DFVF_NORMAL))
 		{
-			GetRenderState(D3DRENDERSTATE_LIGHTING, &DrawStates.rsLighting);
-			SetRenderState(D3DRENDERSTATE_LIGHTING, FALSE);
-		}
-		if (dwFlags & D3DDP_DONOTUPDATEEXTENTS)
-		{
-			GetRenderState(D3DRENDERSTATE_EXTENTS, &DrawStates.rsExtents);
-			SetRenderState(D3DRENDERSTATE_EXTENTS, FALSE);
+			OverrideDrawState(D3DRS_LIGHTING, FALSE, OVERRIDE_LIGHTING);
 		}
 	}
 	if (dwFlags & D3DDP_DXW_COLORKEYENABLE)
@@ -3420,36 +3724,58 @@ inline void m_IDirect3DDeviceX::SetDrawStates(DWORD dwVertexTypeDesc, DWORD dwFl
 	}
 	if (dwFlags & D3DDP_DXW_DRAW2DSURFACE)
 	{
-		(*d3d9Device)->GetRenderState(D3DRS_LIGHTING, &DrawStates.rsLighting);
-		(*d3d9Device)->GetSamplerState(0, D3DSAMP_MAGFILTER, &DrawStates.ssMagFilter);
+		OverrideDrawState(D3DRS_LIGHTING, FALSE, OVERRIDE_LIGHTING);
 
-		(*d3d9Device)->GetRenderState(D3DRS_ALPHABLENDENABLE, &DrawStates.rsAlphaBlendEnable);
-		(*d3d9Device)->GetRenderState(D3DRS_SRCBLEND, &DrawStates.rsSrcBlend);
-		(*d3d9Device)->GetRenderState(D3DRS_DESTBLEND, &DrawStates.rsDestBlend);
+		// Draw2DSurface sets point filtering itself so it only needs to be restored
+		if (!DrawStates.ssMagFilter.IsSet)
+		{
+			(*d3d9Device)->GetSamplerState(0, D3DSAMP_MAGFILTER, &DrawStates.ssMagFilter.Value);
+			DrawStates.ssMagFilter.IsSet = true;
+		}
+		if (DrawStates.ssMagFilter.Value != D3DTEXF_POINT)
+		{
+			DrawStates.Overrides |= OVERRIDE_MAGFILTER;
+		}
 
-		(*d3d9Device)->SetRenderState(D3DRS_ALPHABLENDENABLE, TRUE);
-		(*d3d9Device)->SetRenderState(D3DRS_SRCBLEND, D3DBLEND_ONE);
-		(*d3d9Device)->SetRenderState(D3DRS_DESTBLEND, D3DBLEND_ONE);
+		OverrideDrawState(D3DRS_ALPHABLENDENABLE, TRUE, OVERRIDE_ALPHABLENDENABLE);
+		OverrideDrawState(D3DRS_SRCBLEND, D3DBLEND_ONE, OVERRIDE_SRCBLEND);
+		OverrideDrawState(D3DRS_DESTBLEND, D3DBLEND_ONE, OVERRIDE_DESTBLEND);
 	}
 }
 
 inline void m_IDirect3DDeviceX::RestoreDrawStates(DWORD dwVertexTypeDesc, DWORD dwFlags, DWORD DirectXVersion)
 {
-	if (DirectXVersion < 7)
+	UNREFERENCED_PARAMETER(dwVertexTypeDesc);
+	UNREFERENCED_PARAMETER(DirectXVersion);
+
+	// Only revert the states that SetDrawStates changed
+	if (DrawStates.Overrides)
 	{
-		// Handle dwFlags
-		if (dwFlags & D3DDP_DONOTCLIP)
+		if (DrawStates.Overrides & OVERRIDE_CLIPPING)
 		{
-			SetRenderState(D3DRENDERSTATE_CLIPPING, DrawStates.rsClipping);
+			(*d3d9Device)->SetRenderState(D3DRS_CLIPPING, DrawStates.rsClipping.Value);
 		}
-		if ((dwFlags & D3DDP_DONOTLIGHT) || !(dwVertexTypeDesc & D3DFVF_NORMAL))
+		if (DrawStates.Overrides & OVERRIDE_LIGHTING)
+		{
+			(*d3d9Device)->SetRenderState(D3DRS_LIGHTING, DrawStates.rsLighting.Value);
+		}
+		if (DrawStates.Overrides & OVERRIDE_ALPHABLENDENABLE)
+		{
+			(*d3d9Device)->SetRenderState(D3DRS_ALPHABLENDENABLE, DrawStates.rsAlphaBlendEnable.Value);
+		}
+		if (DrawStates.Overrides & OVERRIDE_SRCBLEND)
+		{
+			(*d3d9Device)->SetRenderState(D3DRS_SRCBLEND, DrawStates.rsSrcBlend.Value);
+		}
+		if (DrawStates.Overrides & OVERRIDE_DESTBLEND)
 		{
-			SetRenderState(D3DRENDERSTATE_LIGHTING, DrawStates.rsLighting);
+			(*d3d9Device)->SetRenderState(D3DRS_DESTBLEND, DrawStates.rsDestBlend.Value);
 		}
-		if (dwFlags & D3DDP_DONOTUPDATEEXTENTS)
+		if (DrawStates.Overrides & OVERRIDE_MAGFILTER)
 		{
-			SetRenderState(D3DRENDERSTATE_EXTENTS, DrawStates.rsExtents);
+			(*d3d9Device)->SetSamplerState(0, D3DSAMP_MAGFILTER, DrawStates.ssMagFilter.Value);
 		}
+		DrawStates.Overrides = 0;
 	}
 	if (dwFlags & D3DDP_DXW_COLORKEYENABLE)
 	{
@@ -3457,13 +3783,6 @@ inline void m_IDirect3DDeviceX::RestoreDrawStates(DWORD dwVertexTypeDesc, DWORD
 	}
 	if (dwFlags & D3DDP_DXW_DRAW2DSURFACE)
 	{
-		(*d3d9Device)->SetRenderState(D3DRS_ALPHABLENDENABLE, DrawStates.rsAlphaBlendEnable);
-		(*d3d9Device)->SetRenderState(D3DRS_SRCBLEND, DrawStates.rsSrcBlend);
-		(*d3d9Device)->SetRenderState(D3DRS_DESTBLEND, DrawStates.rsDestBlend);
-
-		(*d3d9Device)->SetRenderState(D3DRS_LIGHTING, DrawStates.rsLighting);
-		(*d3d9Device)->SetSamplerState(0, D3DSAMP_MAGFILTER, DrawStates.ssMagFilter);
-
 		(*d3d9Device)->SetPixelShader(nullptr);
 
 		SetTexture(0, AttachedTexture[0]);
@@ -3476,16 +3795,10 @@ inline void m_IDirect3DDeviceX::ScaleVertices(DWORD dwVertexTypeDesc, LPVOID& lp
 	if (dwVertexTypeDesc == 3)
 	{
 		VertexCache.resize(dwVertexCount * sizeof(D3DTLVERTEX));
-		memcpy(VertexCache.data(), lpVertices, dwVertexCount * sizeof(D3DTLVERTEX));
-		D3DTLVERTEX* pVert = (D3DTLVERTEX*)VertexCache.data();
+		VertexConvert::ScaleXYZRHW(VertexCache.data(), (BYTE*)lpVertices, sizeof(D3DTLVERTEX), dwVertexCount,
+			ScaleDDWidthRatio, ScaleDDHeightRatio, (float)ScaleDDPadX, (float)ScaleDDPadY);
 
-		for (DWORD x = 0; x < dwVertexCount; x++)
-		{
-			pVert[x].sx = (D3DVALUE)(pVert[x].sx * ScaleDDWidthRatio) + ScaleDDPadX;
-			pVert[x].sy = (D3DVALUE)(pVert[x].sy * ScaleDDHeightRatio) + ScaleDDPadY;
-		}
-
-		lpVertices = pVert;
+		lpVertices = VertexCache.data();
 	}
 }
 
@@ -3494,7 +3807,7 @@ inline void m_IDirect3DDeviceX::UpdateVertices(DWORD& dwVertexTypeDesc, LPVOID&
 	if (dwVertexTypeDesc == D3DFVF_LVERTEX)
 	{
 		VertexCache.resize(dwVertexCount * sizeof(D3DLVERTEX9));
-		ConvertVertices((D3DLVERTEX9*)VertexCache.data(), (D3DLVERTEX*)lpVertices, dwVertexCount);
+		VertexConvert::LVertexToLVertex9((D3DLVERTEX9*)VertexCache.data(), (D3DLVERTEX*)lpVertices, dwVertexCount);
 
 		dwVertexTypeDesc = D3DFVF_LVERTEX9;
 		lpVertices = VertexCache.data();
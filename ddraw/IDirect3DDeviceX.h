@@ -22,17 +22,36 @@ private:
 	LPDIRECT3DPIXELSHADER9* colorkeyPixelShader = nullptr;
 	LPDIRECT3DVIEWPORT3 lpCurrentViewport = nullptr;
 
+	// States overridden around draws, the app's values are shadowed so the device doesn't need to be queried for every draw
+	struct DRAWSTATE
+	{
+		DWORD Value = 0;
+		bool IsSet = false;		// Value is unknown until the app sets it or it is read from the device
+	};
+	enum DRAWSTATEOVERRIDE
+	{
+		OVERRIDE_CLIPPING = 0x01,
+		OVERRIDE_LIGHTING = 0x02,
+		OVERRIDE_ALPHABLENDENABLE = 0x04,
+		OVERRIDE_SRCBLEND = 0x08,
+		OVERRIDE_DESTBLEND = 0x10,
+		OVERRIDE_MAGFILTER = 0x20,
+	};
 	struct {
-		DWORD rsClipping = 0;
-		DWORD rsLighting = 0;
-		DWORD rsExtents = 0;
-		DWORD rsAlphaBlendEnable = 0;
-		DWORD rsSrcBlend = 0;
-		DWORD rsDestBlend = 0;
-		DWORD ssMagFilter = 0;
+		DRAWSTATE rsClipping;
+		DRAWSTATE rsLighting;
+		DRAWSTATE rsAlphaBlendEnable;
+		DRAWSTATE rsSrcBlend;
+		DRAWSTATE rsDestBlend;
+		DRAWSTATE ssMagFilter;
+		DWORD Overrides = 0;		// States changed by SetDrawStates that RestoreDrawStates needs to revert
 		DWORD dwColorSpaceLowValue = 0;
 		DWORD dwColorSpaceHighValue = 0;
 	} DrawStates;
+	bool IsRecordingState = false;
+
+	// Highest light index used plus one, limits the search for enabled lights
+	DWORD LightIndexCount = 0;
 
 	// Store d3d device version wrappers
 	m_IDirect3DDevice *WrapperInterface;
@@ -54,6 +73,17 @@ private:
 	// Vector temporary buffer cache
 	std::vector<BYTE> VertexCache;
 
+	// Batched draw primitive calls
+	DrawBatch PendingDraws;
+	bool IsFlushingDraws = false;
+
+	// Matrix handles used by execute buffers
+	std::unordered_map<D3DMATRIXHANDLE, D3DMATRIX> MatrixMap;
+	D3DMATRIXHANDLE LastMatrixHandle = 0;
+
+	// Texture handles used by execute buffers, registered when the app gets a texture's handle
+	std::unordered_map<D3DTEXTUREHANDLE, m_IDirect3DTextureX*> TextureHandleMap;
+
 	// Viewport array
 	std::vector<LPDIRECT3DVIEWPORT3> AttachedViewports;
 
@@ -114,14 +144,19 @@ private:
 	void ReleaseDevice();
 
 	// Check interfaces
-	HRESULT CheckInterface(char *FunctionName, bool CheckD3DDevice);
+	HRESULT CheckInterface(char *FunctionName, bool CheckD3DDevice, bool FlushDraws = true);
 
 	// Helper functions
 	void m_IDirect3DDeviceX::UpdateDrawFlags(DWORD& dwFlags);
+	DRAWSTATE* GetDrawState(D3DRENDERSTATETYPE dwRenderStateType);
+	void SaveDrawState(D3DRENDERSTATETYPE dwRenderStateType, DWORD dwRenderState);
+	void InvalidateDrawStates();
+	void OverrideDrawState(D3DRENDERSTATETYPE dwRenderStateType, DWORD dwRenderState, DWORD Override);
 	void SetDrawStates(DWORD dwVertexTypeDesc, DWORD dwFlags, DWORD DirectXVersion);
 	void RestoreDrawStates(DWORD dwVertexTypeDesc, DWORD dwFlags, DWORD DirectXVersion);
 	void ScaleVertices(DWORD dwVertexTypeDesc, LPVOID& lpVertices, DWORD dwVertexCount);
 	void UpdateVertices(DWORD& dwVertexTypeDesc, LPVOID& lpVertices, DWORD dwVertexCount);
+	bool AddToDrawBatch(D3DPRIMITIVETYPE dptPrimitiveType, DWORD dwVertexTypeDesc, LPVOID lpVertices, DWORD dwVertexCount, LPWORD lpIndices, DWORD dwIndexCount, DWORD dwFlags, DWORD DirectXVersion);
 
 public:
 	m_IDirect3DDeviceX(IDirect3DDevice7 *aOriginal, DWORD DirectXVersion) : ProxyInterface(aOriginal), ClassID(IID_IDirect3DHALDevice)
@@ -253,4 +288,16 @@ public:
 	}
 	void ClearDdraw() { ddrawParent = nullptr; colorkeyPixelShader = nullptr; }
 	void ResetDevice();
+	void FlushDrawBatch();
+	void ReleaseDrawBatch();
+	DWORD GetLightIndexCount() { return LightIndexCount; }
+
+	// Texture handle functions
+	void SetTextureHandle(D3DTEXTUREHANDLE tHandle, m_IDirect3DTextureX* lpTextureX) { TextureHandleMap[tHandle] = lpTextureX; }
+	void ClearTextureHandle(D3DTEXTUREHANDLE tHandle) { TextureHandleMap.erase(tHandle); }
+	m_IDirect3DTextureX* GetTextureFromHandle(D3DTEXTUREHANDLE tHandle)
+	{
+		auto it = TextureHandleMap.find(tHandle);
+		return (it != TextureHandleMap.end()) ? it->second : nullptr;
+	}
 };
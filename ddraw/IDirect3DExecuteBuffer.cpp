@@ -107,8 +107,27 @@ HRESULT m_IDirect3DExecuteBuffer::Lock(LPD3DEXECUTEBUFFERDESC lpDesc)
 
 	if (!ProxyInterface)
 	{
-		LOG_LIMIT(100, __FUNCTION__ << " Error: Not Implemented");
-		return DDERR_UNSUPPORTED;
+		if (!lpDesc || lpDesc->dwSize != sizeof(D3DEXECUTEBUFFERDESC))
+		{
+			return DDERR_INVALIDPARAMS;
+		}
+
+		if (IsLocked)
+		{
+			return D3DERR_EXECUTE_LOCKED;
+		}
+
+		IsLocked = true;
+
+		// Instructions need to be decoded again after the buffer is changed
+		IsDecoded = false;
+
+		lpDesc->dwFlags = Desc.dwFlags;
+		lpDesc->dwCaps = Desc.dwCaps;
+		lpDesc->dwBufferSize = Desc.dwBufferSize;
+		lpDesc->lpData = Desc.lpData;
+
+		return D3D_OK;
 	}
 
 	return ProxyInterface->Lock(lpDesc);
@@ -120,8 +139,14 @@ HRESULT m_IDirect3DExecuteBuffer::Unlock()
 
 	if (!ProxyInterface)
 	{
-		LOG_LIMIT(100, __FUNCTION__ << " Error: Not Implemented");
-		return DDERR_UNSUPPORTED;
+		if (!IsLocked)
+		{
+			return D3DERR_EXECUTE_NOT_LOCKED;
+		}
+
+		IsLocked = false;
+
+		return D3D_OK;
 	}
 
 	return ProxyInterface->Unlock();
@@ -133,8 +158,17 @@ HRESULT m_IDirect3DExecuteBuffer::SetExecuteData(LPD3DEXECUTEDATA lpData)
 
 	if (!ProxyInterface)
 	{
-		LOG_LIMIT(100, __FUNCTION__ << " Error: Not Implemented");
-		return DDERR_UNSUPPORTED;
+		if (!lpData || lpData->dwSize != sizeof(D3DEXECUTEDATA))
+		{
+			return DDERR_INVALIDPARAMS;
+		}
+
+		ExecuteData = *lpData;
+
+		// Instructions need to be decoded again after the execute data is changed
+		IsDecoded = false;
+
+		return D3D_OK;
 	}
 
 	return ProxyInterface->SetExecuteData(lpData);
@@ -146,8 +180,14 @@ HRESULT m_IDirect3DExecuteBuffer::GetExecuteData(LPD3DEXECUTEDATA lpData)
 
 	if (!ProxyInterface)
 	{
-		LOG_LIMIT(100, __FUNCTION__ << " Error: Not Implemented");
-		return DDERR_UNSUPPORTED;
+		if (!lpData || lpData->dwSize != sizeof(D3DEXECUTEDATA))
+		{
+			return DDERR_INVALIDPARAMS;
+		}
+
+		*lpData = ExecuteData;
+
+		return D3D_OK;
 	}
 
 	return ProxyInterface->GetExecuteData(lpData);
@@ -172,8 +212,13 @@ HRESULT m_IDirect3DExecuteBuffer::Optimize(DWORD dwDummy)
 
 	if (!ProxyInterface)
 	{
-		LOG_LIMIT(100, __FUNCTION__ << " Error: Not Implemented");
-		return DDERR_UNSUPPORTED;
+		if (IsLocked)
+		{
+			return D3DERR_EXECUTE_LOCKED;
+		}
+
+		// Decode the instruction stream now so that Execute can reuse it
+		return DecodeInstructions();
 	}
 
 	return ProxyInterface->Optimize(dwDummy);
@@ -183,12 +228,417 @@ HRESULT m_IDirect3DExecuteBuffer::Optimize(DWORD dwDummy)
 /*** Helper functions ***/
 /************************/
 
-void m_IDirect3DExecuteBuffer::InitExecuteBuffer()
+void m_IDirect3DExecuteBuffer::InitExecuteBuffer(LPD3DEXECUTEBUFFERDESC lpDesc)
+{
+	if (!lpDesc)
+	{
+		return;
+	}
+
+	Desc.dwSize = sizeof(D3DEXECUTEBUFFERDESC);
+	Desc.dwFlags = D3DDEB_BUFSIZE | D3DDEB_CAPS | D3DDEB_LPDATA;
+	Desc.dwCaps = (lpDesc->dwFlags & D3DDEB_CAPS) ? lpDesc->dwCaps : D3DDEBCAPS_SYSTEMMEMORY;
+	Desc.dwBufferSize = (lpDesc->dwFlags & D3DDEB_BUFSIZE) ? lpDesc->dwBufferSize : 0;
+
+	// Use application memory if it was provided
+	if ((lpDesc->dwFlags & D3DDEB_LPDATA) && lpDesc->lpData)
+	{
+		Desc.lpData = lpDesc->lpData;
+	}
+	else
+	{
+		MemoryData.resize(Desc.dwBufferSize);
+		Desc.lpData = MemoryData.data();
+	}
+
+	ExecuteData.dwSize = sizeof(D3DEXECUTEDATA);
+}
+
+static DWORD GetInstructionDataSize(BYTE bOpcode)
+{
+	switch (bOpcode)
+	{
+	case D3DOP_POINT:
+		return sizeof(D3DPOINT);
+	case D3DOP_LINE:
+		return sizeof(D3DLINE);
+	case D3DOP_TRIANGLE:
+		return sizeof(D3DTRIANGLE);
+	case D3DOP_MATRIXLOAD:
+		return sizeof(D3DMATRIXLOAD);
+	case D3DOP_MATRIXMULTIPLY:
+		return sizeof(D3DMATRIXMULTIPLY);
+	case D3DOP_STATETRANSFORM:
+	case D3DOP_STATELIGHT:
+	case D3DOP_STATERENDER:
+		return sizeof(D3DSTATE);
+	case D3DOP_PROCESSVERTICES:
+		return sizeof(D3DPROCESSVERTICES);
+	case D3DOP_TEXTURELOAD:
+		return sizeof(D3DTEXTURELOAD);
+	case D3DOP_EXIT:
+		return 0;
+	case D3DOP_BRANCHFORWARD:
+		return sizeof(D3DBRANCH);
+	case D3DOP_SPAN:
+		return sizeof(D3DSPAN);
+	case D3DOP_SETSTATUS:
+		return sizeof(D3DSTATUS);
+	default:
+		return (DWORD)-1;
+	}
+}
+
+HRESULT m_IDirect3DExecuteBuffer::DecodeInstructions()
+{
+	if (IsDecoded)
+	{
+		return D3D_OK;
+	}
+
+	Instructions.clear();
+
+	DWORD Offset = ExecuteData.dwInstructionOffset;
+	DWORD EndOffset = ExecuteData.dwInstructionOffset + ExecuteData.dwInstructionLength;
+
+	if (EndOffset < Offset || EndOffset > Desc.dwBufferSize ||
+		ExecuteData.dwVertexOffset > Desc.dwBufferSize ||
+		ExecuteData.dwVertexCount > (Desc.dwBufferSize - ExecuteData.dwVertexOffset) / ExecuteVertexSize)
+	{
+		LOG_LIMIT(100, __FUNCTION__ << " Error: execute data does not fit in the buffer!");
+		return DDERR_INVALIDPARAMS;
+	}
+
+	// Instructions after an exit can still be reached by a branch, so the whole range is decoded
+	// Data that does not decode after an exit is not an error, the exit ends execution before it
+	bool HasExit = false;
+
+	while (Offset + sizeof(D3DINSTRUCTION) <= EndOffset)
+	{
+		D3DINSTRUCTION *lpInstruction = (D3DINSTRUCTION*)((BYTE*)Desc.lpData + Offset);
+		DWORD DataSize = lpInstruction->bSize * lpInstruction->wCount;
+
+		if (DataSize > EndOffset - Offset - sizeof(D3DINSTRUCTION))
+		{
+			if (HasExit)
+			{
+				break;
+			}
+			LOG_LIMIT(100, __FUNCTION__ << " Error: instruction data does not fit in the buffer: " << (DWORD)lpInstruction->bOpcode);
+			return DDERR_INVALIDPARAMS;
+		}
+
+		DWORD MinSize = GetInstructionDataSize(lpInstruction->bOpcode);
+
+		if (MinSize == (DWORD)-1)
+		{
+			LOG_LIMIT(100, __FUNCTION__ << " Warning: skipping unknown opcode: " << (DWORD)lpInstruction->bOpcode);
+		}
+		else if (lpInstruction->wCount && lpInstruction->bSize < MinSize)
+		{
+			LOG_LIMIT(100, __FUNCTION__ << " Warning: skipping opcode with invalid size: " << (DWORD)lpInstruction->bOpcode << " " << (DWORD)lpInstruction->bSize);
+		}
+		else
+		{
+			Instructions.push_back({ Offset, lpInstruction->bOpcode, lpInstruction->bSize, lpInstruction->wCount });
+		}
+
+		if (lpInstruction->bOpcode == D3DOP_EXIT)
+		{
+			HasExit = true;
+		}
+
+		Offset += sizeof(D3DINSTRUCTION) + DataSize;
+	}
+
+	IsDecoded = true;
+
+	return D3D_OK;
+}
+
+HRESULT m_IDirect3DExecuteBuffer::DrawIndexed(m_IDirect3DDeviceX *pDevice, D3DPRIMITIVETYPE dptPrimitiveType, DWORD dwFlags)
+{
+	const size_t PrimitiveSize = (dptPrimitiveType == D3DPT_LINELIST) ? 2 : 3;
+	HRESULT hr = D3D_OK;
+
+	// A primitive uses the vertex type of its first vertex, the draw is split where the vertex type changes
+	size_t Start = 0;
+	while (Start < IndexCache.size())
+	{
+		const DWORD FVF = ProcessedFVF[IndexCache[Start]];
+		size_t End = Start + PrimitiveSize;
+		while (End < IndexCache.size() && ProcessedFVF[IndexCache[End]] == FVF)
+		{
+			End += PrimitiveSize;
+		}
+
+		// Only send the range of vertices used by the indices
+		WORD MinIndex = *std::min_element(IndexCache.begin() + Start, IndexCache.begin() + End);
+		WORD MaxIndex = *std::max_element(IndexCache.begin() + Start, IndexCache.begin() + End);
+
+		if (MinIndex)
+		{
+			for (size_t i = Start; i < End; i++)
+			{
+				IndexCache[i] -= MinIndex;
+			}
+		}
+
+		HRESULT DrawResult = pDevice->DrawIndexedPrimitive(dptPrimitiveType, FVF, &ProcessedVertices[MinIndex * ExecuteVertexSize], MaxIndex - MinIndex + 1,
+			&IndexCache[Start], (DWORD)(End - Start), dwFlags, 1);
+
+		if (SUCCEEDED(hr))
+		{
+			hr = DrawResult;
+		}
+
+		Start = End;
+	}
+
+	return hr;
+}
+
+static void MultiplyMatrix(D3DMATRIX& Matrix, const D3DMATRIX& Matrix1, const D3DMATRIX& Matrix2)
 {
-	// To add later
+	for (UINT x = 0; x < 4; x++)
+	{
+		for (UINT y = 0; y < 4; y++)
+		{
+			Matrix.m[x][y] = Matrix1.m[x][0] * Matrix2.m[0][y] + Matrix1.m[x][1] * Matrix2.m[1][y] + Matrix1.m[x][2] * Matrix2.m[2][y] + Matrix1.m[x][3] * Matrix2.m[3][y];
+		}
+	}
 }
 
-void m_IDirect3DExecuteBuffer::ReleaseExecuteBuffer()
+HRESULT m_IDirect3DExecuteBuffer::Execute(m_IDirect3DDeviceX *pDevice, DWORD dwFlags)
 {
-	// To add later
+	if (!pDevice)
+	{
+		return DDERR_INVALIDPARAMS;
+	}
+
+	if (IsLocked)
+	{
+		return D3DERR_EXECUTE_LOCKED;
+	}
+
+	if (FAILED(DecodeInstructions()))
+	{
+		return D3DERR_EXECUTE_FAILED;
+	}
+
+	const DWORD VertexCount = ExecuteData.dwVertexCount;
+	const BYTE *lpVertexData = (BYTE*)Desc.lpData + ExecuteData.dwVertexOffset;
+
+	if (ProcessedVertices.size() < VertexCount * ExecuteVertexSize)
+	{
+		ProcessedVertices.resize(VertexCount * ExecuteVertexSize);
+	}
+	if (ProcessedFVF.size() < VertexCount)
+	{
+		ProcessedFVF.resize(VertexCount, D3DFVF_TLVERTEX);
+	}
+
+	const DWORD DrawFlags = (dwFlags & D3DEXECUTE_UNCLIPPED) ? D3DDP_DONOTCLIP : 0;
+
+	size_t x = 0;
+	while (x < Instructions.size())
+	{
+		const EXECUTEINSTRUCTION &Instruction = Instructions[x];
+		BYTE *lpData = (BYTE*)Desc.lpData + Instruction.Offset + sizeof(D3DINSTRUCTION);
+		size_t Next = x + 1;
+
+		switch (Instruction.bOpcode)
+		{
+		case D3DOP_POINT:
+			for (DWORD i = 0; i < Instruction.wCount; i++, lpData += Instruction.bSize)
+			{
+				D3DPOINT *lpPoint = (D3DPOINT*)lpData;
+				if (lpPoint->wCount && lpPoint->wFirst + lpPoint->wCount <= VertexCount)
+				{
+					pDevice->DrawPrimitive(D3DPT_POINTLIST, ProcessedFVF[lpPoint->wFirst], &ProcessedVertices[lpPoint->wFirst * ExecuteVertexSize], lpPoint->wCount, DrawFlags, 1);
+				}
+			}
+			break;
+
+		case D3DOP_LINE:
+			IndexCache.clear();
+			for (DWORD i = 0; i < Instruction.wCount; i++, lpData += Instruction.bSize)
+			{
+				D3DLINE *lpLine = (D3DLINE*)lpData;
+				if (lpLine->wV1 < VertexCount && lpLine->wV2 < VertexCount)
+				{
+					IndexCache.push_back(lpLine->wV1);
+					IndexCache.push_back(lpLine->wV2);
+				}
+			}
+			DrawIndexed(pDevice, D3DPT_LINELIST, DrawFlags);
+			break;
+
+		case D3DOP_TRIANGLE:
+			// Edge and strip flags are only hints, the indices are always explicit
+			IndexCache.clear();
+			for (DWORD i = 0; i < Instruction.wCount; i++, lpData += Instruction.bSize)
+			{
+				D3DTRIANGLE *lpTriangle = (D3DTRIANGLE*)lpData;
+				if (lpTriangle->wV1 < VertexCount && lpTriangle->wV2 < VertexCount && lpTriangle->wV3 < VertexCount)
+				{
+					IndexCache.push_back(lpTriangle->wV1);
+					IndexCache.push_back(lpTriangle->wV2);
+					IndexCache.push_back(lpTriangle->wV3);
+				}
+			}
+			DrawIndexed(pDevice, D3DPT_TRIANGLELIST, DrawFlags);
+			break;
+
+		case D3DOP_MATRIXLOAD:
+			for (DWORD i = 0; i < Instruction.wCount; i++, lpData += Instruction.bSize)
+			{
+				D3DMATRIXLOAD *lpMatrixLoad = (D3DMATRIXLOAD*)lpData;
+				D3DMATRIX Matrix;
+				if (SUCCEEDED(pDevice->GetMatrix(lpMatrixLoad->hSrcMatrix, &Matrix)))
+				{
+					pDevice->SetMatrix(lpMatrixLoad->hDestMatrix, &Matrix);
+				}
+			}
+			break;
+
+		case D3DOP_MATRIXMULTIPLY:
+			for (DWORD i = 0; i < Instruction.wCount; i++, lpData += Instruction.bSize)
+			{
+				D3DMATRIXMULTIPLY *lpMatrixMultiply = (D3DMATRIXMULTIPLY*)lpData;
+				D3DMATRIX Matrix, Matrix1, Matrix2;
+				if (SUCCEEDED(pDevice->GetMatrix(lpMatrixMultiply->hSrcMatrix1, &Matrix1)) &&
+					SUCCEEDED(pDevice->GetMatrix(lpMatrixMultiply->hSrcMatrix2, &Matrix2)))
+				{
+					MultiplyMatrix(Matrix, Matrix1, Matrix2);
+					pDevice->SetMatrix(lpMatrixMultiply->hDestMatrix, &Matrix);
+				}
+			}
+			break;
+
+		case D3DOP_STATETRANSFORM:
+			for (DWORD i = 0; i < Instruction.wCount; i++, lpData += Instruction.bSize)
+			{
+				D3DSTATE *lpState = (D3DSTATE*)lpData;
+				D3DMATRIX Matrix;
+				if (SUCCEEDED(pDevice->GetMatrix(lpState->dwArg[0], &Matrix)))
+				{
+					// The transform state type shares the union with the render state type
+					pDevice->SetTransform((D3DTRANSFORMSTATETYPE)lpState->drstRenderStateType, &Matrix);
+				}
+			}
+			break;
+
+		case D3DOP_STATELIGHT:
+			for (DWORD i = 0; i < Instruction.wCount; i++, lpData += Instruction.bSize)
+			{
+				D3DSTATE *lpState = (D3DSTATE*)lpData;
+				pDevice->SetLightState(lpState->dlstLightStateType, lpState->dwArg[0]);
+			}
+			break;
+
+		case D3DOP_STATERENDER:
+			for (DWORD i = 0; i < Instruction.wCount; i++, lpData += Instruction.bSize)
+			{
+				D3DSTATE *lpState = (D3DSTATE*)lpData;
+				pDevice->SetRenderState(lpState->drstRenderStateType, lpState->dwArg[0]);
+			}
+			break;
+
+		case D3DOP_PROCESSVERTICES:
+			// Vertices are transformed and lit by Direct3D9 when they are drawn
+			for (DWORD i = 0; i < Instruction.wCount; i++, lpData += Instruction.bSize)
+			{
+				D3DPROCESSVERTICES *lpProcess = (D3DPROCESSVERTICES*)lpData;
+				if (lpProcess->dwCount > VertexCount || lpProcess->wStart > VertexCount - lpProcess->dwCount || lpProcess->wDest > VertexCount - lpProcess->dwCount)
+				{
+					LOG_LIMIT(100, __FUNCTION__ << " Error: vertex range out of bounds: " << lpProcess->wStart << " " << lpProcess->wDest << " " << lpProcess->dwCount);
+					continue;
+				}
+				DWORD FVF;
+				switch (lpProcess->dwFlags & D3DPROCESSVERTICES_OPMASK)
+				{
+				case D3DPROCESSVERTICES_TRANSFORMLIGHT:
+					FVF = D3DFVF_VERTEX;
+					break;
+				case D3DPROCESSVERTICES_TRANSFORM:
+					FVF = D3DFVF_LVERTEX;
+					break;
+				default:
+					FVF = D3DFVF_TLVERTEX;
+					break;
+				}
+				std::fill(ProcessedFVF.begin() + lpProcess->wDest, ProcessedFVF.begin() + lpProcess->wDest + lpProcess->dwCount, FVF);
+				memcpy(&ProcessedVertices[lpProcess->wDest * ExecuteVertexSize], lpVertexData + lpProcess->wStart * ExecuteVertexSize, lpProcess->dwCount * ExecuteVertexSize);
+			}
+			break;
+
+		case D3DOP_TEXTURELOAD:
+			for (DWORD i = 0; i < Instruction.wCount; i++, lpData += Instruction.bSize)
+			{
+				D3DTEXTURELOAD *lpTextureLoad = (D3DTEXTURELOAD*)lpData;
+				m_IDirect3DTextureX *pDestTextureX = pDevice->GetTextureFromHandle(lpTextureLoad->hDestTexture);
+				m_IDirect3DTextureX *pSrcTextureX = pDevice->GetTextureFromHandle(lpTextureLoad->hSrcTexture);
+				if (!pDestTextureX || !pSrcTextureX)
+				{
+					LOG_LIMIT(100, __FUNCTION__ << " Error: could not find texture handle: " << lpTextureLoad->hDestTexture << " " << lpTextureLoad->hSrcTexture);
+					continue;
+				}
+				pDestTextureX->Load((LPDIRECT3DTEXTURE2)pSrcTextureX->GetWrapperInterfaceX(2));
+			}
+			break;
+
+		case D3DOP_EXIT:
+			Next = Instructions.size();
+			break;
+
+		case D3DOP_BRANCHFORWARD:
+			for (DWORD i = 0; i < Instruction.wCount; i++, lpData += Instruction.bSize)
+			{
+				D3DBRANCH *lpBranch = (D3DBRANCH*)lpData;
+				bool IsMatch = ((ExecuteData.dsStatus.dwStatus & lpBranch->dwMask) == lpBranch->dwValue);
+				if (IsMatch != (lpBranch->bNegate != FALSE))
+				{
+					// The branch offset is relative to the start of this instruction, zero exits
+					DWORD Target = Instruction.Offset + lpBranch->dwOffset;
+					auto it = std::lower_bound(Instructions.begin() + Next, Instructions.end(), Target,
+						[](const EXECUTEINSTRUCTION& Entry, DWORD Offset) -> bool { return Entry.Offset < Offset; });
+					Next = (lpBranch->dwOffset) ? (size_t)(it - Instructions.begin()) : Instructions.size();
+					break;
+				}
+			}
+			break;
+
+		case D3DOP_SPAN:
+			// Spans are horizontal runs of vertices, each vertex covers one pixel so they are drawn as points
+			for (DWORD i = 0; i < Instruction.wCount; i++, lpData += Instruction.bSize)
+			{
+				D3DSPAN *lpSpan = (D3DSPAN*)lpData;
+				if (lpSpan->wCount && lpSpan->wFirst + lpSpan->wCount <= VertexCount)
+				{
+					pDevice->DrawPrimitive(D3DPT_POINTLIST, ProcessedFVF[lpSpan->wFirst], &ProcessedVertices[lpSpan->wFirst * ExecuteVertexSize], lpSpan->wCount, DrawFlags, 1);
+				}
+			}
+			break;
+
+		case D3DOP_SETSTATUS:
+			for (DWORD i = 0; i < Instruction.wCount; i++, lpData += Instruction.bSize)
+			{
+				D3DSTATUS *lpStatus = (D3DSTATUS*)lpData;
+				if (lpStatus->dwFlags & D3DSETSTATUS_STATUS)
+				{
+					ExecuteData.dsStatus.dwStatus = lpStatus->dwStatus;
+				}
+				if (lpStatus->dwFlags & D3DSETSTATUS_EXTENTS)
+				{
+					ExecuteData.dsStatus.drExtent = lpStatus->drExtent;
+				}
+			}
+			break;
+		}
+
+		x = Next;
+	}
+
+	return D3D_OK;
 }
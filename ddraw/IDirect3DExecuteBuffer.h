@@ -10,24 +10,50 @@ private:
 	// Convert Material
 	m_IDirect3DDeviceX **D3DDeviceInterface = nullptr;
 
+	// Execute buffer data
+	struct EXECUTEINSTRUCTION
+	{
+		DWORD Offset;		// Offset of the instruction header in the buffer
+		BYTE bOpcode;
+		BYTE bSize;
+		WORD wCount;
+	};
+	D3DEXECUTEBUFFERDESC Desc = {};
+	D3DEXECUTEDATA ExecuteData = {};
+	std::vector<BYTE> MemoryData;
+	bool IsLocked = false;
+
+	// Instruction stream decoded once and reused until the buffer is locked or the execute data changes
+	std::vector<EXECUTEINSTRUCTION> Instructions;
+	bool IsDecoded = false;
+
+	// Processed vertices used by the draw instructions, all execute buffer vertex types are 32 bytes
+	static constexpr DWORD ExecuteVertexSize = sizeof(D3DTLVERTEX);
+	std::vector<BYTE> ProcessedVertices;
+	std::vector<DWORD> ProcessedFVF;		// Vertex type of each processed vertex, set by the process vertices operation that wrote it
+	std::vector<WORD> IndexCache;
+
 	// Interface initialization functions
-	void InitExecuteBuffer();
-	void ReleaseExecuteBuffer();
+	void InitExecuteBuffer(LPD3DEXECUTEBUFFERDESC lpDesc);
+
+	// Helper functions
+	HRESULT DecodeInstructions();
+	HRESULT DrawIndexed(m_IDirect3DDeviceX *pDevice, D3DPRIMITIVETYPE dptPrimitiveType, DWORD dwFlags);
 
 public:
 	m_IDirect3DExecuteBuffer(IDirect3DExecuteBuffer *aOriginal) : ProxyInterface(aOriginal)
 	{
 		LOG_LIMIT(3, "Creating interface " << __FUNCTION__ << " (" << this << ")");
 
-		InitExecuteBuffer();
+		InitExecuteBuffer(nullptr);
 
 		ProxyAddressLookupTable.SaveAddress(this, (ProxyInterface) ? ProxyInterface : (void*)this);
 	}
-	m_IDirect3DExecuteBuffer(m_IDirect3DDeviceX **D3DDInterface) : D3DDeviceInterface(D3DDInterface)
+	m_IDirect3DExecuteBuffer(m_IDirect3DDeviceX **D3DDInterface, LPD3DEXECUTEBUFFERDESC lpDesc) : D3DDeviceInterface(D3DDInterface)
 	{
 		LOG_LIMIT(3, "Creating interface " << __FUNCTION__ << " (" << this << ")");
 
-		InitExecuteBuffer();
+		InitExecuteBuffer(lpDesc);
 
 		ProxyAddressLookupTable.SaveAddress(this, (ProxyInterface) ? ProxyInterface : (void*)this);
 	}
@@ -35,8 +61,6 @@ public:
 	{
 		LOG_LIMIT(3, __FUNCTION__ << " (" << this << ")" << " deleting interface!");
 
-		ReleaseExecuteBuffer();
-
 		ProxyAddressLookupTable.DeleteAddress(this);
 	}
 
@@ -53,4 +77,7 @@ public:
 	STDMETHOD(GetExecuteData)(THIS_ LPD3DEXECUTEDATA);
 	STDMETHOD(Validate)(THIS_ LPDWORD, LPD3DVALIDATECALLBACK, LPVOID, DWORD);
 	STDMETHOD(Optimize)(THIS_ DWORD);
+
+	// Helper functions
+	HRESULT Execute(m_IDirect3DDeviceX *pDevice, DWORD dwFlags);
 };
@@ -158,6 +158,12 @@ HRESULT m_IDirect3DTextureX::GetHandle(LPDIRECT3DDEVICE2 lpDirect3DDevice2, LPD3
 
 	if (!ProxyInterface)
 	{
+		// Execute buffers reference textures by handle, the device maps them back to the texture
+		if (D3DDeviceInterface && *D3DDeviceInterface)
+		{
+			(*D3DDeviceInterface)->SetTextureHandle(tHandle, this);
+		}
+
 		if (lpHandle)
 		{
 			*lpHandle = tHandle;
@@ -208,7 +214,7 @@ HRESULT m_IDirect3DTextureX::Load(LPDIRECT3DTEXTURE2 lpD3DTexture2)
 
 	if (!ProxyInterface)
 	{
-		if (lpD3DTexture2)
+		if (!lpD3DTexture2)
 		{
 			return DDERR_INVALIDPARAMS;
 		}
@@ -307,6 +313,11 @@ void m_IDirect3DTextureX::ReleaseTexture()
 	WrapperInterface->DeleteMe();
 	WrapperInterface2->DeleteMe();
 
+	if (tHandle && D3DDeviceInterface && *D3DDeviceInterface)
+	{
+		(*D3DDeviceInterface)->ClearTextureHandle(tHandle);
+	}
+
 	if (DDrawSurface)
 	{
 		DDrawSurface->ClearTexture();
@@ -16,6 +16,12 @@
 
 #include "ddraw.h"
 
+namespace
+{
+	// Versions are unique across all buffers so that a cached source pointer that gets reused cannot match
+	LONG VersionCounter = 0;
+}
+
 HRESULT m_IDirect3DVertexBufferX::QueryInterface(REFIID riid, LPVOID FAR * ppvObj, DWORD DirectXVersion)
 {
 	Logging::LogDebug() << __FUNCTION__ << " (" << this << ") " << riid;
@@ -190,6 +196,16 @@ HRESULT m_IDirect3DVertexBufferX::Lock(DWORD dwFlags, LPVOID* lplpData, LPDWORD
 			// Should not need to copy from vertex buffer??
 			//ConvertVertices((D3DLVERTEX*)VertexData.data(), (D3DLVERTEX9*)pData, VBDesc.dwNumVertices);
 		}
+		// Handle buffers used as a ProcessVertices source
+		else if (IsProcessSource)
+		{
+			*lplpData = VertexData.data();
+
+			if (lpdwSize)
+			{
+				*lpdwSize = VertexData.size();
+			}
+		}
 		else
 		{
 			*lplpData = pData;
@@ -218,10 +234,20 @@ HRESULT m_IDirect3DVertexBufferX::Unlock()
 			return DDERR_GENERIC;
 		}
 
-		// Handle D3DFVF_LVERTEX
-		if (VBDesc.dwFVF == D3DFVF_LVERTEX && LastLockAddr && !(LastLockFlags & DDLOCK_READONLY))
+		if (LastLockAddr && !(LastLockFlags & DDLOCK_READONLY))
 		{
-			ConvertVertices((D3DLVERTEX9*)LastLockAddr, (D3DLVERTEX*)VertexData.data(), VBDesc.dwNumVertices);
+			// Handle D3DFVF_LVERTEX
+			if (VBDesc.dwFVF == D3DFVF_LVERTEX)
+			{
+				VertexConvert::LVertexToLVertex9((D3DLVERTEX9*)LastLockAddr, (D3DLVERTEX*)VertexData.data(), VBDesc.dwNumVertices);
+			}
+			// Handle buffers used as a ProcessVertices source
+			else if (IsProcessSource)
+			{
+				memcpy(LastLockAddr, VertexData.data(), VertexData.size());
+			}
+
+			UpdateVersion(false);
 		}
 
 		HRESULT hr = d3d9VertexBuffer->Unlock();
@@ -247,7 +273,7 @@ HRESULT m_IDirect3DVertexBufferX::ProcessVertices(DWORD dwVertexOp, DWORD dwDest
 	if (Config.Dd7to9)
 	{
 		// Always include the D3DVOP_TRANSFORM flag in the dwVertexOp parameter. If you do not, the method fails, returning DDERR_INVALIDPARAMS.
-		if (!lpSrcBuffer || !lpD3DDevice || !(dwFlags & D3DVOP_TRANSFORM))
+		if (!lpSrcBuffer || !lpD3DDevice || !(dwVertexOp & D3DVOP_TRANSFORM))
 		{
 			return DDERR_INVALIDPARAMS;
 		}
@@ -268,6 +294,17 @@ HRESULT m_IDirect3DVertexBufferX::ProcessVertices(DWORD dwVertexOp, DWORD dwDest
 			return DDERR_GENERIC;
 		}
 
+		if (dwSrcIndex + dwCount > pSrcVertexBufferX->GetNumVertices() || dwDestIndex + dwCount > VBDesc.dwNumVertices)
+		{
+			return DDERR_INVALIDPARAMS;
+		}
+
+		// Transform and light the vertices on the CPU, the device is only used for vertex formats and state the software pipeline does not handle
+		if (ProcessVerticesSoftware(dwVertexOp, dwDestIndex, dwCount, pSrcVertexBufferX, dwSrcIndex, lpD3DDevice, dwFlags))
+		{
+			return D3D_OK;
+		}
+
 		LPDIRECT3DVERTEXBUFFER9 d3d9SrcVertexBuffer = pSrcVertexBufferX->GetCurrentD9VertexBuffer();
 
 		if (!d3d9SrcVertexBuffer)
@@ -309,6 +346,17 @@ HRESULT m_IDirect3DVertexBufferX::ProcessVertices(DWORD dwVertexOp, DWORD dwDest
 		{
 			LOG_LIMIT(100, __FUNCTION__ << " Error: 'ProcessVertices' call failed: " << (D3DERR)hr);
 		}
+		else
+		{
+			// The system memory copy no longer matches the buffer
+			if (IsProcessSource)
+			{
+				IsProcessSource = false;
+				VertexData.clear();
+			}
+
+			UpdateVersion(false);
+		}
 
 		return hr;
 	}
@@ -500,6 +548,16 @@ HRESULT m_IDirect3DVertexBufferX::CreateD3D9VertexBuffer()
 	{
 		VertexData.resize(LVERTEX_SIZE * VBDesc.dwNumVertices);
 	}
+	else if (IsProcessSource && VertexData.size() == d3d9VBDesc.Size)
+	{
+		// Restore vertex buffer data from the system memory copy
+		void* pData = nullptr;
+		if (SUCCEEDED(d3d9VertexBuffer->Lock(0, 0, &pData, 0)))
+		{
+			memcpy(pData, VertexData.data(), VertexData.size());
+			d3d9VertexBuffer->Unlock();
+		}
+	}
 	else if (VertexData.size() == d3d9VBDesc.Size)
 	{
 		// ToDo: restore vertex buffer data
@@ -507,9 +565,132 @@ HRESULT m_IDirect3DVertexBufferX::CreateD3D9VertexBuffer()
 
 	LastLockAddr = nullptr;
 
+	UpdateVersion(false);
+
 	return D3D_OK;
 }
 
+bool m_IDirect3DVertexBufferX::ProcessVerticesSoftware(DWORD dwVertexOp, DWORD dwDestIndex, DWORD dwCount, m_IDirect3DVertexBufferX* pSrcVertexBufferX, DWORD dwSrcIndex, LPDIRECT3DDEVICE7 lpD3DDevice, DWORD dwFlags)
+{
+	const DWORD SrcFVF = pSrcVertexBufferX->GetFVF();
+
+	if (pSrcVertexBufferX == this || LastLockAddr || !VertexPipeline::IsSupported(SrcFVF, d3d9VBDesc.FVF))
+	{
+		return false;
+	}
+
+	m_IDirect3DDeviceX* pDeviceX = nullptr;
+	lpD3DDevice->QueryInterface(IID_GetInterfaceX, (LPVOID*)&pDeviceX);
+
+	VertexPipeline::STATE State;
+	if (!pDeviceX || !VertexPipeline::GetState(*d3d9Device, pDeviceX->GetLightIndexCount(), State))
+	{
+		return false;
+	}
+
+	// Check if the destination range already holds the result
+	const DWORD SourceVersion = pSrcVertexBufferX->GetVersion();
+	for (const auto& Entry : ProcessCache)
+	{
+		if (Entry.Source == pSrcVertexBufferX && Entry.SourceVersion == SourceVersion && Entry.SrcIndex == dwSrcIndex && Entry.DestIndex == dwDestIndex &&
+			Entry.Count == dwCount && Entry.VertexOp == dwVertexOp && Entry.Flags == dwFlags && memcmp(&Entry.State, &State, sizeof(State)) == 0)
+		{
+			return true;
+		}
+	}
+
+	const BYTE* pSrcData = pSrcVertexBufferX->GetSourceVertexData();
+	if (!pSrcData)
+	{
+		return false;
+	}
+
+	const DWORD SrcStride = (SrcFVF == D3DFVF_LVERTEX) ? sizeof(D3DLVERTEX) : GetVertexStride(SrcFVF);
+	const DWORD DestStride = GetVertexStride(d3d9VBDesc.FVF);
+
+	void* pData = nullptr;
+	if (FAILED(d3d9VertexBuffer->Lock(dwDestIndex * DestStride, dwCount * DestStride, &pData, 0)))
+	{
+		LOG_LIMIT(100, __FUNCTION__ << " Error: failed to lock vertex buffer!");
+		return false;
+	}
+
+	// Keep the system memory copy current if this buffer is also used as a source
+	BYTE* pDest = IsProcessSource ? VertexData.data() + dwDestIndex * DestStride : (BYTE*)pData;
+
+	VertexPipeline::ProcessVertices(pDest, d3d9VBDesc.FVF, pSrcData + dwSrcIndex * SrcStride, SrcFVF, dwCount, dwVertexOp, dwFlags, State);
+
+	if (IsProcessSource)
+	{
+		memcpy(pData, pDest, dwCount * DestStride);
+	}
+
+	d3d9VertexBuffer->Unlock();
+
+	// Writing the range replaces any cached result that overlaps it
+	UpdateVersion(true);
+	ProcessCache.erase(std::remove_if(ProcessCache.begin(), ProcessCache.end(), [&](const PROCESSCACHE& Entry) {
+		return Entry.DestIndex < dwDestIndex + dwCount && dwDestIndex < Entry.DestIndex + Entry.Count; }), ProcessCache.end());
+	if (ProcessCache.size() < MaxProcessCache)
+	{
+		ProcessCache.push_back({ pSrcVertexBufferX, SourceVersion, dwSrcIndex, dwDestIndex, dwCount, dwVertexOp, dwFlags, State });
+	}
+
+	return true;
+}
+
+const BYTE* m_IDirect3DVertexBufferX::GetSourceVertexData()
+{
+	// Handle D3DFVF_LVERTEX, the application data is already kept in system memory
+	if (VBDesc.dwFVF == D3DFVF_LVERTEX)
+	{
+		return VertexData.data();
+	}
+
+	if (IsProcessSource)
+	{
+		return VertexData.data();
+	}
+
+	if (!d3d9VertexBuffer || LastLockAddr)
+	{
+		return nullptr;
+	}
+
+	// Reading a write only buffer is undefined and very slow on most drivers, ProcessVertices uses the device for it
+	if (d3d9VBDesc.Usage & D3DUSAGE_WRITEONLY)
+	{
+		return nullptr;
+	}
+
+	// Read the buffer once, after this locks go through the system memory copy
+	void* pData = nullptr;
+	if (FAILED(d3d9VertexBuffer->Lock(0, 0, &pData, D3DLOCK_READONLY)))
+	{
+		LOG_LIMIT(100, __FUNCTION__ << " Error: failed to lock vertex buffer!");
+		return nullptr;
+	}
+
+	VertexData.resize(d3d9VBDesc.Size);
+	memcpy(VertexData.data(), pData, d3d9VBDesc.Size);
+
+	d3d9VertexBuffer->Unlock();
+
+	IsProcessSource = true;
+
+	return VertexData.data();
+}
+
+void m_IDirect3DVertexBufferX::UpdateVersion(bool KeepProcessCache)
+{
+	Version = (DWORD)InterlockedIncrement(&VersionCounter);
+
+	if (!KeepProcessCache)
+	{
+		ProcessCache.clear();
+	}
+}
+
 void m_IDirect3DVertexBufferX::ReleaseD3D9VertexBuffer()
 {
 	// Release vertex buffer
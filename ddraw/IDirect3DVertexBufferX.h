@@ -19,6 +19,27 @@ private:
 	void* LastLockAddr = nullptr;
 	DWORD LastLockFlags = 0;
 
+	// Changes whenever the buffer data changes
+	DWORD Version = 0;
+
+	// Buffers used as a ProcessVertices source keep a system memory copy in VertexData so the software pipeline can read them
+	bool IsProcessSource = false;
+
+	// Ranges written by the software pipeline, used to skip ProcessVertices calls that would write the same data
+	static constexpr DWORD MaxProcessCache = 16;
+	struct PROCESSCACHE
+	{
+		m_IDirect3DVertexBufferX* Source;
+		DWORD SourceVersion;
+		DWORD SrcIndex;
+		DWORD DestIndex;
+		DWORD Count;
+		DWORD VertexOp;
+		DWORD Flags;
+		VertexPipeline::STATE State;
+	};
+	std::vector<PROCESSCACHE> ProcessCache;
+
 	// Index buffer data
 	DWORD IndexBufferSize = 0;
 
@@ -53,6 +74,8 @@ private:
 
 	// Direct3D9 interface functions
 	HRESULT CreateD3D9VertexBuffer();
+	bool ProcessVerticesSoftware(DWORD dwVertexOp, DWORD dwDestIndex, DWORD dwCount, m_IDirect3DVertexBufferX* pSrcVertexBufferX, DWORD dwSrcIndex, LPDIRECT3DDEVICE7 lpD3DDevice, DWORD dwFlags);
+	void UpdateVersion(bool KeepProcessCache);
 	void ReleaseD3D9VertexBuffer();
 	void ReleaseD3D9IndexBuffer();
 
@@ -127,4 +150,10 @@ public:
 	void ReleaseD9Buffers(bool BackupData);
 
 	DWORD GetFVF9() { return d3d9VBDesc.FVF; };
+
+	// Software vertex pipeline source data
+	DWORD GetFVF() { return VBDesc.dwFVF; }
+	DWORD GetNumVertices() { return VBDesc.dwNumVertices; }
+	DWORD GetVersion() { return Version; }
+	const BYTE* GetSourceVertexData();
 };
@@ -28,6 +28,9 @@ bool dirtyFlag = false;
 bool SceneReady = false;
 bool IsPresentRunning = false;
 
+// Used to track primary surface writes deferred by present coalescing
+bool PresentPending = false;
+
 // Used for sharing emulated memory
 bool ShareEmulatedMemory = false;
 std::vector<EMUSURFACE*> memorySurfaces;
@@ -1279,7 +1282,7 @@ HRESULT m_IDirectDrawSurfaceX::Flip(LPDIRECTDRAWSURFACE7 lpDDSurfaceTargetOverri
 			}
 
 			// Present surface
-			EndWritePresent(false);
+			EndWritePresent(false, true);
 		}
 
 		return hr;
@@ -1667,6 +1670,10 @@ HRESULT m_IDirectDrawSurfaceX::GetDC(HDC FAR * lphDC)
 				}
 
 				*lphDC = surface.emu->DC;
+
+				// The device context stays selected into the emulated memory, so it can still be drawn to after ReleaseDC
+				RECT Rect = { 0, 0, (LONG)surfaceDesc2.dwWidth, (LONG)surfaceDesc2.dwHeight };
+				surface.EmuTiles.AddLockRect(Rect);
 			}
 			else if (surface.Texture)
 			{
@@ -2223,6 +2230,12 @@ HRESULT m_IDirectDrawSurfaceX::Lock2(LPRECT lpDestRect, LPDDSURFACEDESC2 lpDDSur
 			surface.LastLock.LockedRect.pBits = LockedRect.pBits;
 			surface.LastLock.LockedRect.Pitch = LockedRect.Pitch;
 
+			// Emulated memory can be written after unlock, remember the area so it is checked for changes
+			if (IsUsingEmulation() && !surface.LastLock.ReadOnly)
+			{
+				surface.EmuTiles.AddLockRect(DestRect);
+			}
+
 			// Restore scanlines before returing surface memory
 			if (Config.DdrawRemoveScanlines && IsPrimaryOrBackBuffer())
 			{
@@ -3382,6 +3395,13 @@ HRESULT m_IDirectDrawSurfaceX::CheckInterface(char *FunctionName, bool CheckD3DD
 	// Check surface
 	if (CheckD3DSurface)
 	{
+		// Draw batched primitives before the surface is used
+		m_IDirect3DDeviceX** lpD3DDevice = ddrawParent->GetCurrentD3DDevice();
+		if (lpD3DDevice && *lpD3DDevice)
+		{
+			(*lpD3DDevice)->FlushDrawBatch();
+		}
+
 		// Check if using Direct3D
 		bool LastIsDirect3DSurface = IsDirect3DEnabled;
 		IsDirect3DEnabled = ddrawParent->IsUsing3D();
@@ -4000,6 +4020,9 @@ void m_IDirectDrawSurfaceX::ReleaseD9Surface(bool BackupData)
 		ReleaseDCSurface();
 	}
 
+	// Reset emulated surface tracking
+	surface.EmuTiles.Reset();
+
 	// Release d3d9 3D surface
 	if (surface.Surface)
 	{
@@ -4202,7 +4225,23 @@ HRESULT m_IDirectDrawSurfaceX::Draw2DSurface()
 	{
 		if (IsUsingEmulation())
 		{
-			CopyFromEmulatedSurface(nullptr);
+			// Only upload the tiles that changed since the last upload
+			// Open device contexts, shared emulated memory and application memory can be written without a lock so the whole surface is compared
+			const bool CompareAll = IsSurfaceInDC() || ShareEmulatedMemory || (surfaceDesc2.dwFlags & DDSD_LPSURFACE);
+			for (RECT& Rect : surface.EmuTiles.GetChangedRects((BYTE*)surface.emu->pBits, surface.emu->Pitch, surfaceDesc2.dwWidth, surfaceDesc2.dwHeight, surfaceBitCount, CompareAll))
+			{
+				CopyFromEmulatedSurface(&Rect);
+			}
+
+			// Palette changes need the palette display texture converted again even when the memory did not change
+			if (surface.DisplayTexture)
+			{
+				UpdatePaletteData();
+				if (surface.IsPaletteDirty)
+				{
+					CopyEmulatedPaletteSurface(nullptr);
+				}
+			}
 		}
 		else
 		{
@@ -4671,6 +4710,9 @@ inline void m_IDirectDrawSurfaceX::ClearDirtyFlags()
 	dirtyFlag = false;
 	surface.IsDirtyFlag = false;
 
+	// Reset pending present
+	PresentPending = false;
+
 	// Reset scene ready
 	SceneReady = false;
 }
@@ -4685,8 +4727,8 @@ inline bool m_IDirectDrawSurfaceX::CheckRectforSkipScene(RECT& DestRect)
 
 inline void m_IDirectDrawSurfaceX::BeginWritePresent(bool IsSkipScene)
 {
-	// Check if data needs to be presented before write
-	if (dirtyFlag)
+	// Check if data needs to be presented before write, deferred writes are presented once the deadline is reached
+	if (dirtyFlag && (!PresentPending || ddrawParent->IsPresentDeadlineReached()))
 	{
 		if (FAILED(PresentSurface(IsSkipScene)))
 		{
@@ -4695,18 +4737,41 @@ inline void m_IDirectDrawSurfaceX::BeginWritePresent(bool IsSkipScene)
 	}
 }
 
-inline void m_IDirectDrawSurfaceX::EndWritePresent(bool IsSkipScene)
+inline void m_IDirectDrawSurfaceX::EndWritePresent(bool IsSkipScene, bool IsFlip)
 {
 	// Present surface after each draw unless removing interlacing
 	if (PresentOnUnlock || !Config.DdrawRemoveInterlacing)
 	{
-		PresentSurface(IsSkipScene);
+		// Merge writes until the refresh interval has elapsed, flips always present
+		if (Config.DdrawCoalescePresents && !PresentOnUnlock && !IsFlip && !ddrawParent->IsPresentDeadlineReached())
+		{
+			PresentPending = dirtyFlag;
+
+			// Present from the present thread if no other write arrives before the deadline
+			if (PresentPending)
+			{
+				ddrawParent->SchedulePendingPresent();
+			}
+		}
+		else
+		{
+			PresentSurface(IsSkipScene);
+		}
 	}
 
 	// Reset endscene lock
 	PresentOnUnlock = false;
 }
 
+// Present primary surface writes that were deferred by present coalescing
+void m_IDirectDrawSurfaceX::FlushPendingPresent()
+{
+	if (PresentPending && dirtyFlag && !IsPresentRunning)
+	{
+		PresentSurface(false);
+	}
+}
+
 // Update surface description and create backbuffers
 inline void m_IDirectDrawSurfaceX::InitSurfaceDesc(DWORD DirectXVersion)
 {
@@ -4904,7 +4969,7 @@ HRESULT m_IDirectDrawSurfaceX::ColorFill(RECT* pRect, D3DCOLOR dwFillColor)
 		return DDERR_INVALIDRECT;
 	}
 
-	// Use D3DXLoadSurfaceFromMemory to color fill the surface
+	// Fill real d3d9 surface
 	if (!IsUsingEmulation())
 	{
 		IDirect3DSurface9* pDestSurfaceD9 = GetD3D9Surface();
@@ -4927,6 +4992,30 @@ HRESULT m_IDirectDrawSurfaceX::ColorFill(RECT* pRect, D3DCOLOR dwFillColor)
 			return DDERR_GENERIC;
 		}
 
+		// Fill RGB surfaces without going through D3DX
+		if (PixelConvert::IsSupported(Desc.Format, D3DFMT_A8R8G8B8))
+		{
+			// Use the device to fill default pool surfaces
+			if (Desc.Pool == D3DPOOL_DEFAULT)
+			{
+				if (SUCCEEDED((*d3d9Device)->ColorFill(pDestSurfaceD9, &DestRect, PixelConvert::ConvertPixel(dwFillColor, Desc.Format, D3DFMT_A8R8G8B8))))
+				{
+					return DD_OK;
+				}
+			}
+			// Fill lockable surfaces directly
+			else
+			{
+				D3DLOCKED_RECT DestLockRect = {};
+				if (SUCCEEDED(LockD39Surface(&DestLockRect, &DestRect, 0)))
+				{
+					Blitter::ColorFill((BYTE*)DestLockRect.pBits, DestLockRect.Pitch, DestRect.right - DestRect.left, DestRect.bottom - DestRect.top, ByteCount, dwFillColor);
+					UnlockD39Surface();
+					return DD_OK;
+				}
+			}
+		}
+
 		// Handle 12-bit surface
 		if (BitCount == 12)
 		{
@@ -4950,6 +5039,7 @@ HRESULT m_IDirectDrawSurfaceX::ColorFill(RECT* pRect, D3DCOLOR dwFillColor)
 			}
 		}
 
+		// Use D3DXLoadSurfaceFromMemory to color fill the surface
 		LONG Pitch = 12;
 		RECT SrcRect = { 0, 0, (BitCount == 12) ? 8 : Pitch / (LONG)ByteCount, 3 };
 
@@ -4973,64 +5063,24 @@ HRESULT m_IDirectDrawSurfaceX::ColorFill(RECT* pRect, D3DCOLOR dwFillColor)
 		LONG FillWidth = DestRect.right - DestRect.left;
 		LONG FillHeight = DestRect.bottom - DestRect.top;
 
-		if ((DWORD)FillWidth == surfaceDesc2.dwWidth && surfaceBitCount == 8)
-		{
-			memset(DestLockRect.pBits, dwFillColor, DestLockRect.Pitch * FillHeight);
-		}
-		else if ((DWORD)FillWidth == surfaceDesc2.dwWidth && (surfaceBitCount == 16 || surfaceBitCount == 32) && (DestLockRect.Pitch * FillHeight) % 4 == 0)
-		{
-			const DWORD Color = (surfaceBitCount == 16) ? ((dwFillColor & 0xFFFF) << 16) + (dwFillColor & 0xFFFF) : dwFillColor;
-			const DWORD size = (DestLockRect.Pitch * FillHeight) / 4;
+		// Get byte count
+		DWORD ByteCount = surfaceBitCount / 8;
 
-			DWORD* DestBuffer = (DWORD*)DestLockRect.pBits;
-			for (UINT x = 0; x < size; x++)
-			{
-				DestBuffer[x] = Color;
-			}
-		}
-		else if (surfaceBitCount == 8 || (surfaceBitCount == 12 && FillWidth % 2 == 0) || surfaceBitCount == 16 || surfaceBitCount == 24 || surfaceBitCount == 32)
+		// Handle 12-bit surface
+		if (surfaceBitCount == 12 && FillWidth % 2 == 0)
 		{
-			// Set memory address
-			BYTE* SrcBuffer = (BYTE*)&dwFillColor;
-			BYTE* DestBuffer = (BYTE*)DestLockRect.pBits;
-
-			// Get byte count
-			DWORD ByteCount = surfaceBitCount / 8;
-
-			// Handle 12-bit surface
-			if (surfaceBitCount == 12)
-			{
-				ByteCount = 3;
-				dwFillColor = (dwFillColor & 0xFFF) + ((dwFillColor & 0xFFF) << 12);
-				FillWidth /= 2;
-			}
-
-			// Fill first line memory
-			for (LONG x = 0; x < FillWidth; x++)
-			{
-				for (DWORD y = 0; y < ByteCount; y++)
-				{
-					*DestBuffer = SrcBuffer[y];
-					DestBuffer++;
-				}
-			}
-
-			// Fill rest of surface rect using the first line as a template
-			SrcBuffer = (BYTE*)DestLockRect.pBits;
-			DestBuffer = (BYTE*)DestLockRect.pBits + DestLockRect.Pitch;
-			size_t size = FillWidth * ByteCount;
-			for (LONG y = 1; y < FillHeight; y++)
-			{
-				memcpy(DestBuffer, SrcBuffer, size);
-				DestBuffer += DestLockRect.Pitch;
-			}
+			ByteCount = 3;
+			dwFillColor = (dwFillColor & 0xFFF) + ((dwFillColor & 0xFFF) << 12);
+			FillWidth /= 2;
 		}
-		else
+		else if (surfaceBitCount != 8 && surfaceBitCount != 16 && surfaceBitCount != 24 && surfaceBitCount != 32)
 		{
 			LOG_LIMIT(100, __FUNCTION__ << " Error: invalid bit count: " << surfaceBitCount << " Width: " << FillWidth);
 			return DDERR_GENERIC;
 		}
 
+		Blitter::ColorFill((BYTE*)DestLockRect.pBits, DestLockRect.Pitch, FillWidth, FillHeight, ByteCount, dwFillColor);
+
 		// Blt surface directly to GDI
 		if (Config.DdrawWriteToGDI && IsPrimaryOrBackBuffer() && !IsDirect3DEnabled)
 		{
@@ -5305,18 +5355,17 @@ HRESULT m_IDirectDrawSurfaceX::CopySurface(m_IDirectDrawSurfaceX* pSourceSurface
 		}
 
 		// Check source and destination format
-		bool FormatMismatch = false;
-		const bool FormatR5G6B5toX8R8G8B8 = (SrcFormat == D3DFMT_R5G6B5 && (DestFormat == D3DFMT_A8R8G8B8 || DestFormat == D3DFMT_X8R8G8B8));
-		if (FormatR5G6B5toX8R8G8B8)
-		{
-			FormatMismatch = true;
-			LOG_LIMIT(100, __FUNCTION__ << " Warning: source and destination formats don't match! " << SrcFormat << "-->" << DestFormat);
-		}
-		else if (!(SrcFormat == DestFormat || ISDXTEX(SrcFormat) && ISDXTEX(DestFormat) ||
+		const bool FormatMatch = (SrcFormat == DestFormat || ISDXTEX(SrcFormat) && ISDXTEX(DestFormat) ||
 			((SrcFormat == D3DFMT_A1R5G5B5 || SrcFormat == D3DFMT_X1R5G5B5) && (DestFormat == D3DFMT_A1R5G5B5 || DestFormat == D3DFMT_X1R5G5B5)) ||
 			((SrcFormat == D3DFMT_A4R4G4B4 || SrcFormat == D3DFMT_X4R4G4B4) && (DestFormat == D3DFMT_A4R4G4B4 || DestFormat == D3DFMT_X4R4G4B4)) ||
 			((SrcFormat == D3DFMT_A8R8G8B8 || SrcFormat == D3DFMT_X8R8G8B8) && (DestFormat == D3DFMT_A8R8G8B8 || DestFormat == D3DFMT_X8R8G8B8)) ||
-			((SrcFormat == D3DFMT_A8B8G8R8 || SrcFormat == D3DFMT_X8B8G8R8) && (DestFormat == D3DFMT_A8B8G8R8 || DestFormat == D3DFMT_X8B8G8R8))))
+			((SrcFormat == D3DFMT_A8B8G8R8 || SrcFormat == D3DFMT_X8B8G8R8) && (DestFormat == D3DFMT_A8B8G8R8 || DestFormat == D3DFMT_X8B8G8R8)));
+		const bool FormatMismatch = !FormatMatch && PixelConvert::IsSupported(SrcFormat, DestFormat);
+		if (FormatMismatch)
+		{
+			LOG_LIMIT(100, __FUNCTION__ << " Warning: source and destination formats don't match! " << SrcFormat << "-->" << DestFormat);
+		}
+		else if (!FormatMatch)
 		{
 			LOG_LIMIT(100, __FUNCTION__ << " Error: not supported for specified source and destination formats! " << SrcFormat << "-->" << DestFormat);
 			hr = DDERR_GENERIC;
@@ -5411,100 +5460,33 @@ HRESULT m_IDirectDrawSurfaceX::CopySurface(m_IDirectDrawSurfaceX* pSourceSurface
 			break;
 		}
 
-		// Set color variables
-		DWORD ByteMask = (ByteCount == 1) ? 0x000000FF : (ByteCount == 2) ? 0x0000FFFF : (ByteCount == 3) ? 0x00FFFFFF : 0xFFFFFFFF;
+		// Format conversion without color key, stretching or mirroring left/right
+		if (!IsStretchRect && !IsColorKey && !IsMirrorLeftRight && FormatMismatch)
+		{
+			PixelConvert::ConvertRect(DestBuffer, DestPitch, DestFormat, SrcBuffer, SrcLockRect.Pitch, SrcFormat, DestRectWidth, DestRectHeight);
+			break;
+		}
+
+		// Source byte count
+		DWORD SrcByteCount = (FormatMismatch) ? GetBitCount(SrcFormat) / 8 : ByteCount;
+
+		// Set color variables, color key is in the source format
+		DWORD ByteMask = (SrcByteCount == 1) ? 0x000000FF : (SrcByteCount == 2) ? 0x0000FFFF : (SrcByteCount == 3) ? 0x00FFFFFF : 0xFFFFFFFF;
 		DWORD ColorKeyLow = ColorKey.dwColorSpaceLowValue & ByteMask;
 		DWORD ColorKeyHigh = ColorKey.dwColorSpaceHighValue & ByteMask;
 
-		// Simple copy with ColorKey and Mirroring
-		if (!IsStretchRect && !FormatMismatch)
+		// Copy with ColorKey, Mirroring and Stretching
+		if (!FormatMismatch)
 		{
-			if (ByteCount == 1)
-			{
-				BYTE* SrcBufferLoop = SrcBuffer;
-				BYTE* DestBufferLoop = DestBuffer;
-				for (LONG y = 0; y < DestRectHeight; y++)
-				{
-					for (LONG x = 0; x < DestRectWidth; x++)
-					{
-						BYTE PixelColor = SrcBufferLoop[IsMirrorLeftRight ? DestRectWidth - x : x];
-						if (!IsColorKey || PixelColor < ColorKeyLow || PixelColor > ColorKeyHigh)
-						{
-							DestBufferLoop[x] = PixelColor;
-						}
-					}
-					SrcBufferLoop += SrcLockRect.Pitch;
-					DestBufferLoop += DestPitch;
-				}
-				break;
-			}
-			else if (ByteCount == 2)
-			{
-				WORD* SrcBufferLoop = (WORD*)SrcBuffer;
-				WORD* DestBufferLoop = (WORD*)DestBuffer;
-				for (LONG y = 0; y < DestRectHeight; y++)
-				{
-					for (LONG x = 0; x < DestRectWidth; x++)
-					{
-						WORD PixelColor = SrcBufferLoop[IsMirrorLeftRight ? DestRectWidth - x : x];
-						if (!IsColorKey || PixelColor < ColorKeyLow || PixelColor > ColorKeyHigh)
-						{
-							DestBufferLoop[x] = PixelColor;
-						}
-					}
-					SrcBufferLoop = (WORD*)((BYTE*)SrcBufferLoop + SrcLockRect.Pitch);
-					DestBufferLoop = (WORD*)((BYTE*)DestBufferLoop + DestPitch);
-				}
-				break;
-			}
-			else if (ByteCount == 3)
-			{
-				TRIBYTE* SrcBufferLoop = (TRIBYTE*)SrcBuffer;
-				TRIBYTE* DestBufferLoop = (TRIBYTE*)DestBuffer;
-				for (LONG y = 0; y < DestRectHeight; y++)
-				{
-					for (LONG x = 0; x < DestRectWidth; x++)
-					{
-						LONG w = IsMirrorLeftRight ? DestRectWidth - x : x;
-						DWORD PixelColor = (*(DWORD*)(SrcBufferLoop + w)) & ByteMask;
-						if (!IsColorKey || PixelColor < ColorKeyLow || PixelColor > ColorKeyHigh)
-						{
-							DestBufferLoop[x] = SrcBufferLoop[w];
-						}
-					}
-					SrcBufferLoop = (TRIBYTE*)((BYTE*)SrcBufferLoop + SrcLockRect.Pitch);
-					DestBufferLoop = (TRIBYTE*)((BYTE*)DestBufferLoop + DestPitch);
-				}
-				break;
-			}
-			else if (ByteCount == 4)
-			{
-				DWORD* SrcBufferLoop = (DWORD*)SrcBuffer;
-				DWORD* DestBufferLoop = (DWORD*)DestBuffer;
-				for (LONG y = 0; y < DestRectHeight; y++)
-				{
-					for (LONG x = 0; x < DestRectWidth; x++)
-					{
-						DWORD PixelColor = SrcBufferLoop[IsMirrorLeftRight ? DestRectWidth - x : x];
-						if (!IsColorKey || PixelColor < ColorKeyLow || PixelColor > ColorKeyHigh)
-						{
-							DestBufferLoop[x] = PixelColor;
-						}
-					}
-					SrcBufferLoop = (DWORD*)((BYTE*)SrcBufferLoop + SrcLockRect.Pitch);
-					DestBufferLoop = (DWORD*)((BYTE*)DestBufferLoop + DestPitch);
-				}
-				break;
-			}
+			Blitter::Blt(DestBuffer, DestPitch, DestRectWidth, DestRectHeight, SrcBuffer, SrcLockRect.Pitch, SrcRectWidth, SrcRectHeight,
+				ByteCount, dwFlags & (BLT_COLORKEY | BLT_MIRRORLEFTRIGHT), ColorKeyLow, ColorKeyHigh);
+			break;
 		}
 
 		// Get ratio
 		float WidthRatio = (float)SrcRectWidth / (float)DestRectWidth;
 		float HeightRatio = (float)SrcRectHeight / (float)DestRectHeight;
 
-		// Source byte count
-		DWORD SrcByteCount = (FormatMismatch) ? GetBitCount(SrcFormat) / 8 : ByteCount;
-
 		// Copy memory (complex)
 		for (LONG y = 0; y < DestRectHeight; y++)
 		{
@@ -5517,18 +5499,11 @@ HRESULT m_IDirectDrawSurfaceX::CopySurface(m_IDirectDrawSurfaceX* pSourceSurface
 
 				if (!IsColorKey || PixelColor < ColorKeyLow || PixelColor > ColorKeyHigh)
 				{
-					if (FormatR5G6B5toX8R8G8B8)
+					DWORD NewColor = PixelConvert::ConvertPixel(PixelColor, SrcFormat, DestFormat);
+					for (DWORD i = 0; i < ByteCount; i++)
 					{
-						*(DWORD*)LoopBuffer = D3DFMT_R5G6B5_TO_X8R8G8B8(*(WORD*)NewPixel);
-						LoopBuffer += ByteCount;
-					}
-					else
-					{
-						for (DWORD i = 0; i < ByteCount; i++)
-						{
-							*LoopBuffer = NewPixel[i];
-							LoopBuffer++;
-						}
+						*LoopBuffer = ((BYTE*)&NewColor)[i];
+						LoopBuffer++;
 					}
 				}
 				else
@@ -5614,13 +5589,26 @@ HRESULT m_IDirectDrawSurfaceX::CopyFromEmulatedSurface(LPRECT lpDestRect)
 		return DDERR_GENERIC;
 	}
 
+	// Convert directly into the real surface when the emulated format differs from the real format
+	const D3DFORMAT RealFormat = ConvertSurfaceFormat(surfaceFormat);
+	D3DLOCKED_RECT LockRect = {};
+	if (RealFormat != surfaceFormat && PixelConvert::IsSupported(surfaceFormat, RealFormat) && SUCCEEDED(LockD39Surface(&LockRect, &DestRect, 0)))
+	{
+		const BYTE* EmulatedBuffer = (BYTE*)surface.emu->pBits + DestRect.top * surface.emu->Pitch + DestRect.left * (surfaceBitCount / 8);
+		PixelConvert::ConvertRect((BYTE*)LockRect.pBits, LockRect.Pitch, RealFormat, EmulatedBuffer, surface.emu->Pitch, surfaceFormat,
+			DestRect.right - DestRect.left, DestRect.bottom - DestRect.top);
+		UnlockD39Surface();
+	}
 	// Use D3DXLoadSurfaceFromMemory to copy to the surface
-	if (FAILED(D3DXLoadSurfaceFromMemory(pDestSurfaceD9, nullptr, &DestRect, surface.emu->pBits, (surfaceFormat == D3DFMT_P8) ? D3DFMT_L8 : surfaceFormat, surface.emu->Pitch, nullptr, &DestRect, D3DX_FILTER_NONE, 0)))
+	else if (FAILED(D3DXLoadSurfaceFromMemory(pDestSurfaceD9, nullptr, &DestRect, surface.emu->pBits, (surfaceFormat == D3DFMT_P8) ? D3DFMT_L8 : surfaceFormat, surface.emu->Pitch, nullptr, &DestRect, D3DX_FILTER_NONE, 0)))
 	{
 		LOG_LIMIT(100, __FUNCTION__ << " Error: could not copy emulated surface: " << surfaceFormat);
 		return DDERR_GENERIC;
 	}
 
+	// Remember uploaded data
+	surface.EmuTiles.UpdateRect((BYTE*)surface.emu->pBits, surface.emu->Pitch, DestRect);
+
 	// Update palette surface data
 	if (!surface.DisplayTexture || FAILED(CopyEmulatedPaletteSurface(&DestRect)))
 	{
@@ -5672,90 +5660,28 @@ HRESULT m_IDirectDrawSurfaceX::CopyToEmulatedSurface(LPRECT lpDestRect)
 	HRESULT hr = DD_OK;
 
 	// Copy real surface data to emulated surface
-	switch ((DWORD)surfaceFormat)
+	const D3DFORMAT RealFormat = ConvertSurfaceFormat(surfaceFormat);
+	if (RealFormat != surfaceFormat && PixelConvert::IsSupported(RealFormat, surfaceFormat))
 	{
-	case D3DFMT_X4R4G4B4:
-	case D3DFMT_A4R4G4B4:
-		for (LONG x = DestRect.top; x < DestRect.bottom; x++)
-		{
-			WORD* EmulatedBufferLoop = (WORD*)EmulatedBuffer;
-			DWORD* SurfaceBufferLoop = (DWORD*)SurfaceBuffer;
-			for (LONG y = DestRect.left; y < DestRect.right; y++)
-			{
-				*EmulatedBufferLoop = D3DFMT_A8R8G8B8_TO_A4R4G4B4(*SurfaceBufferLoop);
-				EmulatedBufferLoop++;
-				SurfaceBufferLoop++;
-			}
-			EmulatedBuffer += EmulatedLockRect.Pitch;
-			SurfaceBuffer += SrcLockRect.Pitch;
-		}
-		break;
-	case D3DFMT_R8G8B8:
-		for (LONG x = DestRect.top; x < DestRect.bottom; x++)
-		{
-			TRIBYTE* EmulatedBufferLoop = (TRIBYTE*)EmulatedBuffer;
-			DWORD* SurfaceBufferLoop = (DWORD*)SurfaceBuffer;
-			for (LONG y = DestRect.left; y < DestRect.right; y++)
-			{
-				*EmulatedBufferLoop = *(TRIBYTE*)SurfaceBufferLoop;
-				EmulatedBufferLoop++;
-				SurfaceBufferLoop++;
-			}
-			EmulatedBuffer += EmulatedLockRect.Pitch;
-			SurfaceBuffer += SrcLockRect.Pitch;
-		}
-		break;
-	case D3DFMT_B8G8R8:
-		for (LONG x = DestRect.top; x < DestRect.bottom; x++)
+		PixelConvert::ConvertRect(EmulatedBuffer, EmulatedLockRect.Pitch, surfaceFormat, SurfaceBuffer, SrcLockRect.Pitch, RealFormat, DestRect.right - DestRect.left, Height);
+	}
+	else if (SrcLockRect.Pitch == EmulatedLockRect.Pitch && (DWORD)(DestRect.right - DestRect.left) == surfaceDesc2.dwWidth)
+	{
+		memcpy(EmulatedBuffer, SurfaceBuffer, SrcLockRect.Pitch * Height);
+	}
+	else if (surface.emu->bmi->bmiHeader.biBitCount == surfaceBitCount)
+	{
+		for (UINT x = 0; x < Height; x++)
 		{
-			TRIBYTE* EmulatedBufferLoop = (TRIBYTE*)EmulatedBuffer;
-			DWORD* SurfaceBufferLoop = (DWORD*)SurfaceBuffer;
-			for (LONG y = DestRect.left; y < DestRect.right; y++)
-			{
-				DWORD Pixel = D3DFMT_X8R8G8B8_TO_B8G8R8(*SurfaceBufferLoop);
-				*EmulatedBufferLoop = *(TRIBYTE*)&Pixel;
-				EmulatedBufferLoop++;
-				SurfaceBufferLoop++;
-			}
+			memcpy(EmulatedBuffer, SurfaceBuffer, WidthPitch);
 			EmulatedBuffer += EmulatedLockRect.Pitch;
 			SurfaceBuffer += SrcLockRect.Pitch;
 		}
-		break;
-	case D3DFMT_X8B8G8R8:
-	case D3DFMT_A8B8G8R8:
-		for (LONG x = DestRect.top; x < DestRect.bottom; x++)
-		{
-			DWORD* EmulatedBufferLoop = (DWORD*)EmulatedBuffer;
-			DWORD* SurfaceBufferLoop = (DWORD*)SurfaceBuffer;
-			for (LONG y = DestRect.left; y < DestRect.right; y++)
-			{
-				*EmulatedBufferLoop = D3DFMT_A8R8G8B8_TO_A8B8G8R8(*SurfaceBufferLoop);
-				EmulatedBufferLoop++;
-				SurfaceBufferLoop++;
-			}
-			EmulatedBuffer += EmulatedLockRect.Pitch;
-			SurfaceBuffer += SrcLockRect.Pitch;
-		}
-		break;
-	default:
-		if (SrcLockRect.Pitch == EmulatedLockRect.Pitch && (DWORD)(DestRect.right - DestRect.left) == surfaceDesc2.dwWidth)
-		{
-			memcpy(EmulatedBuffer, SurfaceBuffer, SrcLockRect.Pitch * Height);
-		}
-		else if (surface.emu->bmi->bmiHeader.biBitCount == surfaceBitCount)
-		{
-			for (UINT x = 0; x < Height; x++)
-			{
-				memcpy(EmulatedBuffer, SurfaceBuffer, WidthPitch);
-				EmulatedBuffer += EmulatedLockRect.Pitch;
-				SurfaceBuffer += SrcLockRect.Pitch;
-			}
-		}
-		else
-		{
-			hr = DDERR_GENERIC;
-			LOG_LIMIT(100, __FUNCTION__ << " Error: emulated surface format not supported: " << surfaceFormat);
-		}
+	}
+	else
+	{
+		hr = DDERR_GENERIC;
+		LOG_LIMIT(100, __FUNCTION__ << " Error: emulated surface format not supported: " << surfaceFormat);
 	}
 
 	// Unlock surface
@@ -5835,8 +5761,26 @@ inline HRESULT m_IDirectDrawSurfaceX::CopyEmulatedPaletteSurface(LPRECT lpDestRe
 			}
 		}
 
+		// Rebuild palette table only when the palette changes
+		if (surface.PaletteTable.empty() || surface.PaletteTableUSN != surface.LastPaletteUSN || surface.PaletteTableEntries != surface.PaletteEntryArray)
+		{
+			surface.PaletteTable.resize(MaxPaletteSize);
+			PixelConvert::BuildPaletteTable(surface.PaletteTable.data(), surface.PaletteEntryArray, D3DFMT_X8R8G8B8);
+			surface.PaletteTableUSN = surface.LastPaletteUSN;
+			surface.PaletteTableEntries = surface.PaletteEntryArray;
+		}
+
+		// Expand palette indexes directly into the display texture
+		D3DLOCKED_RECT LockRect = {};
+		if (SUCCEEDED(surface.DisplayContext->LockRect(&LockRect, &DestRect, 0)))
+		{
+			const BYTE* EmulatedBuffer = (BYTE*)surface.emu->pBits + DestRect.top * surface.emu->Pitch + DestRect.left;
+			PixelConvert::ConvertPaletteRect((BYTE*)LockRect.pBits, LockRect.Pitch, D3DFMT_X8R8G8B8, EmulatedBuffer, surface.emu->Pitch,
+				surface.PaletteTable.data(), DestRect.right - DestRect.left, DestRect.bottom - DestRect.top);
+			surface.DisplayContext->UnlockRect();
+		}
 		// Use D3DXLoadSurfaceFromMemory to copy to the surface
-		if (FAILED(D3DXLoadSurfaceFromMemory(surface.DisplayContext, nullptr, &DestRect, surface.emu->pBits, D3DFMT_P8, surface.emu->Pitch, surface.PaletteEntryArray, &DestRect, D3DX_FILTER_NONE, 0)))
+		else if (FAILED(D3DXLoadSurfaceFromMemory(surface.DisplayContext, nullptr, &DestRect, surface.emu->pBits, D3DFMT_P8, surface.emu->Pitch, surface.PaletteEntryArray, &DestRect, D3DX_FILTER_NONE, 0)))
 		{
 			LOG_LIMIT(100, __FUNCTION__ << " Warning: could not copy palette display texture: " << surfaceFormat);
 			hr = DDERR_GENERIC;
@@ -98,8 +98,12 @@ private:
 		std::vector<byte> ByteArray;						// Memory used for coping from one surface to the same surface
 		std::vector<byte> Backup;							// Memory used for backing up the surfaceTexture
 		EMUSURFACE* emu = nullptr;							// Emulated surface using device context
+		DirtyTracker EmuTiles;								// Tracks emulated surface changes made without a lock
 		DWORD LastPaletteUSN = 0;							// The USN that was used last time the palette was updated
 		LPPALETTEENTRY PaletteEntryArray = nullptr;			// Used to store palette data address
+		std::vector<DWORD> PaletteTable;					// Palette colors expanded to the display texture format
+		LPPALETTEENTRY PaletteTableEntries = nullptr;		// Palette data address used to build the palette table
+		DWORD PaletteTableUSN = 0;							// The USN that was used to build the palette table
 		LPDIRECT3DSURFACE9 Surface = nullptr;				// Surface used for Direct3D
 		LPDIRECT3DTEXTURE9 Texture = nullptr;				// Main surface texture used for locks, Blts and Flips
 		LPDIRECT3DSURFACE9 Context = nullptr;				// Context of the main surface texture
@@ -209,7 +213,7 @@ private:
 	void SetDirtyFlag();
 	bool CheckRectforSkipScene(RECT& DestRect);
 	void BeginWritePresent(bool isSkipScene);
-	void EndWritePresent(bool isSkipScene);
+	void EndWritePresent(bool isSkipScene, bool isFlip = false);
 
 	// Surface information functions
 	inline bool IsSurfaceLocked() { return surface.IsLocked; }
@@ -379,6 +383,7 @@ public:
 	// Direct3D9 interface functions
 	void ReleaseD9Surface(bool BackupData);
 	HRESULT PresentSurface(bool isSkipScene);
+	void FlushPendingPresent();
 	void ResetSurfaceDisplay();
 
 	// Surface information functions
@@ -17,15 +17,6 @@
 #define D3DFMT_YV12   (D3DFORMAT)MAKEFOURCC('Y','V','1','2')
 #define D3DFMT_AYUV   (D3DFORMAT)MAKEFOURCC('A', 'Y', 'U', 'V')
 
-#define D3DFMT_R5G6B5_TO_X8R8G8B8(w) \
-	((((DWORD)((w>>11)&0x1f)*8)<<16)+(((DWORD)((w>>5)&0x3f)*4)<<8)+((DWORD)(w&0x1f)*8))
-#define D3DFMT_A8R8G8B8_TO_A4R4G4B4(w) \
-	(WORD)(((((w&0xFF000000)>>24)/17)<<12)+((((w&0xFF0000)>>16)/17)<<8)+((((w&0xFF00)>>8)/17)<<4)+(((w&0xFF)/17)))
-#define D3DFMT_X8R8G8B8_TO_B8G8R8(w) \
-	(((w&0xFF)<<16)+(w&0xFF00)+((w&0xFF0000)>>16))
-#define D3DFMT_A8R8G8B8_TO_A8B8G8R8(w) \
-	((w&0xFF000000)+((w&0xFF)<<16)+(w&0xFF00)+((w&0xFF0000)>>16))
-
 static constexpr D3DFORMAT FourCCTypes[] =
 {
 	(D3DFORMAT)MAKEFOURCC('N', 'V', '1', '2'),
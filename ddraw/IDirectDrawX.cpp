@@ -92,6 +92,7 @@ struct PRESENTTHREAD
 	bool UsingMultpleCores = false;
 	CRITICAL_SECTION ddpt = {};
 	HANDLE workerEvent = {};
+	HANDLE flushEvent = {};			// Set when primary surface writes are deferred by DdrawCoalescePresents
 	HANDLE workerThread = {};
 	bool EndPresentThread = false;
 };
@@ -1920,6 +1921,12 @@ HRESULT m_IDirectDrawX::WaitForVerticalBlank(DWORD dwFlags, HANDLE hEvent)
 			return DDERR_GENERIC;
 		}
 
+		// Present any deferred primary surface writes before waiting
+		if (PrimarySurface)
+		{
+			PrimarySurface->FlushPendingPresent();
+		}
+
 		if (Config.ForceVsyncMode)
 		{
 			return DD_OK;
@@ -2344,6 +2351,7 @@ void m_IDirectDrawX::InitDdraw(DWORD DirectXVersion)
 		PresentThread.EndPresentThread = false;
 		InitializeCriticalSection(&PresentThread.ddpt);
 		PresentThread.workerEvent = CreateEvent(NULL, FALSE, FALSE, NULL);
+		PresentThread.flushEvent = CreateEvent(NULL, FALSE, FALSE, NULL);
 		PresentThread.workerThread = CreateThread(NULL, 0, PresentThreadFunction, NULL, 0, NULL);
 
 		// Mouse hook
@@ -2568,6 +2576,7 @@ void m_IDirectDrawX::ReleaseDdraw()
 		WaitForSingleObject(PresentThread.workerThread, INFINITE);	// Wait for thread to finish
 		CloseHandle(PresentThread.workerThread);					// Close thread handle
 		CloseHandle(PresentThread.workerEvent);						// Close event handle
+		CloseHandle(PresentThread.flushEvent);						// Close event handle
 		DeleteCriticalSection(&PresentThread.ddpt);					// Delete critical section
 	}
 
@@ -3168,6 +3177,11 @@ inline void m_IDirectDrawX::ReleaseAllD9Buffers(bool BackupData)
 		{
 			pBuffer->ReleaseD9Buffers(BackupData);
 		}
+
+		if (pDDraw->D3DDeviceInterface)
+		{
+			pDDraw->D3DDeviceInterface->ReleaseDrawBatch();
+		}
 	}
 
 	ReleaseCriticalSection();
@@ -3574,23 +3588,90 @@ void m_IDirectDrawX::SetVsync()
 	}
 }
 
+// Get the milliseconds left until a full refresh interval has elapsed since the last present
+DWORD m_IDirectDrawX::GetTimeToPresentDeadline()
+{
+	LARGE_INTEGER ClickTime;
+	if (!Counter.FrequencyFlag || !Counter.RefreshRate || !QueryPerformanceCounter(&ClickTime))
+	{
+		return 0;
+	}
+
+	float deltaPresentMS = ((ClickTime.QuadPart - Counter.LastPresentTime.QuadPart) * 1000.0f) / Counter.Frequency.QuadPart;
+	float intervalMS = 1000.0f / Counter.RefreshRate;
+
+	return (deltaPresentMS >= intervalMS) ? 0 : (DWORD)(intervalMS - deltaPresentMS) + 1;
+}
+
+// Wake the present thread so deferred writes are presented at the deadline even if no other write arrives
+void m_IDirectDrawX::SchedulePendingPresent()
+{
+	if (PresentThread.flushEvent)
+	{
+		SetEvent(PresentThread.flushEvent);
+	}
+}
+
+// Present deferred primary surface writes once the deadline is reached, returns the time to wait before checking again
+DWORD m_IDirectDrawX::FlushPendingPresent()
+{
+	if (!PrimarySurface)
+	{
+		return INFINITE;
+	}
+
+	DWORD TimeLeft = GetTimeToPresentDeadline();
+	if (TimeLeft)
+	{
+		return TimeLeft;
+	}
+
+	// A surface that is busy is presented by its Unlock or ReleaseDC
+	PrimarySurface->FlushPendingPresent();
+
+	return INFINITE;
+}
+
 // Present Thread: Wait for the event
 DWORD WINAPI PresentThreadFunction(LPVOID)
 {
+	HANDLE Events[] = { PresentThread.workerEvent, PresentThread.flushEvent };
+	DWORD FlushTimeout = INFINITE;
+
 	while (!PresentThread.EndPresentThread)
 	{
-		WaitForSingleObject(PresentThread.workerEvent, INFINITE);
-		ResetEvent(PresentThread.workerEvent);
+		DWORD Result = WaitForMultipleObjects(2, Events, FALSE, FlushTimeout);
 		if (PresentThread.EndPresentThread)
 		{
 			break;
 		}
-		EnterCriticalSection(&PresentThread.ddpt);
-		if (d3d9Device)
+		if (Result == WAIT_OBJECT_0)
+		{
+			ResetEvent(PresentThread.workerEvent);
+			EnterCriticalSection(&PresentThread.ddpt);
+			if (d3d9Device)
+			{
+				d3d9Device->Present(nullptr, nullptr, nullptr, nullptr);
+			}
+			LeaveCriticalSection(&PresentThread.ddpt);
+			if (FlushTimeout == INFINITE)
+			{
+				continue;
+			}
+		}
+
+		// Flush event or deadline, try again shortly if another thread holds the ddraw lock
+		if (!DdrawWrapper::TryCriticalSection())
 		{
-			d3d9Device->Present(nullptr, nullptr, nullptr, nullptr);
+			FlushTimeout = 1;
+			continue;
 		}
-		LeaveCriticalSection(&PresentThread.ddpt);
+		FlushTimeout = INFINITE;
+		for (m_IDirectDrawX* pDDraw : DDrawVector)
+		{
+			FlushTimeout = min(FlushTimeout, pDDraw->FlushPendingPresent());
+		}
+		DdrawWrapper::ReleaseCriticalSection();
 	}
 	return S_OK;
 }
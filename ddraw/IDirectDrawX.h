@@ -233,5 +233,9 @@ public:
 
 	// Begin & end scene
 	void SetVsync();
+	DWORD GetTimeToPresentDeadline();
+	bool IsPresentDeadlineReached() { return GetTimeToPresentDeadline() == 0; }
+	void SchedulePendingPresent();
+	DWORD FlushPendingPresent();
 	HRESULT Present();
 };
@@ -0,0 +1,506 @@
+/**
+* Copyright (C) 2023 Elisha Riedlinger
+*
+* This software is  provided 'as-is', without any express  or implied  warranty. In no event will the
+* authors be held liable for any damages arising from the use of this software.
+* Permission  is granted  to anyone  to use  this software  for  any  purpose,  including  commercial
+* applications, and to alter it and redistribute it freely, subject to the following restrictions:
+*
+*   1. The origin of this software must not be misrepresented; you must not claim that you  wrote the
+*      original  software. If you use this  software  in a product, an  acknowledgment in the product
+*      documentation would be appreciated but is not required.
+*   2. Altered source versions must  be plainly  marked as such, and  must not be  misrepresented  as
+*      being the original software.
+*   3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include <emmintrin.h>
+#include "ddraw.h"
+
+namespace
+{
+	// Bit layout of each supported format, byte count comes from GetBitCount()
+	struct FORMATINFO
+	{
+		D3DFORMAT Format;
+		BYTE ABits, AShift;
+		BYTE RBits, RShift;
+		BYTE GBits, GShift;
+		BYTE BBits, BShift;
+	};
+
+	constexpr FORMATINFO FormatTable[] =
+	{
+		{ D3DFMT_R3G3B2,	0, 0,	3, 5,	3, 2,	2, 0 },
+		{ D3DFMT_A8R3G3B2,	8, 8,	3, 5,	3, 2,	2, 0 },
+		{ D3DFMT_R5G6B5,	0, 0,	5, 11,	6, 5,	5, 0 },
+		{ D3DFMT_X1R5G5B5,	0, 0,	5, 10,	5, 5,	5, 0 },
+		{ D3DFMT_A1R5G5B5,	1, 15,	5, 10,	5, 5,	5, 0 },
+		{ D3DFMT_X4R4G4B4,	0, 0,	4, 8,	4, 4,	4, 0 },
+		{ D3DFMT_A4R4G4B4,	4, 12,	4, 8,	4, 4,	4, 0 },
+		{ D3DFMT_R8G8B8,	0, 0,	8, 16,	8, 8,	8, 0 },
+		{ D3DFMT_B8G8R8,	0, 0,	8, 0,	8, 8,	8, 16 },
+		{ D3DFMT_X8R8G8B8,	0, 0,	8, 16,	8, 8,	8, 0 },
+		{ D3DFMT_A8R8G8B8,	8, 24,	8, 16,	8, 8,	8, 0 },
+		{ D3DFMT_X8B8G8R8,	0, 0,	8, 0,	8, 8,	8, 16 },
+		{ D3DFMT_A8B8G8R8,	8, 24,	8, 0,	8, 8,	8, 16 },
+	};
+
+	const FORMATINFO* GetFormatInfo(D3DFORMAT Format)
+	{
+		for (const FORMATINFO& Info : FormatTable)
+		{
+			if (Info.Format == Format)
+			{
+				return &Info;
+			}
+		}
+		return nullptr;
+	}
+
+	// Expands an n-bit channel to 8 bits by repeating its bits, so that the max value maps to 0xFF
+	struct EXPANDTABLE
+	{
+		BYTE Value[9][256];
+
+		EXPANDTABLE()
+		{
+			for (DWORD Bits = 1; Bits <= 8; Bits++)
+			{
+				for (DWORD x = 0; x < (1u << Bits); x++)
+				{
+					DWORD v = x << (8 - Bits);
+					for (DWORD s = Bits; s < 8; s *= 2)
+					{
+						v |= v >> s;
+					}
+					Value[Bits][x] = (BYTE)v;
+				}
+			}
+		}
+	};
+
+	const EXPANDTABLE ExpandTable;
+
+	__forceinline DWORD ReadPixel(const BYTE* pSrc, DWORD ByteCount)
+	{
+		switch (ByteCount)
+		{
+		case 1:
+			return *pSrc;
+		case 2:
+			return *(WORD*)pSrc;
+		case 3:
+			return pSrc[0] + (pSrc[1] << 8) + (pSrc[2] << 16);
+		default:
+			return *(DWORD*)pSrc;
+		}
+	}
+
+	__forceinline void WritePixel(BYTE* pDest, DWORD ByteCount, DWORD Pixel)
+	{
+		switch (ByteCount)
+		{
+		case 1:
+			*pDest = (BYTE)Pixel;
+			break;
+		case 2:
+			*(WORD*)pDest = (WORD)Pixel;
+			break;
+		case 3:
+			pDest[0] = (BYTE)Pixel;
+			pDest[1] = (BYTE)(Pixel >> 8);
+			pDest[2] = (BYTE)(Pixel >> 16);
+			break;
+		default:
+			*(DWORD*)pDest = Pixel;
+			break;
+		}
+	}
+
+	__forceinline DWORD GetChannel(DWORD Pixel, BYTE Bits, BYTE Shift)
+	{
+		return ExpandTable.Value[Bits][(Pixel >> Shift) & ((1u << Bits) - 1)];
+	}
+
+	// Unpacks to A8R8G8B8, formats without alpha are opaque
+	__forceinline DWORD UnpackPixel(DWORD Pixel, const FORMATINFO& Info)
+	{
+		return ((Info.ABits) ? GetChannel(Pixel, Info.ABits, Info.AShift) << 24 : 0xFF000000) |
+			(GetChannel(Pixel, Info.RBits, Info.RShift) << 16) |
+			(GetChannel(Pixel, Info.GBits, Info.GShift) << 8) |
+			GetChannel(Pixel, Info.BBits, Info.BShift);
+	}
+
+	// Packs from A8R8G8B8, unused bits are set to zero
+	__forceinline DWORD PackPixel(DWORD Pixel, const FORMATINFO& Info)
+	{
+		return ((Info.ABits) ? ((Pixel >> 24) >> (8 - Info.ABits)) << Info.AShift : 0) |
+			((((Pixel >> 16) & 0xFF) >> (8 - Info.RBits)) << Info.RShift) |
+			((((Pixel >> 8) & 0xFF) >> (8 - Info.GBits)) << Info.GShift) |
+			(((Pixel & 0xFF) >> (8 - Info.BBits)) << Info.BShift);
+	}
+
+	bool IsSameLayout(const FORMATINFO& Src, const FORMATINFO& Dest)
+	{
+		return Src.RBits == Dest.RBits && Src.RShift == Dest.RShift &&
+			Src.GBits == Dest.GBits && Src.GShift == Dest.GShift &&
+			Src.BBits == Dest.BBits && Src.BShift == Dest.BShift;
+	}
+
+	bool IsSwappedLayout(const FORMATINFO& Src, const FORMATINFO& Dest)
+	{
+		return Src.RBits == 8 && Src.GBits == 8 && Src.BBits == 8 &&
+			Dest.RBits == 8 && Dest.GBits == 8 && Dest.BBits == 8 &&
+			Src.RShift == Dest.BShift && Src.GShift == Dest.GShift && Src.BShift == Dest.RShift;
+	}
+
+	enum class CONVERTTYPE { Copy, Copy24to32, Copy32to24, Swap32, Swap24to32, Swap32to24, R5G6B5toX8R8G8B8, X8R8G8B8toR5G6B5, Generic };
+
+	// Any format to any format through A8R8G8B8
+	void ConvertRowGeneric(BYTE* pDest, const BYTE* pSrc, LONG Width, const FORMATINFO& Src, DWORD SrcByteCount, const FORMATINFO& Dest, DWORD DestByteCount)
+	{
+		for (LONG x = 0; x < Width; x++)
+		{
+			WritePixel(pDest, DestByteCount, PackPixel(UnpackPixel(ReadPixel(pSrc, SrcByteCount), Src), Dest));
+			pSrc += SrcByteCount;
+			pDest += DestByteCount;
+		}
+	}
+
+	// Same channel layout and size, only alpha differs
+	void ConvertRowCopy(BYTE* pDest, const BYTE* pSrc, LONG Width, DWORD ByteCount, DWORD AlphaMask)
+	{
+		if (!AlphaMask)
+		{
+			memcpy(pDest, pSrc, Width * ByteCount);
+			return;
+		}
+
+		if (ByteCount == 4)
+		{
+			LONG x = 0;
+			const __m128i Alpha = _mm_set1_epi32((int)AlphaMask);
+			for (; x + 4 <= Width; x += 4)
+			{
+				__m128i v = _mm_loadu_si128((const __m128i*)(pSrc + x * 4));
+				_mm_storeu_si128((__m128i*)(pDest + x * 4), _mm_or_si128(v, Alpha));
+			}
+			for (; x < Width; x++)
+			{
+				((DWORD*)pDest)[x] = ((const DWORD*)pSrc)[x] | AlphaMask;
+			}
+			return;
+		}
+
+		for (LONG x = 0; x < Width; x++)
+		{
+			WritePixel(pDest, ByteCount, ReadPixel(pSrc, ByteCount) | AlphaMask);
+			pSrc += ByteCount;
+			pDest += ByteCount;
+		}
+	}
+
+	__forceinline DWORD SwapRB(DWORD Pixel)
+	{
+		return (Pixel & 0xFF00FF00) | ((Pixel >> 16) & 0xFF) | ((Pixel & 0xFF) << 16);
+	}
+
+	// 24-bit to 32-bit and 32-bit to 24-bit, optionally swapping the red and blue channels
+	template <bool IsSwapRB>
+	void ConvertRow24to32(BYTE* pDest, const BYTE* pSrc, LONG Width, DWORD AlphaMask)
+	{
+		LONG x = 0;
+		// Read 4 bytes at a time, the last pixel is read separately to stay inside the row
+		for (; x + 1 < Width; x++)
+		{
+			DWORD Pixel = *(const DWORD*)(pSrc + x * 3) & 0x00FFFFFF;
+			((DWORD*)pDest)[x] = ((IsSwapRB) ? SwapRB(Pixel) : Pixel) | AlphaMask;
+		}
+		for (; x < Width; x++)
+		{
+			DWORD Pixel = ReadPixel(pSrc + x * 3, 3);
+			((DWORD*)pDest)[x] = ((IsSwapRB) ? SwapRB(Pixel) : Pixel) | AlphaMask;
+		}
+	}
+
+	template <bool IsSwapRB>
+	void ConvertRow32to24(BYTE* pDest, const BYTE* pSrc, LONG Width)
+	{
+		for (LONG x = 0; x < Width; x++)
+		{
+			if constexpr (IsSwapRB)
+			{
+				DWORD Pixel = SwapRB(((const DWORD*)pSrc)[x]);
+				*(TRIBYTE*)(pDest + x * 3) = *(TRIBYTE*)&Pixel;
+			}
+			else
+			{
+				*(TRIBYTE*)(pDest + x * 3) = *(const TRIBYTE*)(pSrc + x * 4);
+			}
+		}
+	}
+
+	// Swaps the red and blue channels of 32-bit pixels
+	void ConvertRowSwapRB32(BYTE* pDest, const BYTE* pSrc, LONG Width, DWORD AlphaMask)
+	{
+		LONG x = 0;
+		const __m128i MaskAG = _mm_set1_epi32((int)0xFF00FF00);
+		const __m128i MaskB = _mm_set1_epi32(0x000000FF);
+		const __m128i Alpha = _mm_set1_epi32((int)AlphaMask);
+		for (; x + 4 <= Width; x += 4)
+		{
+			__m128i v = _mm_loadu_si128((const __m128i*)(pSrc + x * 4));
+			__m128i AG = _mm_and_si128(v, MaskAG);
+			__m128i R = _mm_and_si128(_mm_srli_epi32(v, 16), MaskB);
+			__m128i B = _mm_slli_epi32(_mm_and_si128(v, MaskB), 16);
+			_mm_storeu_si128((__m128i*)(pDest + x * 4), _mm_or_si128(_mm_or_si128(AG, Alpha), _mm_or_si128(R, B)));
+		}
+		for (; x < Width; x++)
+		{
+			((DWORD*)pDest)[x] = SwapRB(((const DWORD*)pSrc)[x]) | AlphaMask;
+		}
+	}
+
+	void ConvertRowR5G6B5toX8R8G8B8(BYTE* pDest, const BYTE* pSrc, LONG Width, DWORD AlphaMask)
+	{
+		LONG x = 0;
+		const __m128i Mask5 = _mm_set1_epi16(0x1F);
+		const __m128i Mask6 = _mm_set1_epi16(0x3F);
+		const __m128i Alpha = _mm_set1_epi16((short)(AlphaMask >> 16));
+		for (; x + 8 <= Width; x += 8)
+		{
+			__m128i v = _mm_loadu_si128((const __m128i*)(pSrc + x * 2));
+			__m128i R = _mm_srli_epi16(v, 11);
+			__m128i G = _mm_and_si128(_mm_srli_epi16(v, 5), Mask6);
+			__m128i B = _mm_and_si128(v, Mask5);
+			R = _mm_or_si128(_mm_slli_epi16(R, 3), _mm_srli_epi16(R, 2));
+			G = _mm_or_si128(_mm_slli_epi16(G, 2), _mm_srli_epi16(G, 4));
+			B = _mm_or_si128(_mm_slli_epi16(B, 3), _mm_srli_epi16(B, 2));
+			__m128i GB = _mm_or_si128(_mm_slli_epi16(G, 8), B);
+			__m128i AR = _mm_or_si128(Alpha, R);
+			_mm_storeu_si128((__m128i*)(pDest + x * 4), _mm_unpacklo_epi16(GB, AR));
+			_mm_storeu_si128((__m128i*)(pDest + x * 4 + 16), _mm_unpackhi_epi16(GB, AR));
+		}
+		static const FORMATINFO& Src = *GetFormatInfo(D3DFMT_R5G6B5);
+		for (; x < Width; x++)
+		{
+			((DWORD*)pDest)[x] = (UnpackPixel(((const WORD*)pSrc)[x], Src) & 0x00FFFFFF) | AlphaMask;
+		}
+	}
+
+	void ConvertRowX8R8G8B8toR5G6B5(BYTE* pDest, const BYTE* pSrc, LONG Width)
+	{
+		LONG x = 0;
+		const __m128i MaskR = _mm_set1_epi32(0xF800);
+		const __m128i MaskG = _mm_set1_epi32(0x07E0);
+		const __m128i MaskB = _mm_set1_epi32(0x001F);
+		for (; x + 8 <= Width; x += 8)
+		{
+			__m128i v[2];
+			for (int i = 0; i < 2; i++)
+			{
+				__m128i p = _mm_loadu_si128((const __m128i*)(pSrc + x * 4 + i * 16));
+				v[i] = _mm_or_si128(_mm_or_si128(
+					_mm_and_si128(_mm_srli_epi32(p, 8), MaskR),
+					_mm_and_si128(_mm_srli_epi32(p, 5), MaskG)),
+					_mm_and_si128(_mm_srli_epi32(p, 3), MaskB));
+				// Sign extend so that the signed pack keeps all 16 bits
+				v[i] = _mm_srai_epi32(_mm_slli_epi32(v[i], 16), 16);
+			}
+			_mm_storeu_si128((__m128i*)(pDest + x * 2), _mm_packs_epi32(v[0], v[1]));
+		}
+		for (; x < Width; x++)
+		{
+			DWORD Pixel = ((const DWORD*)pSrc)[x];
+			((WORD*)pDest)[x] = (WORD)(((Pixel >> 8) & 0xF800) | ((Pixel >> 5) & 0x07E0) | ((Pixel >> 3) & 0x001F));
+		}
+	}
+
+	// Palette index to 32-bit color, four indexes are read at a time
+	void ConvertRowPalette32(BYTE* pDest, const BYTE* pSrc, LONG Width, const DWORD* pTable)
+	{
+		DWORD* pDest32 = (DWORD*)pDest;
+		LONG x = 0;
+		for (; x + 4 <= Width; x += 4)
+		{
+			const DWORD Index = *(DWORD*)(pSrc + x);
+			pDest32[x] = pTable[Index & 0xFF];
+			pDest32[x + 1] = pTable[(Index >> 8) & 0xFF];
+			pDest32[x + 2] = pTable[(Index >> 16) & 0xFF];
+			pDest32[x + 3] = pTable[Index >> 24];
+		}
+		for (; x < Width; x++)
+		{
+			pDest32[x] = pTable[pSrc[x]];
+		}
+	}
+
+	// Palette index to 16-bit color, four indexes are read at a time
+	void ConvertRowPalette16(BYTE* pDest, const BYTE* pSrc, LONG Width, const DWORD* pTable)
+	{
+		WORD* pDest16 = (WORD*)pDest;
+		LONG x = 0;
+		for (; x + 4 <= Width; x += 4)
+		{
+			const DWORD Index = *(DWORD*)(pSrc + x);
+			*(DWORD*)(pDest16 + x) = pTable[Index & 0xFF] | (pTable[(Index >> 8) & 0xFF] << 16);
+			*(DWORD*)(pDest16 + x + 2) = pTable[(Index >> 16) & 0xFF] | (pTable[Index >> 24] << 16);
+		}
+		for (; x < Width; x++)
+		{
+			pDest16[x] = (WORD)pTable[pSrc[x]];
+		}
+	}
+}
+
+bool PixelConvert::IsSupported(D3DFORMAT SrcFormat, D3DFORMAT DestFormat)
+{
+	return GetFormatInfo(SrcFormat) && GetFormatInfo(DestFormat);
+}
+
+bool PixelConvert::ConvertRect(BYTE* pDest, INT DestPitch, D3DFORMAT DestFormat,
+	const BYTE* pSrc, INT SrcPitch, D3DFORMAT SrcFormat, LONG Width, LONG Height)
+{
+	const FORMATINFO* pSrcInfo = GetFormatInfo(SrcFormat);
+	const FORMATINFO* pDestInfo = GetFormatInfo(DestFormat);
+
+	if (!pSrcInfo || !pDestInfo || !pDest || !pSrc || Width <= 0 || Height <= 0)
+	{
+		return false;
+	}
+
+	const FORMATINFO& Src = *pSrcInfo;
+	const FORMATINFO& Dest = *pDestInfo;
+	const DWORD SrcByteCount = GetBitCount(SrcFormat) / 8;
+	const DWORD DestByteCount = GetBitCount(DestFormat) / 8;
+
+	// Set alpha when converting from a format without alpha
+	const DWORD AlphaMask = (!Src.ABits && Dest.ABits) ? ((1u << Dest.ABits) - 1) << Dest.AShift : 0;
+	const bool SameAlpha = (!Src.ABits || !Dest.ABits || (Src.ABits == Dest.ABits && Src.AShift == Dest.AShift));
+
+	// Pick a row converter, the special cases cover the conversions used for emulated surfaces
+	CONVERTTYPE ConvertType = CONVERTTYPE::Generic;
+	if (SameAlpha && IsSameLayout(Src, Dest))
+	{
+		ConvertType = (SrcByteCount == DestByteCount) ? CONVERTTYPE::Copy :
+			(SrcByteCount == 3 && DestByteCount == 4) ? CONVERTTYPE::Copy24to32 :
+			(SrcByteCount == 4 && DestByteCount == 3) ? CONVERTTYPE::Copy32to24 : CONVERTTYPE::Generic;
+	}
+	else if (SameAlpha && IsSwappedLayout(Src, Dest))
+	{
+		ConvertType = (SrcByteCount == 4 && DestByteCount == 4) ? CONVERTTYPE::Swap32 :
+			(SrcByteCount == 3 && DestByteCount == 4) ? CONVERTTYPE::Swap24to32 :
+			(SrcByteCount == 4 && DestByteCount == 3) ? CONVERTTYPE::Swap32to24 : CONVERTTYPE::Generic;
+	}
+	else if (SrcFormat == D3DFMT_R5G6B5 && (DestFormat == D3DFMT_X8R8G8B8 || DestFormat == D3DFMT_A8R8G8B8))
+	{
+		ConvertType = CONVERTTYPE::R5G6B5toX8R8G8B8;
+	}
+	else if ((SrcFormat == D3DFMT_X8R8G8B8 || SrcFormat == D3DFMT_A8R8G8B8) && DestFormat == D3DFMT_R5G6B5)
+	{
+		ConvertType = CONVERTTYPE::X8R8G8B8toR5G6B5;
+	}
+
+	for (LONG y = 0; y < Height; y++)
+	{
+		switch (ConvertType)
+		{
+		case CONVERTTYPE::Copy:
+			ConvertRowCopy(pDest, pSrc, Width, DestByteCount, AlphaMask);
+			break;
+		case CONVERTTYPE::Copy24to32:
+			ConvertRow24to32<false>(pDest, pSrc, Width, AlphaMask);
+			break;
+		case CONVERTTYPE::Copy32to24:
+			ConvertRow32to24<false>(pDest, pSrc, Width);
+			break;
+		case CONVERTTYPE::Swap32:
+			ConvertRowSwapRB32(pDest, pSrc, Width, AlphaMask);
+			break;
+		case CONVERTTYPE::Swap24to32:
+			ConvertRow24to32<true>(pDest, pSrc, Width, AlphaMask);
+			break;
+		case CONVERTTYPE::Swap32to24:
+			ConvertRow32to24<true>(pDest, pSrc, Width);
+			break;
+		case CONVERTTYPE::R5G6B5toX8R8G8B8:
+			ConvertRowR5G6B5toX8R8G8B8(pDest, pSrc, Width, AlphaMask);
+			break;
+		case CONVERTTYPE::X8R8G8B8toR5G6B5:
+			ConvertRowX8R8G8B8toR5G6B5(pDest, pSrc, Width);
+			break;
+		default:
+			ConvertRowGeneric(pDest, pSrc, Width, Src, SrcByteCount, Dest, DestByteCount);
+			break;
+		}
+		pSrc += SrcPitch;
+		pDest += DestPitch;
+	}
+
+	return true;
+}
+
+DWORD PixelConvert::ConvertPixel(DWORD Pixel, D3DFORMAT SrcFormat, D3DFORMAT DestFormat)
+{
+	const FORMATINFO* pSrcInfo = GetFormatInfo(SrcFormat);
+	const FORMATINFO* pDestInfo = GetFormatInfo(DestFormat);
+
+	if (!pSrcInfo || !pDestInfo)
+	{
+		return Pixel;
+	}
+
+	return PackPixel(UnpackPixel(Pixel, *pSrcInfo), *pDestInfo);
+}
+
+bool PixelConvert::BuildPaletteTable(DWORD* pTable, const PALETTEENTRY* pEntries, D3DFORMAT DestFormat)
+{
+	const FORMATINFO* pDestInfo = GetFormatInfo(DestFormat);
+
+	if (!pDestInfo || !pTable || !pEntries)
+	{
+		return false;
+	}
+
+	for (DWORD x = 0; x < 256; x++)
+	{
+		pTable[x] = PackPixel(D3DCOLOR_ARGB(pEntries[x].peFlags, pEntries[x].peRed, pEntries[x].peGreen, pEntries[x].peBlue), *pDestInfo);
+	}
+
+	return true;
+}
+
+bool PixelConvert::ConvertPaletteRect(BYTE* pDest, INT DestPitch, D3DFORMAT DestFormat,
+	const BYTE* pSrc, INT SrcPitch, const DWORD* pTable, LONG Width, LONG Height)
+{
+	if (!GetFormatInfo(DestFormat) || !pDest || !pSrc || !pTable || Width <= 0 || Height <= 0)
+	{
+		return false;
+	}
+
+	const DWORD DestByteCount = GetBitCount(DestFormat) / 8;
+
+	for (LONG y = 0; y < Height; y++)
+	{
+		switch (DestByteCount)
+		{
+		case 4:
+			ConvertRowPalette32(pDest, pSrc, Width, pTable);
+			break;
+		case 2:
+			ConvertRowPalette16(pDest, pSrc, Width, pTable);
+			break;
+		default:
+			for (LONG x = 0; x < Width; x++)
+			{
+				WritePixel(pDest + x * DestByteCount, DestByteCount, pTable[pSrc[x]]);
+			}
+			break;
+		}
+		pSrc += SrcPitch;
+		pDest += DestPitch;
+	}
+
+	return true;
+}
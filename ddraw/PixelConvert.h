@@ -0,0 +1,24 @@
+#pragma once
+
+#include <ddraw.h>
+
+namespace PixelConvert
+{
+	// Returns true if pixels can be converted between the two formats
+	// Supports the 8, 16, 24 and 32-bit RGB formats used by ddraw surfaces, with and without alpha
+	bool IsSupported(D3DFORMAT SrcFormat, D3DFORMAT DestFormat);
+
+	// Converts a rect of pixels, the destination pitch can be negative to mirror up/down
+	bool ConvertRect(BYTE* pDest, INT DestPitch, D3DFORMAT DestFormat,
+		const BYTE* pSrc, INT SrcPitch, D3DFORMAT SrcFormat, LONG Width, LONG Height);
+
+	// Converts a single pixel, used by the per-pixel copy paths
+	DWORD ConvertPixel(DWORD Pixel, D3DFORMAT SrcFormat, D3DFORMAT DestFormat);
+
+	// Builds a 256-entry table of palette colors packed in the destination format, alpha comes from peFlags
+	bool BuildPaletteTable(DWORD* pTable, const PALETTEENTRY* pEntries, D3DFORMAT DestFormat);
+
+	// Expands a rect of 8-bit palette indexes using a table from BuildPaletteTable
+	bool ConvertPaletteRect(BYTE* pDest, INT DestPitch, D3DFORMAT DestFormat,
+		const BYTE* pSrc, INT SrcPitch, const DWORD* pTable, LONG Width, LONG Height);
+}
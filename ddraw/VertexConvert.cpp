@@ -0,0 +1,102 @@
+/**
+* Copyright (C) 2023 Elisha Riedlinger
+*
+* This software is  provided 'as-is', without any express  or implied  warranty. In no event will the
+* authors be held liable for any damages arising from the use of this software.
+* Permission  is granted  to anyone  to use  this software  for  any  purpose,  including  commercial
+* applications, and to alter it and redistribute it freely, subject to the following restrictions:
+*
+*   1. The origin of this software must not be misrepresented; you must not claim that you  wrote the
+*      original  software. If you use this  software  in a product, an  acknowledgment in the product
+*      documentation would be appreciated but is not required.
+*   2. Altered source versions must  be plainly  marked as such, and  must not be  misrepresented  as
+*      being the original software.
+*   3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include <emmintrin.h>
+#include "ddraw.h"
+
+namespace
+{
+	// Copies a vertex while scaling x and y, the rest of the position and the vertex data are copied unchanged
+	template <DWORD Stride>
+	void ScaleVertex(BYTE* pDest, const BYTE* pSrc, DWORD VertexStride, __m128 Scale, __m128 Pad, __m128 Mask)
+	{
+		const __m128 Pos = _mm_loadu_ps((const float*)pSrc);
+		const __m128 Scaled = _mm_add_ps(_mm_mul_ps(Pos, Scale), Pad);
+		_mm_storeu_ps((float*)pDest, _mm_or_ps(_mm_and_ps(Mask, Scaled), _mm_andnot_ps(Mask, Pos)));
+
+		if constexpr (Stride == 32)
+		{
+			_mm_storeu_si128((__m128i*)(pDest + 16), _mm_loadu_si128((const __m128i*)(pSrc + 16)));
+		}
+		else
+		{
+			memcpy(pDest + 16, pSrc + 16, VertexStride - 16);
+		}
+	}
+
+	template <DWORD Stride>
+	void ScaleVertices(BYTE* pDest, const BYTE* pSrc, DWORD VertexStride, DWORD Count, __m128 Scale, __m128 Pad, __m128 Mask)
+	{
+		for (DWORD x = 0; x < Count; x++)
+		{
+			ScaleVertex<Stride>(pDest, pSrc, VertexStride, Scale, Pad, Mask);
+			pDest += VertexStride;
+			pSrc += VertexStride;
+		}
+	}
+}
+
+void VertexConvert::LVertexToLVertex9(D3DLVERTEX9* pDest, const D3DLVERTEX* pSrc, DWORD Count)
+{
+	static_assert(sizeof(D3DLVERTEX) == 32 && sizeof(D3DLVERTEX9) == 28, "Unexpected vertex size");
+
+	if (!pDest || !pSrc || !Count)
+	{
+		return;
+	}
+
+	// Each store writes 4 bytes into the next vertex which is then overwritten, so the last vertex is copied separately
+	// Colors are only moved between registers so their bits are kept unchanged
+	DWORD x = 0;
+	for (; x + 1 < Count; x++)
+	{
+		const __m128 v0 = _mm_loadu_ps((const float*)&pSrc[x]);			// x, y, z, reserved
+		const __m128 v1 = _mm_loadu_ps((const float*)&pSrc[x] + 4);		// color, specular, tu, tv
+		const __m128 t = _mm_shuffle_ps(v0, v1, _MM_SHUFFLE(0, 0, 2, 2));	// z, z, color, color
+		_mm_storeu_ps((float*)&pDest[x], _mm_shuffle_ps(v0, t, _MM_SHUFFLE(2, 0, 1, 0)));
+		_mm_storeu_ps((float*)&pDest[x] + 4, _mm_shuffle_ps(v1, v1, _MM_SHUFFLE(3, 3, 2, 1)));
+	}
+
+	pDest[x].x = pSrc[x].x;
+	pDest[x].y = pSrc[x].y;
+	pDest[x].z = pSrc[x].z;
+	pDest[x].diffuse = pSrc[x].color;
+	pDest[x].specular = pSrc[x].specular;
+	pDest[x].tu = pSrc[x].tu;
+	pDest[x].tv = pSrc[x].tv;
+}
+
+void VertexConvert::ScaleXYZRHW(BYTE* pDest, const BYTE* pSrc, DWORD Stride, DWORD Count, float ScaleX, float ScaleY, float PadX, float PadY)
+{
+	if (!pDest || !pSrc || Stride < 16 || !Count)
+	{
+		return;
+	}
+
+	const __m128 Scale = _mm_setr_ps(ScaleX, ScaleY, 1.0f, 1.0f);
+	const __m128 Pad = _mm_setr_ps(PadX, PadY, 0.0f, 0.0f);
+	const __m128 Mask = _mm_castsi128_ps(_mm_setr_epi32(-1, -1, 0, 0));
+
+	switch (Stride)
+	{
+	case sizeof(D3DTLVERTEX):
+		ScaleVertices<sizeof(D3DTLVERTEX)>(pDest, pSrc, Stride, Count, Scale, Pad, Mask);
+		break;
+	default:
+		ScaleVertices<0>(pDest, pSrc, Stride, Count, Scale, Pad, Mask);
+		break;
+	}
+}
@@ -0,0 +1,12 @@
+#pragma once
+
+#include <ddraw.h>
+
+namespace VertexConvert
+{
+	// Converts D3DLVERTEX to D3DLVERTEX9 by dropping the reserved field
+	void LVertexToLVertex9(D3DLVERTEX9* pDest, const D3DLVERTEX* pSrc, DWORD Count);
+
+	// Copies transformed vertices while scaling their screen x and y, the position must be the first member of the vertex
+	void ScaleXYZRHW(BYTE* pDest, const BYTE* pSrc, DWORD Stride, DWORD Count, float ScaleX, float ScaleY, float PadX, float PadY);
+}
@@ -0,0 +1,471 @@
+/**
+* Copyright (C) 2023 Elisha Riedlinger
+*
+* This software is  provided 'as-is', without any express  or implied  warranty. In no event will the
+* authors be held liable for any damages arising from the use of this software.
+* Permission  is granted  to anyone  to use  this software  for  any  purpose,  including  commercial
+* applications, and to alter it and redistribute it freely, subject to the following restrictions:
+*
+*   1. The origin of this software must not be misrepresented; you must not claim that you  wrote the
+*      original  software. If you use this  software  in a product, an  acknowledgment in the product
+*      documentation would be appreciated but is not required.
+*   2. Altered source versions must  be plainly  marked as such, and  must not be  misrepresented  as
+*      being the original software.
+*   3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include <emmintrin.h>
+#include <math.h>
+#include "ddraw.h"
+
+namespace
+{
+	// Offsets of the vertex members, zero if the member is not present
+	struct LAYOUT
+	{
+		DWORD Stride;
+		DWORD Normal;
+		DWORD Diffuse;
+		DWORD Specular;
+		DWORD Tex;
+		DWORD TexCount;
+	};
+
+	struct COLOR
+	{
+		float r, g, b, a;
+	};
+
+	// Light converted to view space
+	struct VIEWLIGHT
+	{
+		D3DLIGHTTYPE Type;
+		COLOR Diffuse;
+		COLOR Specular;
+		COLOR Ambient;
+		float Position[3];
+		float Direction[3];		// Normalized, points from the vertex to the light for directional lights
+		float Range;
+		float Falloff;
+		float Attenuation0;
+		float Attenuation1;
+		float Attenuation2;
+		float CosTheta;
+		float CosPhi;
+	};
+
+	LAYOUT GetLayout(DWORD FVF)
+	{
+		LAYOUT Layout = {};
+		DWORD Offset = ((FVF & D3DFVF_POSITION_MASK) == D3DFVF_XYZRHW) ? sizeof(float) * 4 : sizeof(float) * 3;
+		if (FVF & D3DFVF_RESERVED1)
+		{
+			Offset += sizeof(DWORD);
+		}
+		if (FVF & D3DFVF_NORMAL)
+		{
+			Layout.Normal = Offset;
+			Offset += sizeof(float) * 3;
+		}
+		if (FVF & D3DFVF_DIFFUSE)
+		{
+			Layout.Diffuse = Offset;
+			Offset += sizeof(D3DCOLOR);
+		}
+		if (FVF & D3DFVF_SPECULAR)
+		{
+			Layout.Specular = Offset;
+			Offset += sizeof(D3DCOLOR);
+		}
+		Layout.TexCount = (FVF & D3DFVF_TEXCOUNT_MASK) >> D3DFVF_TEXCOUNT_SHIFT;
+		Layout.Tex = Offset;
+		Layout.Stride = Offset + Layout.TexCount * sizeof(float) * 2;
+		return Layout;
+	}
+
+	void MultiplyMatrix(D3DMATRIX& Out, const D3DMATRIX& a, const D3DMATRIX& b)
+	{
+		D3DMATRIX Result;
+		for (int i = 0; i < 4; i++)
+		{
+			for (int j = 0; j < 4; j++)
+			{
+				Result.m[i][j] = a.m[i][0] * b.m[0][j] + a.m[i][1] * b.m[1][j] + a.m[i][2] * b.m[2][j] + a.m[i][3] * b.m[3][j];
+			}
+		}
+		Out = Result;
+	}
+
+	// Inverse transpose of the upper 3x3, used to transform normals
+	void GetNormalMatrix(float Out[3][3], const D3DMATRIX& m)
+	{
+		const float c00 = m._22 * m._33 - m._23 * m._32;
+		const float c01 = m._23 * m._31 - m._21 * m._33;
+		const float c02 = m._21 * m._32 - m._22 * m._31;
+		const float Det = m._11 * c00 + m._12 * c01 + m._13 * c02;
+		const float InvDet = (Det != 0.0f) ? 1.0f / Det : 0.0f;
+
+		Out[0][0] = c00 * InvDet;
+		Out[0][1] = c01 * InvDet;
+		Out[0][2] = c02 * InvDet;
+		Out[1][0] = (m._13 * m._32 - m._12 * m._33) * InvDet;
+		Out[1][1] = (m._11 * m._33 - m._13 * m._31) * InvDet;
+		Out[1][2] = (m._12 * m._31 - m._11 * m._32) * InvDet;
+		Out[2][0] = (m._12 * m._23 - m._13 * m._22) * InvDet;
+		Out[2][1] = (m._13 * m._21 - m._11 * m._23) * InvDet;
+		Out[2][2] = (m._11 * m._22 - m._12 * m._21) * InvDet;
+	}
+
+	void Normalize(float v[3])
+	{
+		const float Length = sqrtf(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+		if (Length > 0.0f)
+		{
+			v[0] /= Length;
+			v[1] /= Length;
+			v[2] /= Length;
+		}
+	}
+
+	inline float Dot(const float a[3], const float b[3])
+	{
+		return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+	}
+
+	inline COLOR ToColor(const D3DCOLORVALUE& Color)
+	{
+		return { Color.r, Color.g, Color.b, Color.a };
+	}
+
+	inline COLOR ToColor(D3DCOLOR Color)
+	{
+		constexpr float Scale = 1.0f / 255.0f;
+		return { ((Color >> 16) & 0xFF) * Scale, ((Color >> 8) & 0xFF) * Scale, (Color & 0xFF) * Scale, (Color >> 24) * Scale };
+	}
+
+	inline DWORD ToByte(float Value)
+	{
+		return (Value <= 0.0f) ? 0 : (Value >= 1.0f) ? 255 : (DWORD)(Value * 255.0f + 0.5f);
+	}
+
+	inline D3DCOLOR ToD3DColor(const COLOR& Color)
+	{
+		return (ToByte(Color.a) << 24) | (ToByte(Color.r) << 16) | (ToByte(Color.g) << 8) | ToByte(Color.b);
+	}
+
+	// Picks the material or the vertex color based on the material source render state
+	inline COLOR GetMaterialColor(DWORD Source, const D3DCOLORVALUE& Material, const BYTE* pVertex, const LAYOUT& Src)
+	{
+		if (Source == D3DMCS_COLOR1 && Src.Diffuse)
+		{
+			return ToColor(*(const D3DCOLOR*)(pVertex + Src.Diffuse));
+		}
+		if (Source == D3DMCS_COLOR2 && Src.Specular)
+		{
+			return ToColor(*(const D3DCOLOR*)(pVertex + Src.Specular));
+		}
+		return ToColor(Material);
+	}
+
+	void LightVertex(D3DCOLOR& Diffuse, D3DCOLOR& Specular, const BYTE* pVertex, const LAYOUT& Src, const D3DMATRIX& WorldView, const float NormalMatrix[3][3],
+		const VIEWLIGHT* Lights, DWORD LightCount, const COLOR& GlobalAmbient, const VertexPipeline::STATE& State)
+	{
+		const float* pPos = (const float*)pVertex;
+		float Position[3], Normal[3] = {};
+		for (int i = 0; i < 3; i++)
+		{
+			Position[i] = pPos[0] * WorldView.m[0][i] + pPos[1] * WorldView.m[1][i] + pPos[2] * WorldView.m[2][i] + WorldView.m[3][i];
+		}
+		if (Src.Normal)
+		{
+			const float* pNormal = (const float*)(pVertex + Src.Normal);
+			for (int i = 0; i < 3; i++)
+			{
+				Normal[i] = pNormal[0] * NormalMatrix[0][i] + pNormal[1] * NormalMatrix[1][i] + pNormal[2] * NormalMatrix[2][i];
+			}
+			if (State.NormalizeNormals)
+			{
+				Normalize(Normal);
+			}
+		}
+
+		// The viewer is at the origin of view space, or infinitely far along the negative z axis
+		float Viewer[3] = { 0.0f, 0.0f, -1.0f };
+		if (State.LocalViewer)
+		{
+			Viewer[0] = -Position[0];
+			Viewer[1] = -Position[1];
+			Viewer[2] = -Position[2];
+			Normalize(Viewer);
+		}
+
+		COLOR Ambient = {}, Diffuse9 = {}, Specular9 = {};
+		for (DWORD x = 0; x < LightCount; x++)
+		{
+			const VIEWLIGHT& Light = Lights[x];
+
+			float Dir[3];
+			float Scale = 1.0f;
+			if (Light.Type == D3DLIGHT_DIRECTIONAL)
+			{
+				Dir[0] = Light.Direction[0];
+				Dir[1] = Light.Direction[1];
+				Dir[2] = Light.Direction[2];
+			}
+			else
+			{
+				Dir[0] = Light.Position[0] - Position[0];
+				Dir[1] = Light.Position[1] - Position[1];
+				Dir[2] = Light.Position[2] - Position[2];
+				const float Distance = sqrtf(Dot(Dir, Dir));
+				if (Distance > Light.Range)
+				{
+					continue;
+				}
+				if (Distance > 0.0f)
+				{
+					Dir[0] /= Distance;
+					Dir[1] /= Distance;
+					Dir[2] /= Distance;
+				}
+				const float Attenuation = Light.Attenuation0 + Light.Attenuation1 * Distance + Light.Attenuation2 * Distance * Distance;
+				Scale = (Attenuation > 0.0f) ? 1.0f / Attenuation : 1.0f;
+
+				if (Light.Type == D3DLIGHT_SPOT)
+				{
+					const float Rho = -Dot(Dir, Light.Direction);
+					if (Rho <= Light.CosPhi)
+					{
+						continue;
+					}
+					if (Rho < Light.CosTheta)
+					{
+						const float Spot = (Rho - Light.CosPhi) / (Light.CosTheta - Light.CosPhi);
+						Scale *= (Light.Falloff == 1.0f) ? Spot : powf(Spot, Light.Falloff);
+					}
+				}
+			}
+
+			Ambient.r += Light.Ambient.r * Scale;
+			Ambient.g += Light.Ambient.g * Scale;
+			Ambient.b += Light.Ambient.b * Scale;
+
+			const float NdotL = Dot(Normal, Dir);
+			if (NdotL <= 0.0f)
+			{
+				continue;
+			}
+			Diffuse9.r += Light.Diffuse.r * NdotL * Scale;
+			Diffuse9.g += Light.Diffuse.g * NdotL * Scale;
+			Diffuse9.b += Light.Diffuse.b * NdotL * Scale;
+
+			if (State.SpecularEnable)
+			{
+				float Half[3] = { Dir[0] + Viewer[0], Dir[1] + Viewer[1], Dir[2] + Viewer[2] };
+				Normalize(Half);
+				const float NdotH = Dot(Normal, Half);
+				if (NdotH > 0.0f)
+				{
+					const float Factor = powf(NdotH, State.Material.Power) * Scale;
+					Specular9.r += Light.Specular.r * Factor;
+					Specular9.g += Light.Specular.g * Factor;
+					Specular9.b += Light.Specular.b * Factor;
+				}
+			}
+		}
+
+		const bool ColorVertex = (State.ColorVertex != FALSE);
+		const COLOR Ca = GetMaterialColor(ColorVertex ? State.AmbientSource : D3DMCS_MATERIAL, State.Material.Ambient, pVertex, Src);
+		const COLOR Cd = GetMaterialColor(ColorVertex ? State.DiffuseSource : D3DMCS_MATERIAL, State.Material.Diffuse, pVertex, Src);
+		const COLOR Ce = GetMaterialColor(ColorVertex ? State.EmissiveSource : D3DMCS_MATERIAL, State.Material.Emissive, pVertex, Src);
+		const COLOR Cs = GetMaterialColor(ColorVertex ? State.SpecularSource : D3DMCS_MATERIAL, State.Material.Specular, pVertex, Src);
+
+		const COLOR OutDiffuse = {
+			Ce.r + Ca.r * (GlobalAmbient.r + Ambient.r) + Cd.r * Diffuse9.r,
+			Ce.g + Ca.g * (GlobalAmbient.g + Ambient.g) + Cd.g * Diffuse9.g,
+			Ce.b + Ca.b * (GlobalAmbient.b + Ambient.b) + Cd.b * Diffuse9.b,
+			Cd.a };
+		Diffuse = ToD3DColor(OutDiffuse);
+
+		// Specular alpha holds the fog factor, it is passed through from the vertex
+		const D3DCOLOR SpecularAlpha = Src.Specular ? (*(const D3DCOLOR*)(pVertex + Src.Specular) & 0xFF000000) : 0;
+		const COLOR OutSpecular = { Cs.r * Specular9.r, Cs.g * Specular9.g, Cs.b * Specular9.b, 0.0f };
+		Specular = (ToD3DColor(OutSpecular) & 0x00FFFFFF) | SpecularAlpha;
+	}
+}
+
+bool VertexPipeline::GetState(LPDIRECT3DDEVICE9 d3d9Device, DWORD LightIndexCount, STATE& State)
+{
+	memset(&State, 0, sizeof(STATE));
+
+	if (!d3d9Device)
+	{
+		return false;
+	}
+
+	// Check for state that is not handled
+	DWORD VertexBlend = D3DVBF_DISABLE, IndexedVertexBlend = FALSE, FogEnable = FALSE, FogVertexMode = D3DFOG_NONE;
+	d3d9Device->GetRenderState(D3DRS_VERTEXBLEND, &VertexBlend);
+	d3d9Device->GetRenderState(D3DRS_INDEXEDVERTEXBLENDENABLE, &IndexedVertexBlend);
+	d3d9Device->GetRenderState(D3DRS_FOGENABLE, &FogEnable);
+	d3d9Device->GetRenderState(D3DRS_FOGVERTEXMODE, &FogVertexMode);
+	if (VertexBlend != D3DVBF_DISABLE || IndexedVertexBlend || (FogEnable && FogVertexMode != D3DFOG_NONE))
+	{
+		return false;
+	}
+
+	if (FAILED(d3d9Device->GetTransform(D3DTS_WORLD, &State.World)) ||
+		FAILED(d3d9Device->GetTransform(D3DTS_VIEW, &State.View)) ||
+		FAILED(d3d9Device->GetTransform(D3DTS_PROJECTION, &State.Projection)) ||
+		FAILED(d3d9Device->GetViewport(&State.Viewport)) ||
+		FAILED(d3d9Device->GetMaterial(&State.Material)))
+	{
+		return false;
+	}
+
+	d3d9Device->GetRenderState(D3DRS_AMBIENT, &State.Ambient);
+	d3d9Device->GetRenderState(D3DRS_SPECULARENABLE, &State.SpecularEnable);
+	d3d9Device->GetRenderState(D3DRS_LOCALVIEWER, &State.LocalViewer);
+	d3d9Device->GetRenderState(D3DRS_NORMALIZENORMALS, &State.NormalizeNormals);
+	d3d9Device->GetRenderState(D3DRS_COLORVERTEX, &State.ColorVertex);
+	d3d9Device->GetRenderState(D3DRS_DIFFUSEMATERIALSOURCE, &State.DiffuseSource);
+	d3d9Device->GetRenderState(D3DRS_SPECULARMATERIALSOURCE, &State.SpecularSource);
+	d3d9Device->GetRenderState(D3DRS_AMBIENTMATERIALSOURCE, &State.AmbientSource);
+	d3d9Device->GetRenderState(D3DRS_EMISSIVEMATERIALSOURCE, &State.EmissiveSource);
+
+	for (DWORD x = 0; x < LightIndexCount && State.LightCount < MaxLights; x++)
+	{
+		BOOL Enable = FALSE;
+		if (SUCCEEDED(d3d9Device->GetLightEnable(x, &Enable)) && Enable &&
+			SUCCEEDED(d3d9Device->GetLight(x, &State.Lights[State.LightCount])))
+		{
+			State.LightCount++;
+		}
+	}
+
+	return true;
+}
+
+bool VertexPipeline::IsSupported(DWORD SrcFVF, DWORD DestFVF)
+{
+	const DWORD SupportedFVF = D3DFVF_POSITION_MASK | D3DFVF_RESERVED1 | D3DFVF_NORMAL | D3DFVF_DIFFUSE | D3DFVF_SPECULAR | D3DFVF_TEXCOUNT_MASK;
+
+	return (SrcFVF & D3DFVF_POSITION_MASK) == D3DFVF_XYZ && !(SrcFVF & ~SupportedFVF) &&
+		(DestFVF & D3DFVF_POSITION_MASK) == D3DFVF_XYZRHW && !(DestFVF & ~(SupportedFVF & ~(D3DFVF_RESERVED1 | D3DFVF_NORMAL)));
+}
+
+void VertexPipeline::ProcessVertices(BYTE* pDest, DWORD DestFVF, const BYTE* pSrc, DWORD SrcFVF, DWORD Count, DWORD dwVertexOp, DWORD dwFlags, const STATE& State)
+{
+	if (!pDest || !pSrc || !Count)
+	{
+		return;
+	}
+
+	const LAYOUT Src = GetLayout(SrcFVF);
+	const LAYOUT Dest = GetLayout(DestFVF);
+
+	D3DMATRIX WorldView, Matrix;
+	MultiplyMatrix(WorldView, State.World, State.View);
+	MultiplyMatrix(Matrix, WorldView, State.Projection);
+
+	const __m128 Row0 = _mm_loadu_ps(Matrix.m[0]);
+	const __m128 Row1 = _mm_loadu_ps(Matrix.m[1]);
+	const __m128 Row2 = _mm_loadu_ps(Matrix.m[2]);
+	const __m128 Row3 = _mm_loadu_ps(Matrix.m[3]);
+
+	// Maps clip space to screen space: screen = clip / w * Scale + Offset
+	const float HalfWidth = State.Viewport.Width * 0.5f;
+	const float HalfHeight = State.Viewport.Height * 0.5f;
+	const __m128 Scale = _mm_setr_ps(HalfWidth, -HalfHeight, State.Viewport.MaxZ - State.Viewport.MinZ, 0.0f);
+	const __m128 Offset = _mm_setr_ps(State.Viewport.X + HalfWidth, State.Viewport.Y + HalfHeight, State.Viewport.MinZ, 0.0f);
+	const __m128 One = _mm_set1_ps(1.0f);
+	const __m128 MaskW = _mm_castsi128_ps(_mm_setr_epi32(0, 0, 0, -1));
+
+	// Setup lighting
+	const bool Lighting = (dwVertexOp & D3DVOP_LIGHT) != 0;
+	float NormalMatrix[3][3] = {};
+	VIEWLIGHT Lights[MaxLights];
+	const COLOR GlobalAmbient = ToColor((D3DCOLOR)State.Ambient);
+	if (Lighting)
+	{
+		GetNormalMatrix(NormalMatrix, WorldView);
+
+		for (DWORD x = 0; x < State.LightCount; x++)
+		{
+			const D3DLIGHT9& Light = State.Lights[x];
+			VIEWLIGHT& ViewLight = Lights[x];
+			const D3DMATRIX& v = State.View;
+
+			ViewLight.Type = Light.Type;
+			ViewLight.Diffuse = ToColor(Light.Diffuse);
+			ViewLight.Specular = ToColor(Light.Specular);
+			ViewLight.Ambient = ToColor(Light.Ambient);
+			for (int i = 0; i < 3; i++)
+			{
+				ViewLight.Position[i] = Light.Position.x * v.m[0][i] + Light.Position.y * v.m[1][i] + Light.Position.z * v.m[2][i] + v.m[3][i];
+				ViewLight.Direction[i] = Light.Direction.x * v.m[0][i] + Light.Direction.y * v.m[1][i] + Light.Direction.z * v.m[2][i];
+			}
+			Normalize(ViewLight.Direction);
+			if (Light.Type == D3DLIGHT_DIRECTIONAL)
+			{
+				ViewLight.Direction[0] = -ViewLight.Direction[0];
+				ViewLight.Direction[1] = -ViewLight.Direction[1];
+				ViewLight.Direction[2] = -ViewLight.Direction[2];
+			}
+			ViewLight.Range = Light.Range;
+			ViewLight.Falloff = Light.Falloff;
+			ViewLight.Attenuation0 = Light.Attenuation0;
+			ViewLight.Attenuation1 = Light.Attenuation1;
+			ViewLight.Attenuation2 = Light.Attenuation2;
+			ViewLight.CosTheta = cosf(Light.Theta * 0.5f);
+			ViewLight.CosPhi = cosf(Light.Phi * 0.5f);
+		}
+	}
+
+	const bool CopyData = !(dwFlags & D3DPV_DONOTCOPYDATA);
+	const DWORD TexCount = min(Src.TexCount, Dest.TexCount);
+
+	for (DWORD x = 0; x < Count; x++, pDest += Dest.Stride, pSrc += Src.Stride)
+	{
+		// Transform position with the world, view and projection matrices, then apply the viewport
+		const float* pPos = (const float*)pSrc;
+		const __m128 Clip = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(pPos[0]), Row0), _mm_mul_ps(_mm_set1_ps(pPos[1]), Row1)),
+			_mm_add_ps(_mm_mul_ps(_mm_set1_ps(pPos[2]), Row2), Row3));
+		const __m128 Rhw = _mm_div_ps(One, _mm_shuffle_ps(Clip, Clip, _MM_SHUFFLE(3, 3, 3, 3)));
+		const __m128 Screen = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(Clip, Rhw), Scale), Offset);
+		_mm_storeu_ps((float*)pDest, _mm_or_ps(_mm_andnot_ps(MaskW, Screen), _mm_and_ps(MaskW, Rhw)));
+
+		// Colors
+		if (Lighting && (Dest.Diffuse || Dest.Specular))
+		{
+			D3DCOLOR Diffuse, Specular;
+			LightVertex(Diffuse, Specular, pSrc, Src, WorldView, NormalMatrix, Lights, State.LightCount, GlobalAmbient, State);
+			if (Dest.Diffuse)
+			{
+				*(D3DCOLOR*)(pDest + Dest.Diffuse) = Diffuse;
+			}
+			if (Dest.Specular)
+			{
+				*(D3DCOLOR*)(pDest + Dest.Specular) = Specular;
+			}
+		}
+		else if (CopyData)
+		{
+			if (Dest.Diffuse)
+			{
+				*(D3DCOLOR*)(pDest + Dest.Diffuse) = Src.Diffuse ? *(const D3DCOLOR*)(pSrc + Src.Diffuse) : 0xFFFFFFFF;
+			}
+			if (Dest.Specular)
+			{
+				*(D3DCOLOR*)(pDest + Dest.Specular) = Src.Specular ? *(const D3DCOLOR*)(pSrc + Src.Specular) : 0;
+			}
+		}
+
+		// Texture coordinates
+		if (CopyData && Dest.TexCount)
+		{
+			memcpy(pDest + Dest.Tex, pSrc + Src.Tex, TexCount * sizeof(float) * 2);
+			memset(pDest + Dest.Tex + TexCount * sizeof(float) * 2, 0, (Dest.TexCount - TexCount) * sizeof(float) * 2);
+		}
+	}
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <ddraw.h>
+
+namespace VertexPipeline
+{
+	static constexpr DWORD MaxLights = 8;
+
+	// Snapshot of the fixed function state that affects transform and lighting
+	// Compared with memcmp by the ProcessVertices cache, so it is cleared before being filled
+	struct STATE
+	{
+		D3DMATRIX World;
+		D3DMATRIX View;
+		D3DMATRIX Projection;
+		D3DVIEWPORT9 Viewport;
+		D3DMATERIAL9 Material;
+		DWORD Ambient;
+		DWORD SpecularEnable;
+		DWORD LocalViewer;
+		DWORD NormalizeNormals;
+		DWORD ColorVertex;
+		DWORD DiffuseSource;
+		DWORD SpecularSource;
+		DWORD AmbientSource;
+		DWORD EmissiveSource;
+		DWORD LightCount;
+		D3DLIGHT9 Lights[MaxLights];
+	};
+
+	// Reads the state from the device, lights are searched up to LightIndexCount
+	// Returns false if the device uses state that the software pipeline does not handle, such as vertex blending or vertex fog
+	bool GetState(LPDIRECT3DDEVICE9 d3d9Device, DWORD LightIndexCount, STATE& State);
+
+	// Source vertices must be untransformed (D3DFVF_XYZ) and destination vertices transformed (D3DFVF_XYZRHW)
+	// Texture coordinates must be two dimensional, D3DFVF_RESERVED1 is skipped so that D3DFVF_LVERTEX can be used as a source
+	bool IsSupported(DWORD SrcFVF, DWORD DestFVF);
+
+	// Transforms and optionally lights (D3DVOP_LIGHT) Count vertices
+	// Without D3DPV_DONOTCOPYDATA colors and texture coordinates that are not lit are copied or set to their default
+	void ProcessVertices(BYTE* pDest, DWORD DestFVF, const BYTE* pSrc, DWORD SrcFVF, DWORD Count, DWORD dwVertexOp, DWORD dwFlags, const STATE& State);
+}
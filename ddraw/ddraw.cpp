@@ -921,3 +921,9 @@ HRESULT DdrawWrapper::ReleaseCriticalSection()
 	}
 	return DDERR_UNSUPPORTED;
 }
+
+// Used by worker threads that must not block while the ddraw thread waits for them
+bool DdrawWrapper::TryCriticalSection()
+{
+	return IsInitialized && TryEnterCriticalSection(&ddcs);
+}
@@ -101,6 +101,7 @@ namespace DdrawWrapper
 	REFIID ConvertREFIID(REFIID riid);
 	HRESULT SetCriticalSection();
 	HRESULT ReleaseCriticalSection();
+	bool TryCriticalSection();
 	HRESULT ProxyQueryInterface(LPVOID ProxyInterface, REFIID CalledID, LPVOID * ppvObj, REFIID CallerID);
 	void WINAPI genericQueryInterface(REFIID riid, LPVOID *ppvObj);
 }
@@ -162,6 +163,12 @@ using namespace DdrawWrapper;
 #include "IDirect3DTypes.h"
 // DirectDraw Helpers
 #include "IDirectDrawTypes.h"
+#include "Blitter.h"
+#include "DirtyTracker.h"
+#include "DrawBatch.h"
+#include "PixelConvert.h"
+#include "VertexConvert.h"
+#include "VertexPipeline.h"
 // Direct3D Interfaces
 #include "IDirect3DX.h"
 #include "IDirect3DDeviceX.h"
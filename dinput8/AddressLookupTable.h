@@ -2,6 +2,7 @@
 
 #include <unordered_map>
 #include <algorithm>
+#include "Utils\ScopedLock.h"
 
 constexpr UINT MaxIndex = 6;
 
@@ -44,12 +45,18 @@ public:
 			return nullptr;
 		}
 
-		constexpr UINT CacheIndex = AddressCacheIndex<T>::CacheIndex;
-		auto it = g_map[CacheIndex].find(Proxy);
+		T *Wrapper = FindWrapper<T>(Proxy);
+		if (Wrapper)
+		{
+			return Wrapper;
+		}
 
-		if (it != std::end(g_map[CacheIndex]))
+		// Check again while holding the create lock, another thread may have wrapped the proxy in the meantime
+		Utils::ScopedCriticalSection Lock(CreateLock);
+		Wrapper = FindWrapper<T>(Proxy);
+		if (Wrapper)
 		{
-			return static_cast<T *>(it->second);
+			return Wrapper;
 		}
 
 		return new T(static_cast<T *>(Proxy));
@@ -61,7 +68,22 @@ public:
 		constexpr UINT CacheIndex = AddressCacheIndex<T>::CacheIndex;
 		if (Wrapper && Proxy)
 		{
+			Utils::ScopedExclusiveLock Lock(g_lock[CacheIndex]);
+
+			// Remove stale entries so both maps stay one-to-one
+			auto it = g_map[CacheIndex].find(Proxy);
+			if (it != std::end(g_map[CacheIndex]))
+			{
+				g_reverse[CacheIndex].erase(it->second);
+			}
+			auto rit = g_reverse[CacheIndex].find(Wrapper);
+			if (rit != std::end(g_reverse[CacheIndex]))
+			{
+				g_map[CacheIndex].erase(rit->second);
+			}
+
 			g_map[CacheIndex][Proxy] = Wrapper;
+			g_reverse[CacheIndex][Wrapper] = Proxy;
 		}
 	}
 
@@ -74,19 +96,38 @@ public:
 		}
 
 		constexpr UINT CacheIndex = AddressCacheIndex<T>::CacheIndex;
-		auto it = std::find_if(g_map[CacheIndex].begin(), g_map[CacheIndex].end(),
-			[=](auto Map) -> bool { return Map.second == Wrapper; });
+		Utils::ScopedExclusiveLock Lock(g_lock[CacheIndex]);
+		auto it = g_reverse[CacheIndex].find(Wrapper);
 
-		if (it != std::end(g_map[CacheIndex]))
+		if (it != std::end(g_reverse[CacheIndex]))
 		{
-			it = g_map[CacheIndex].erase(it);
+			g_map[CacheIndex].erase(it->second);
+			g_reverse[CacheIndex].erase(it);
 		}
 	}
 
 private:
+	template <typename T>
+	T *FindWrapper(void *Proxy)
+	{
+		constexpr UINT CacheIndex = AddressCacheIndex<T>::CacheIndex;
+		Utils::ScopedSharedLock Lock(g_lock[CacheIndex]);
+		auto it = g_map[CacheIndex].find(Proxy);
+
+		if (it != std::end(g_map[CacheIndex]))
+		{
+			return static_cast<T *>(it->second);
+		}
+
+		return nullptr;
+	}
+
 	bool ConstructorFlag = false;
 	D *unused = nullptr;
 	std::unordered_map<void*, class AddressLookupTableDinput8Object*> g_map[MaxIndex];
+	std::unordered_map<class AddressLookupTableDinput8Object*, void*> g_reverse[MaxIndex];
+	SRWLOCK g_lock[MaxIndex] = {};			// Guards g_map and g_reverse, each cache index has its own lock
+	Utils::CriticalSection CreateLock;		// Recursive because wrapper constructors can create other wrappers
 };
 
 class AddressLookupTableDinput8Object
@@ -15,8 +15,9 @@
 */
 
 #include "dsound.h"
+#include <deque>
 
-DWORD WINAPI ResetPending(LPVOID pvParam);
+void ResetPending(AUDIOCLIP& AudioClip);
 
 HRESULT m_IDirectSoundBuffer8::QueryInterface(REFIID riid, LPVOID * ppvObj)
 {
@@ -57,9 +58,9 @@ ULONG m_IDirectSoundBuffer8::Release()
 {
 	Logging::LogDebug() << __FUNCTION__ << " (" << this << ")";
 
-	if (CheckThreadRunning())
+	if (CheckStopPending())
 	{
-		StopThread();
+		FlushPendingStop();
 	}
 
 	ULONG x = ProxyInterface->Release();
@@ -194,16 +195,10 @@ HRESULT m_IDirectSoundBuffer8::Play(DWORD dwReserved1, DWORD dwPriority, DWORD d
 {
 	Logging::LogDebug() << __FUNCTION__ << " (" << this << ")";
 
-	if (CheckThreadRunning())
+	if (CheckStopPending())
 	{
-		// Stop thread
-		StopThread();
-
-		// Stop audio
-		ProxyInterface->Stop();
-
-		// Reset volume
-		ProxyInterface->SetVolume(AudioClip.CurrentVolume);
+		// Stop audio and reset volume
+		FlushPendingStop();
 	}
 
 	return ProxyInterface->Play(dwReserved1, dwPriority, dwFlags);
@@ -289,17 +284,13 @@ HRESULT m_IDirectSoundBuffer8::Stop()
 
 	if (Config.AudioClipDetection)
 	{
-		if (CheckThreadRunning())
-		{
-			return DS_OK;
-		}
+		bool StopPending = false;
 
 		EnterCriticalSection(&AudioClip.dics);
 
 		DWORD dwStatus = 0;
-		ProxyInterface->GetStatus(&dwStatus);
 
-		if (!AudioClip.ds_ThreadID && (dwStatus & DSBSTATUS_PLAYING))
+		if (!AudioClip.PendingStop && SUCCEEDED(ProxyInterface->GetStatus(&dwStatus)) && (dwStatus & DSBSTATUS_PLAYING))
 		{
 			// Set pending stop
 			AudioClip.PendingStop = true;
@@ -310,16 +301,17 @@ HRESULT m_IDirectSoundBuffer8::Stop()
 			// Lower volume
 			ProxyInterface->SetVolume(DSBVOLUME_MIN);
 
-			// Start thread
-			if (CreateThread(nullptr, 0, ResetPending, &AudioClip, 0, &AudioClip.ds_ThreadID) == nullptr || !AudioClip.ds_ThreadID)
-			{
-				AudioClip.PendingStop = false;
-				AudioClip.ds_ThreadID = 0;
-			}
+			StopPending = true;
 		}
 
 		LeaveCriticalSection(&AudioClip.dics);
 
+		// Schedule the stop, the scheduler lock must not be taken while holding the buffer lock
+		if (StopPending && !AudioClipScheduler::Add(AudioClip))
+		{
+			ResetPending(AudioClip);
+		}
+
 		// Return
 		return DS_OK;
 	}
@@ -370,72 +362,159 @@ HRESULT m_IDirectSoundBuffer8::GetObjectInPath(_In_ REFGUID rguidObject, DWORD d
 }
 
 // Helper functions
-bool m_IDirectSoundBuffer8::CheckThreadRunning()
+bool m_IDirectSoundBuffer8::CheckStopPending()
 {
-	bool ThreadRunning = false;
+	if (!Config.AudioClipDetection)
+	{
+		return false;
+	}
 
 	EnterCriticalSection(&AudioClip.dics);
 
-	if (AudioClip.ds_ThreadID)
-	{
-		ThreadRunning = true;
-	}
+	bool StopPending = AudioClip.PendingStop;
 
 	LeaveCriticalSection(&AudioClip.dics);
 
-	return ThreadRunning;
+	return StopPending;
 }
 
-void m_IDirectSoundBuffer8::StopThread()
+void m_IDirectSoundBuffer8::FlushPendingStop()
 {
-	// Trigger thread
-	SetEvent(AudioClip.hTriggerEvent);
+	// Remove from scheduler and complete the stop now
+	AudioClipScheduler::Remove(AudioClip);
 
-	// Wiat for thread to exit
-	bool flag = false;
-	do {
+	ResetPending(AudioClip);
+}
 
-		Sleep(0);
+void ResetPending(AUDIOCLIP& AudioClip)
+{
+	EnterCriticalSection(&AudioClip.dics);
 
-		EnterCriticalSection(&AudioClip.dics);
+	if (AudioClip.PendingStop && AudioClip.ProxyInterface)
+	{
+		// Stop
+		AudioClip.ProxyInterface->Stop();
 
-		flag = (AudioClip.ds_ThreadID != 0);
+		// Reset volume
+		AudioClip.ProxyInterface->SetVolume(AudioClip.CurrentVolume);
+	}
 
-		LeaveCriticalSection(&AudioClip.dics);
+	// Reset pending stop
+	AudioClip.PendingStop = false;
 
-	} while (flag);
+	LeaveCriticalSection(&AudioClip.dics);
 }
 
-DWORD WINAPI ResetPending(LPVOID pvParam)
+namespace AudioClipScheduler
 {
-	if (!pvParam)
+	struct SCHEDULER
 	{
-		return S_FALSE;
+		CRITICAL_SECTION cs = {};
+		std::deque<AUDIOCLIP*> Queue;		// All stops use the same delay so the queue stays sorted by due time
+		bool IsThreadRunning = false;
+
+		SCHEDULER() { InitializeCriticalSection(&cs); }
+		~SCHEDULER() { DeleteCriticalSection(&cs); }
+	};
+
+	SCHEDULER& GetScheduler()
+	{
+		static SCHEDULER Scheduler;
+		return Scheduler;
 	}
 
-	AUDIOCLIP &AudioClip = *(AUDIOCLIP*)pvParam;
+	DWORD WINAPI SchedulerThread(LPVOID)
+	{
+		SCHEDULER& Scheduler = GetScheduler();
 
-	// Add slight delay
-	WaitForSingleObject(AudioClip.hTriggerEvent, ((Config.AudioFadeOutDelayMS) ? Config.AudioFadeOutDelayMS : 20));
+		EnterCriticalSection(&Scheduler.cs);
 
-	EnterCriticalSection(&AudioClip.dics);
+		while (!Scheduler.Queue.empty())
+		{
+			AUDIOCLIP& AudioClip = *Scheduler.Queue.front();
 
-	if (AudioClip.PendingStop && AudioClip.ProxyInterface)
+			ULONGLONG CurrentTime = GetTickCount64();
+
+			if (AudioClip.DueTime > CurrentTime)
+			{
+				DWORD WaitTime = (DWORD)(AudioClip.DueTime - CurrentTime);
+
+				LeaveCriticalSection(&Scheduler.cs);
+
+				Sleep(WaitTime);
+
+				EnterCriticalSection(&Scheduler.cs);
+
+				continue;
+			}
+
+			Scheduler.Queue.pop_front();
+			AudioClip.IsScheduled = false;
+
+			// Completed while holding the scheduler lock so that buffers can't be deleted during the stop
+			ResetPending(AudioClip);
+		}
+
+		// Thread exits when there is nothing left to do
+		Scheduler.IsThreadRunning = false;
+
+		LeaveCriticalSection(&Scheduler.cs);
+
+		return S_OK;
+	}
+
+	bool Add(AUDIOCLIP& AudioClip)
 	{
-		// Stop
-		AudioClip.ProxyInterface->Stop();
+		SCHEDULER& Scheduler = GetScheduler();
 
-		// Reset volume
-		AudioClip.ProxyInterface->SetVolume(AudioClip.CurrentVolume);
+		EnterCriticalSection(&Scheduler.cs);
+
+		if (AudioClip.IsScheduled)
+		{
+			Scheduler.Queue.erase(std::find(Scheduler.Queue.begin(), Scheduler.Queue.end(), &AudioClip));
+		}
+
+		AudioClip.DueTime = GetTickCount64() + ((Config.AudioFadeOutDelayMS) ? Config.AudioFadeOutDelayMS : 20);
+		AudioClip.IsScheduled = true;
+		Scheduler.Queue.push_back(&AudioClip);
+
+		// Start thread
+		if (!Scheduler.IsThreadRunning)
+		{
+			HANDLE hThread = CreateThread(nullptr, 0, SchedulerThread, nullptr, 0, nullptr);
+
+			if (hThread)
+			{
+				CloseHandle(hThread);
+
+				Scheduler.IsThreadRunning = true;
+			}
+			else
+			{
+				Scheduler.Queue.pop_back();
+				AudioClip.IsScheduled = false;
+			}
+		}
+
+		bool IsScheduled = AudioClip.IsScheduled;
+
+		LeaveCriticalSection(&Scheduler.cs);
+
+		return IsScheduled;
 	}
 
-	// Reset pending stop
-	AudioClip.PendingStop = false;
+	void Remove(AUDIOCLIP& AudioClip)
+	{
+		SCHEDULER& Scheduler = GetScheduler();
 
-	// Reset thread ID
-	AudioClip.ds_ThreadID = 0;
+		EnterCriticalSection(&Scheduler.cs);
 
-	LeaveCriticalSection(&AudioClip.dics);
+		if (AudioClip.IsScheduled)
+		{
+			Scheduler.Queue.erase(std::find(Scheduler.Queue.begin(), Scheduler.Queue.end(), &AudioClip));
+			AudioClip.IsScheduled = false;
+		}
 
-	return S_OK;
+		LeaveCriticalSection(&Scheduler.cs);
+	}
 }
@@ -2,14 +2,23 @@
 
 struct AUDIOCLIP
 {
-	DWORD ds_ThreadID = 0;
 	CRITICAL_SECTION dics = {};
 	LPDIRECTSOUNDBUFFER8 ProxyInterface = nullptr;
 	LONG CurrentVolume = 0;
-	HANDLE hTriggerEvent = nullptr;
 	bool PendingStop = false;
+
+	// Used by the scheduler, protected by the scheduler lock
+	ULONGLONG DueTime = 0;
+	bool IsScheduled = false;
 };
 
+// Single thread that completes the pending stops of all buffers
+namespace AudioClipScheduler
+{
+	bool Add(AUDIOCLIP& AudioClip);
+	void Remove(AUDIOCLIP& AudioClip);
+}
+
 class m_IDirectSoundBuffer8 : public IDirectSoundBuffer8, public AddressLookupTableDsoundObject
 {
 private:
@@ -33,9 +42,6 @@ public:
 
 		// Initialize Critical Section
 		InitializeCriticalSection(&AudioClip.dics);
-		char EventName[MAX_PATH];
-		sprintf_s(EventName, MAX_PATH, "Local\\SH2EAudioClipDetection-%u", (DWORD)this);
-		AudioClip.hTriggerEvent = CreateEvent(nullptr, FALSE, FALSE, EventName);
 
 		ProxyAddressLookupTableDsound.SaveAddress(this, ProxyInterface);
 	}
@@ -43,9 +49,14 @@ public:
 	{
 		LOG_LIMIT(3, __FUNCTION__ << " (" << this << ")" << " deleting interface!");
 
+		// Make sure the scheduler no longer references this buffer
+		if (Config.AudioClipDetection)
+		{
+			AudioClipScheduler::Remove(AudioClip);
+		}
+
 		// Delete Critical Section
 		DeleteCriticalSection(&AudioClip.dics);
-		CloseHandle(AudioClip.hTriggerEvent);
 
 		ProxyAddressLookupTableDsound.DeleteAddress(this);
 	}
@@ -84,8 +95,8 @@ public:
 	STDMETHOD(GetObjectInPath)(THIS_ _In_ REFGUID rguidObject, DWORD dwIndex, _In_ REFGUID rguidInterface, _Outptr_ LPVOID *ppObject);
 
 	// Helper functions
-	bool CheckThreadRunning();
-	void StopThread();
+	bool CheckStopPending();
+	void FlushPendingStop();
 	LPDIRECTSOUNDBUFFER8 GetProxyInterface() { return ProxyInterface; }
 	bool GetPrimaryBuffer()
 	{